@@ -0,0 +1,314 @@
+/*
+ * GraphLCD driver library
+ *
+ * async.c  -  asynchronous refresh of a driver
+ *             The display is updated by an own thread, frames are
+ *             handed over through a triple buffer.
+ *
+ * This file is released under the GNU General Public License. Refer
+ * to the COPYING file distributed with this package.
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <syslog.h>
+
+#include "common.h"
+#include "config.h"
+#include "async.h"
+
+
+namespace GLCD
+{
+
+cDriverAsync::cDriverAsync(cDriver * Driver, cDriverConfig * config)
+:   cDriver(config),
+    mDriver(Driver),
+    mBack(0),
+    mShared(1),
+    mFront(2),
+    mPendingAll(false),
+    mRunning(false),
+    mFrameCount(0),
+    mWrittenCount(0),
+    mDroppedCount(0),
+    mCoalescedCount(0)
+{
+    for (int i = 0; i < 3; i++)
+    {
+        mFrames[i].data = NULL;
+        mFrames[i].refreshAll = false;
+    }
+    pthread_mutex_init(&mDriverMutex, NULL);
+}
+
+cDriverAsync::~cDriverAsync()
+{
+    if (mRunning)
+        DeInit();
+    FreeFrames();
+    pthread_mutex_destroy(&mDriverMutex);
+    delete mDriver;
+}
+
+void cDriverAsync::FreeFrames(void)
+{
+    for (int i = 0; i < 3; i++)
+    {
+        delete[] mFrames[i].data;
+        mFrames[i].data = NULL;
+    }
+}
+
+int cDriverAsync::Init()
+{
+    int ret = mDriver->Init();
+    if (ret != 0)
+        return ret;
+
+    width = mDriver->Width();
+    height = mDriver->Height();
+    bgcol = mDriver->GetBackgroundColor();
+    fgcol = mDriver->GetForegroundColor();
+
+    FreeFrames();
+    for (int i = 0; i < 3; i++)
+    {
+        mFrames[i].data = new uint32_t[width * height];
+        for (int j = 0; j < width * height; j++)
+            mFrames[i].data[j] = bgcol;
+        mFrames[i].area = tRect();
+        mFrames[i].refreshAll = false;
+    }
+    mBack = 0;
+    mShared = 1;
+    mFront = 2;
+    mPending = tRect();
+    mPendingAll = false;
+
+    sem_init(&mWakeup, 0, 0);
+    mRunning = true;
+    if (pthread_create(&mThread, NULL, RefreshThread, (void *) this) != 0)
+    {
+        syslog(LOG_ERR, "%s: error creating refresh thread.\n", config->name.c_str());
+        mRunning = false;
+        sem_destroy(&mWakeup);
+        mDriver->DeInit();
+        return -1;
+    }
+    return 0;
+}
+
+int cDriverAsync::DeInit()
+{
+    if (mRunning)
+    {
+        // the thread writes a frame that is still pending before it ends
+        mRunning = false;
+        sem_post(&mWakeup);
+        pthread_join(mThread, NULL);
+        sem_destroy(&mWakeup);
+    }
+    FreeFrames();
+    return mDriver->DeInit();
+}
+
+void * cDriverAsync::RefreshThread(void * Driver)
+{
+    ((cDriverAsync *) Driver)->Action();
+    return NULL;
+}
+
+void cDriverAsync::Action(void)
+{
+    while (true)
+    {
+        while (sem_wait(&mWakeup) != 0 && errno == EINTR)
+            ;
+
+        // read before looking for a frame: frames published before DeInit() are still written
+        bool running = mRunning;
+
+        if (mShared.load() & kDirty)
+        {
+            // take the latest frame, give back the one written before
+            mFront = mShared.exchange(mFront) & ~kDirty;
+            const tFrame & frame = mFrames[mFront];
+
+            pthread_mutex_lock(&mDriverMutex);
+            if (!frame.area.IsEmpty())
+                mDriver->SetScreenRect(frame.data, width, frame.area.x1, frame.area.y1,
+                                       frame.area.Width(), frame.area.Height());
+            mDriver->Refresh(frame.refreshAll);
+            pthread_mutex_unlock(&mDriverMutex);
+            mWrittenCount++;
+        }
+
+        if (!running)
+            break;
+    }
+}
+
+void cDriverAsync::Clear()
+{
+    if (!mFrames[mBack].data)
+        return;
+
+    uint32_t * data = mFrames[mBack].data;
+    uint32_t color = GetBackgroundColor();
+    for (int i = 0; i < width * height; i++)
+        data[i] = color;
+    Mark(0, 0, width - 1, height - 1);
+}
+
+void cDriverAsync::SetPixel(int x, int y, uint32_t data)
+{
+    if (!mFrames[mBack].data || x < 0 || x >= width || y < 0 || y >= height)
+        return;
+
+    mFrames[mBack].data[y * width + x] = data;
+    Mark(x, y, x, y);
+}
+
+void cDriverAsync::SetScreenRect(const uint32_t * data, int stride, int x, int y, int w, int h)
+{
+    if (!data || !mFrames[mBack].data || !ClipScreenRect(x, y, w, h))
+        return;
+
+    uint32_t * dest = mFrames[mBack].data;
+    for (int yt = y; yt < y + h; yt++)
+        memcpy(dest + yt * width + x, data + yt * stride + x, w * sizeof(uint32_t));
+    Mark(x, y, x + w - 1, y + h - 1);
+}
+
+void cDriverAsync::SetScreen1BPP(const unsigned char * data, int wid, int hgt, int lineSize)
+{
+    int x = 0, y = 0;
+
+    if (!data || !mFrames[mBack].data || !ClipScreenRect(x, y, wid, hgt))
+        return;
+
+    // expanded into the frame row by row, the same colours as cDriver::SetScreen1BPP()
+    uint32_t * dest = mFrames[mBack].data;
+    for (int yt = 0; yt < hgt; yt++)
+    {
+        const unsigned char * line = data + yt * lineSize;
+        uint32_t * row = dest + yt * width;
+        for (int xt = 0; xt < wid; xt++)
+            row[xt] = (line[xt >> 3] & (0x80 >> (xt & 7))) ? GRAPHLCD_White : GRAPHLCD_Black;
+    }
+    Mark(0, 0, wid - 1, hgt - 1);
+}
+
+void cDriverAsync::Refresh(bool refreshAll)
+{
+    if (!mRunning)
+        return;
+
+    tFrame & back = mFrames[mBack];
+    if (back.area.IsEmpty() && !refreshAll)
+    {
+        mCoalescedCount++;
+        return;
+    }
+
+    // the frame has to contain all changes of frames the thread has possibly skipped
+    tRect changes = back.area;
+    back.area.Unite(mPending);
+    back.refreshAll = refreshAll || mPendingAll;
+
+    int published = mBack;
+    int previous = mShared.exchange(mBack | kDirty);
+    mFrameCount++;
+    if (previous & kDirty)
+    {
+        // the previous frame was not taken: its changes are still pending
+        mDroppedCount++;
+        mPending = back.area;
+        mPendingAll = back.refreshAll;
+    }
+    else
+    {
+        mPending = changes;
+        mPendingAll = refreshAll;
+    }
+    sem_post(&mWakeup);
+
+    // continue drawing on a copy of the published frame
+    mBack = previous & ~kDirty;
+    memcpy(mFrames[mBack].data, mFrames[published].data, width * height * sizeof(uint32_t));
+    mFrames[mBack].area = tRect();
+    mFrames[mBack].refreshAll = false;
+}
+
+void cDriverAsync::SetBrightness(unsigned int percent)
+{
+    pthread_mutex_lock(&mDriverMutex);
+    mDriver->SetBrightness(percent);
+    pthread_mutex_unlock(&mDriverMutex);
+}
+
+bool cDriverAsync::SetFeature(const std::string & Feature, int value)
+{
+    pthread_mutex_lock(&mDriverMutex);
+    bool ret = mDriver->SetFeature(Feature, value);
+    pthread_mutex_unlock(&mDriverMutex);
+    return ret;
+}
+
+cGLCDEvent * cDriverAsync::GetEvent(void)
+{
+    pthread_mutex_lock(&mDriverMutex);
+    cGLCDEvent * ev = mDriver->GetEvent();
+    pthread_mutex_unlock(&mDriverMutex);
+    return ev;
+}
+
+bool cDriverAsync::GetDriverFeature(const std::string & Feature, int & value)
+{
+    pthread_mutex_lock(&mDriverMutex);
+    bool ret = mDriver->GetFeature(Feature, value);
+    pthread_mutex_unlock(&mDriverMutex);
+    return ret;
+}
+
+bool cDriverAsync::GetIOStats(uint64_t & bytes, uint64_t & syscalls) const
+{
+    pthread_mutex_lock(&mDriverMutex);
+    bool ret = mDriver->GetIOStats(bytes, syscalls);
+    pthread_mutex_unlock(&mDriverMutex);
+    return ret;
+}
+
+bool cDriverAsync::GetStats(tDriverStats & stats) const
+{
+    pthread_mutex_lock(&mDriverMutex);
+    bool ret = mDriver->GetStats(stats);
+    pthread_mutex_unlock(&mDriverMutex);
+    return ret;
+}
+
+uint64_t cDriverAsync::GetForcedRefreshes(void) const
+{
+    pthread_mutex_lock(&mDriverMutex);
+    uint64_t ret = mDriver->GetForcedRefreshes();
+    pthread_mutex_unlock(&mDriverMutex);
+    return ret;
+}
+
+uint32_t cDriverAsync::GetDefaultBackgroundColor(void)
+{
+    return mDriver ? mDriver->GetBackgroundColor(true) : cDriver::GetDefaultBackgroundColor();
+}
+
+tDriverAsyncStats cDriverAsync::Stats(void) const
+{
+    tDriverAsyncStats stats;
+    stats.frames = mFrameCount;
+    stats.written = mWrittenCount;
+    stats.dropped = mDroppedCount;
+    stats.coalesced = mCoalescedCount;
+    return stats;
+}
+
+} // end of namespace
@@ -0,0 +1,107 @@
+/*
+ * GraphLCD driver library
+ *
+ * async.h  -  asynchronous refresh of a driver
+ *             The display is updated by an own thread, frames are
+ *             handed over through a triple buffer.
+ *
+ * This file is released under the GNU General Public License. Refer
+ * to the COPYING file distributed with this package.
+ */
+
+#ifndef _GLCDDRIVERS_ASYNC_H_
+#define _GLCDDRIVERS_ASYNC_H_
+
+#include <pthread.h>
+#include <semaphore.h>
+
+#include <atomic>
+
+#include "driver.h"
+
+
+namespace GLCD
+{
+
+class cDriverConfig;
+
+struct tDriverAsyncStats
+{
+    uint64_t frames;        // frames handed over by Refresh()
+    uint64_t written;       // frames written to the display
+    uint64_t dropped;       // frames replaced by a newer one before they were written
+    uint64_t coalesced;     // Refresh() calls without changes since the previous frame
+};
+
+// wraps a driver and runs its SetScreenRect() / Refresh() in an own thread.
+// drawing into the wrapper and Refresh() never wait for the display: Refresh() publishes
+// the current frame, the thread always writes the latest published frame and skips
+// the ones published while it was busy.
+class cDriverAsync : public cDriver
+{
+private:
+    // a frame and the area that changed since the last frame taken by the thread
+    struct tFrame
+    {
+        uint32_t * data;
+        tRect area;
+        bool refreshAll;
+    };
+
+    static const int kDirty = 4;    // flag in mShared: frame not yet taken by the thread
+
+    cDriver * mDriver;
+    tFrame mFrames[3];
+    int mBack;                      // frame drawn into by the caller
+    std::atomic<int> mShared;       // last published frame (| kDirty)
+    int mFront;                     // frame written by the thread
+    tRect mPending;                 // changes not guaranteed to be in a frame taken by the thread
+    bool mPendingAll;
+
+    pthread_t mThread;
+    mutable pthread_mutex_t mDriverMutex;   // serialises the access to mDriver
+    sem_t mWakeup;
+    std::atomic<bool> mRunning;
+
+    std::atomic<uint64_t> mFrameCount;
+    std::atomic<uint64_t> mWrittenCount;
+    std::atomic<uint64_t> mDroppedCount;
+    std::atomic<uint64_t> mCoalescedCount;
+
+    static void * RefreshThread(void * Driver);
+    void Action(void);
+    void Mark(int x1, int y1, int x2, int y2) { mFrames[mBack].area.Unite(tRect(x1, y1, x2, y2)); }
+    void FreeFrames(void);
+
+protected:
+    virtual bool GetDriverFeature(const std::string & Feature, int & value);
+    virtual uint32_t GetDefaultBackgroundColor(void);
+
+public:
+    // takes over the ownership of Driver
+    cDriverAsync(cDriver * Driver, cDriverConfig * config);
+    virtual ~cDriverAsync();
+
+    virtual int Init();
+    virtual int DeInit();
+
+    virtual void Clear();
+    virtual void SetPixel(int x, int y, uint32_t data);
+    virtual void SetScreenRect(const uint32_t *data, int stride, int x, int y, int w, int h);
+    virtual void SetScreen1BPP(const unsigned char *data, int width, int height, int lineSize);
+    virtual void Refresh(bool refreshAll = false);
+
+    virtual void SetBrightness(unsigned int percent);
+    virtual bool SetFeature(const std::string & Feature, int value);
+    virtual cGLCDEvent * GetEvent(void);
+    virtual bool GetStats(tDriverStats & stats) const;
+    virtual bool GetIOStats(uint64_t & bytes, uint64_t & syscalls) const;
+    virtual uint64_t GetForcedRefreshes(void) const;
+
+    cDriver * Driver(void) const { return mDriver; }
+    tDriverAsyncStats Stats(void) const;
+};
+
+} // end of namespace
+
+#endif
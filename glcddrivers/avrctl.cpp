@@ -230,16 +230,16 @@ void cDriverAvrCtl::Refresh(bool refreshAll)
     unsigned char data[16*num];
 
     if (CheckSetup() == 1)
-        refreshAll = true;
+        ForceRefreshAll(refreshAll);
 
     if (config->refreshDisplay > 0)
     {
         refreshCounter = (refreshCounter + 1) % config->refreshDisplay;
         if (!refreshAll && !refreshCounter)
-            refreshAll = true;
+            ForceRefreshAll(refreshAll);
     }
 
-    refreshAll = true;
+    ForceRefreshAll(refreshAll);
     if (refreshAll)
     {
         for (x = 0; x < kBufferWidth; x += num)
@@ -342,7 +342,7 @@ void cDriverAvrCtl::CmdDispSetBrightness(uint8_t percent)
 
 void cDriverAvrCtl::CmdDispSetColData(uint16_t column, uint16_t offset, uint16_t length, uint8_t * data)
 {
-    uint8_t cmd[2560];
+    uint8_t cmd[10];
 
     cmd[CMD_HDR_SYNC] = CMD_SYNC_SEND;
     cmd[CMD_HDR_COMMAND] = CMD_DISP_SET_COL_DATA;
@@ -354,9 +354,10 @@ void cDriverAvrCtl::CmdDispSetColData(uint16_t column, uint16_t offset, uint16_t
     cmd[CMD_DATA_START+3] = offset;
     cmd[CMD_DATA_START+4] = length >> 8;
     cmd[CMD_DATA_START+5] = length;
-    memcpy(&cmd[CMD_DATA_START+6], data, length);
 
-    port->WriteData(cmd, length+10);
+    // header and data leave in one write, the port buffers them
+    port->WriteData(cmd, 10);
+    port->WriteData(data, length);
     WaitForAck();
 }
 
@@ -373,4 +374,9 @@ void cDriverAvrCtl::CmdDispUpdate(void)
     WaitForAck();
 }
 
+bool cDriverAvrCtl::GetIOStats(uint64_t & bytes, uint64_t & syscalls) const
+{
+    return GetPortIOStats(port, bytes, syscalls);
+}
+
 }
@@ -457,7 +457,7 @@ void cDriverAX206DPF::Refresh(bool refreshAll)
 	short rect[4];
 
     if (CheckSetup() > 0)
-        refreshAll = true;
+        ForceRefreshAll(refreshAll);
     
     for (unsigned int di = 0; di < numdisplays; di++)
     {
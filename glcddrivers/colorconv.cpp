@@ -0,0 +1,703 @@
+/*
+ * GraphLCD driver library
+ *
+ * colorconv.c  -  conversion of ARGB pixels into native display formats
+ *                 Vectorised kernels (SSE2/AVX2/NEON) with a plain C
+ *                 fallback, selected at runtime.
+ *
+ * This file is released under the GNU General Public License. Refer
+ * to the COPYING file distributed with this package.
+ */
+
+#include <pthread.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CONV_X86
+#endif
+
+#if defined(__aarch64__) && defined(__ARM_NEON) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#include <arm_neon.h>
+#define CONV_NEON
+#endif
+
+#include "common.h"
+#include "colorconv.h"
+
+
+namespace GLCD
+{
+
+static const uint32_t kRGBMask = 0x00FFFFFF;
+
+// the vectorised kernels convert blocks of pixels and leave the remaining ones to the
+// C kernels. with kConvReverse the pixels from position i of dst on are taken from the
+// start of src.
+static inline const uint32_t * TailSrc(const uint32_t * src, int i, int flags)
+{
+    return (flags & kConvReverse) ? src : src + i;
+}
+
+//
+// C kernels
+//
+
+static inline uint32_t Luminance(uint32_t p)
+{
+    return (((p >> 16) & 0xFF) * 77 + ((p >> 8) & 0xFF) * 150 + (p & 0xFF) * 29) >> 8;
+}
+
+// pixel of src that goes to position i of dst
+static inline uint32_t SrcPixel(const uint32_t * src, int count, int i, int flags)
+{
+    uint32_t p = (flags & kConvReverse) ? src[count - 1 - i] : src[i];
+    return (flags & kConvInvert) ? p ^ kRGBMask : p;
+}
+
+static void RGB565_C(const uint32_t * src, uint16_t * dst, int count, int flags)
+{
+    for (int i = 0; i < count; i++)
+    {
+        uint32_t p = SrcPixel(src, count, i, flags);
+        uint16_t c;
+
+        if (flags & kConvSwapRB)
+            c = ((p << 8) & 0xF800) | ((p >> 5) & 0x07E0) | ((p >> 19) & 0x001F);
+        else
+            c = ((p >> 8) & 0xF800) | ((p >> 5) & 0x07E0) | ((p >> 3) & 0x001F);
+        if (flags & kConvByteSwap)
+            c = (c << 8) | (c >> 8);
+        dst[i] = c;
+    }
+}
+
+static void RGB888_C(const uint32_t * src, uint8_t * dst, int count, int flags)
+{
+    int first = (flags & kConvSwapRB) ? 0 : 16;
+
+    for (int i = 0; i < count; i++)
+    {
+        uint32_t p = SrcPixel(src, count, i, flags);
+
+        *dst++ = p >> first;
+        *dst++ = p >> 8;
+        *dst++ = p >> (16 - first);
+    }
+}
+
+static void Mono_C(const uint32_t * src, uint8_t * dst, int count, int threshold, int flags)
+{
+    uint8_t byte = 0;
+    int i;
+
+    for (i = 0; i < count; i++)
+    {
+        if ((int) Luminance(SrcPixel(src, count, i, flags)) >= threshold)
+            byte |= bitmask[i & 7];
+        if ((i & 7) == 7)
+        {
+            dst[i >> 3] = byte;
+            byte = 0;
+        }
+    }
+    if (i & 7)
+        dst[i >> 3] = byte;
+}
+
+static void Grey4_C(const uint32_t * src, uint8_t * dst, int count, int flags)
+{
+    for (int i = 0; i < count; i += 2)
+    {
+        uint8_t byte = (Luminance(SrcPixel(src, count, i, flags)) >> 4) << 4;
+
+        if (i + 1 < count)
+            byte |= Luminance(SrcPixel(src, count, i + 1, flags)) >> 4;
+        dst[i >> 1] = byte;
+    }
+}
+
+#ifdef CONV_X86
+
+#define TARGET_SSE2 __attribute__((target("sse2")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+
+//
+// SSE2 kernels, 4 pixels per vector
+//
+
+// 4 pixels from position i of dst on
+TARGET_SSE2 static inline __m128i Load_SSE2(const uint32_t * src, int count, int i, int flags, __m128i invert)
+{
+    __m128i v;
+
+    if (flags & kConvReverse)
+        v = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *) (src + count - i - 4)), _MM_SHUFFLE(0, 1, 2, 3));
+    else
+        v = _mm_loadu_si128((const __m128i *) (src + i));
+    return _mm_xor_si128(v, invert);
+}
+
+TARGET_SSE2 static inline __m128i Invert_SSE2(int flags)
+{
+    return _mm_set1_epi32((flags & kConvInvert) ? kRGBMask : 0);
+}
+
+// 5-6-5 value in each 32 bit lane, sign extended for _mm_packs_epi32()
+TARGET_SSE2 static inline __m128i RGB565_4_SSE2(__m128i v, bool swapRB)
+{
+    __m128i hi;
+    __m128i lo;
+    __m128i g = _mm_and_si128(_mm_srli_epi32(v, 5), _mm_set1_epi32(0x07E0));
+
+    if (swapRB)
+    {
+        hi = _mm_and_si128(_mm_slli_epi32(v, 8), _mm_set1_epi32(0xF800));
+        lo = _mm_and_si128(_mm_srli_epi32(v, 19), _mm_set1_epi32(0x001F));
+    }
+    else
+    {
+        hi = _mm_and_si128(_mm_srli_epi32(v, 8), _mm_set1_epi32(0xF800));
+        lo = _mm_and_si128(_mm_srli_epi32(v, 3), _mm_set1_epi32(0x001F));
+    }
+    __m128i c = _mm_or_si128(_mm_or_si128(hi, g), lo);
+    return _mm_srai_epi32(_mm_slli_epi32(c, 16), 16);
+}
+
+// luminance in each 32 bit lane. the products and their sum fit into 16 bits.
+TARGET_SSE2 static inline __m128i Luminance_SSE2(__m128i v)
+{
+    const __m128i mask = _mm_set1_epi32(0xFF);
+    __m128i r = _mm_and_si128(_mm_srli_epi32(v, 16), mask);
+    __m128i g = _mm_and_si128(_mm_srli_epi32(v, 8), mask);
+    __m128i b = _mm_and_si128(v, mask);
+
+    __m128i sum = _mm_add_epi32(_mm_mullo_epi16(r, _mm_set1_epi32(77)),
+                                _mm_mullo_epi16(g, _mm_set1_epi32(150)));
+    sum = _mm_add_epi32(sum, _mm_mullo_epi16(b, _mm_set1_epi32(29)));
+    return _mm_srli_epi32(sum, 8);
+}
+
+// luminance of 16 pixels from position i of dst on, one byte each
+TARGET_SSE2 static inline __m128i Luminance16_SSE2(const uint32_t * src, int count, int i, int flags, __m128i invert)
+{
+    __m128i l0 = Luminance_SSE2(Load_SSE2(src, count, i, flags, invert));
+    __m128i l1 = Luminance_SSE2(Load_SSE2(src, count, i + 4, flags, invert));
+    __m128i l2 = Luminance_SSE2(Load_SSE2(src, count, i + 8, flags, invert));
+    __m128i l3 = Luminance_SSE2(Load_SSE2(src, count, i + 12, flags, invert));
+
+    return _mm_packus_epi16(_mm_packs_epi32(l0, l1), _mm_packs_epi32(l2, l3));
+}
+
+TARGET_SSE2 static void RGB565_SSE2(const uint32_t * src, uint16_t * dst, int count, int flags)
+{
+    __m128i invert = Invert_SSE2(flags);
+    bool swapRB = flags & kConvSwapRB;
+    int i;
+
+    for (i = 0; i + 8 <= count; i += 8)
+    {
+        __m128i c = _mm_packs_epi32(RGB565_4_SSE2(Load_SSE2(src, count, i, flags, invert), swapRB),
+                                    RGB565_4_SSE2(Load_SSE2(src, count, i + 4, flags, invert), swapRB));
+        if (flags & kConvByteSwap)
+            c = _mm_or_si128(_mm_slli_epi16(c, 8), _mm_srli_epi16(c, 8));
+        _mm_storeu_si128((__m128i *) (dst + i), c);
+    }
+    RGB565_C(TailSrc(src, i, flags), dst + i, count - i, flags);
+}
+
+TARGET_SSE2 static void Mono_SSE2(const uint32_t * src, uint8_t * dst, int count, int threshold, int flags)
+{
+    int i = 0;
+
+    // a threshold above the maximum luminance is left to the C kernel
+    if (threshold <= 255)
+    {
+        __m128i invert = Invert_SSE2(flags);
+        __m128i t = _mm_set1_epi8((char) threshold);
+
+        for (; i + 16 <= count; i += 16)
+        {
+            __m128i l = Luminance16_SSE2(src, count, i, flags, invert);
+            // l >= t, bit n of the mask is pixel n
+            int bits = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_max_epu8(l, t), l));
+
+            dst[i >> 3] = ReverseBits(bits & 0xFF);
+            dst[(i >> 3) + 1] = ReverseBits(bits >> 8);
+        }
+    }
+    Mono_C(TailSrc(src, i, flags), dst + (i >> 3), count - i, threshold, flags);
+}
+
+TARGET_SSE2 static void Grey4_SSE2(const uint32_t * src, uint8_t * dst, int count, int flags)
+{
+    __m128i invert = Invert_SSE2(flags);
+    int i;
+
+    for (i = 0; i + 16 <= count; i += 16)
+    {
+        __m128i l = Luminance16_SSE2(src, count, i, flags, invert);
+        // even pixels are in the low, odd ones in the high byte of each 16 bit lane
+        __m128i c = _mm_or_si128(_mm_and_si128(l, _mm_set1_epi16(0x00F0)), _mm_srli_epi16(l, 12));
+
+        _mm_storel_epi64((__m128i *) (dst + (i >> 1)), _mm_packus_epi16(c, c));
+    }
+    Grey4_C(TailSrc(src, i, flags), dst + (i >> 1), count - i, flags);
+}
+
+static bool Supported_SSE2(void)
+{
+    return __builtin_cpu_supports("sse2");
+}
+
+//
+// AVX2 kernels, 8 pixels per vector
+//
+
+TARGET_AVX2 static inline __m256i Load_AVX2(const uint32_t * src, int count, int i, int flags, __m256i invert)
+{
+    __m256i v;
+
+    if (flags & kConvReverse)
+        v = _mm256_permutevar8x32_epi32(_mm256_loadu_si256((const __m256i *) (src + count - i - 8)),
+                                        _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0));
+    else
+        v = _mm256_loadu_si256((const __m256i *) (src + i));
+    return _mm256_xor_si256(v, invert);
+}
+
+TARGET_AVX2 static inline __m256i Invert_AVX2(int flags)
+{
+    return _mm256_set1_epi32((flags & kConvInvert) ? kRGBMask : 0);
+}
+
+TARGET_AVX2 static inline __m256i RGB565_8_AVX2(__m256i v, bool swapRB)
+{
+    __m256i hi;
+    __m256i lo;
+    __m256i g = _mm256_and_si256(_mm256_srli_epi32(v, 5), _mm256_set1_epi32(0x07E0));
+
+    if (swapRB)
+    {
+        hi = _mm256_and_si256(_mm256_slli_epi32(v, 8), _mm256_set1_epi32(0xF800));
+        lo = _mm256_and_si256(_mm256_srli_epi32(v, 19), _mm256_set1_epi32(0x001F));
+    }
+    else
+    {
+        hi = _mm256_and_si256(_mm256_srli_epi32(v, 8), _mm256_set1_epi32(0xF800));
+        lo = _mm256_and_si256(_mm256_srli_epi32(v, 3), _mm256_set1_epi32(0x001F));
+    }
+    __m256i c = _mm256_or_si256(_mm256_or_si256(hi, g), lo);
+    return _mm256_srai_epi32(_mm256_slli_epi32(c, 16), 16);
+}
+
+TARGET_AVX2 static inline __m256i Luminance_AVX2(__m256i v)
+{
+    const __m256i mask = _mm256_set1_epi32(0xFF);
+    __m256i r = _mm256_and_si256(_mm256_srli_epi32(v, 16), mask);
+    __m256i g = _mm256_and_si256(_mm256_srli_epi32(v, 8), mask);
+    __m256i b = _mm256_and_si256(v, mask);
+
+    __m256i sum = _mm256_add_epi32(_mm256_mullo_epi16(r, _mm256_set1_epi32(77)),
+                                   _mm256_mullo_epi16(g, _mm256_set1_epi32(150)));
+    sum = _mm256_add_epi32(sum, _mm256_mullo_epi16(b, _mm256_set1_epi32(29)));
+    return _mm256_srli_epi32(sum, 8);
+}
+
+// luminance of 32 pixels from position i of dst on, one byte each
+TARGET_AVX2 static inline __m256i Luminance32_AVX2(const uint32_t * src, int count, int i, int flags, __m256i invert)
+{
+    __m256i l0 = Luminance_AVX2(Load_AVX2(src, count, i, flags, invert));
+    __m256i l1 = Luminance_AVX2(Load_AVX2(src, count, i + 8, flags, invert));
+    __m256i l2 = Luminance_AVX2(Load_AVX2(src, count, i + 16, flags, invert));
+    __m256i l3 = Luminance_AVX2(Load_AVX2(src, count, i + 24, flags, invert));
+
+    // packing works per 128 bit lane: restore the order of the groups of 4 pixels
+    __m256i l = _mm256_packus_epi16(_mm256_packs_epi32(l0, l1), _mm256_packs_epi32(l2, l3));
+    return _mm256_permutevar8x32_epi32(l, _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7));
+}
+
+TARGET_AVX2 static void RGB565_AVX2(const uint32_t * src, uint16_t * dst, int count, int flags)
+{
+    __m256i invert = Invert_AVX2(flags);
+    bool swapRB = flags & kConvSwapRB;
+    int i;
+
+    for (i = 0; i + 16 <= count; i += 16)
+    {
+        __m256i c = _mm256_packs_epi32(RGB565_8_AVX2(Load_AVX2(src, count, i, flags, invert), swapRB),
+                                       RGB565_8_AVX2(Load_AVX2(src, count, i + 8, flags, invert), swapRB));
+        c = _mm256_permute4x64_epi64(c, _MM_SHUFFLE(3, 1, 2, 0));
+        if (flags & kConvByteSwap)
+            c = _mm256_or_si256(_mm256_slli_epi16(c, 8), _mm256_srli_epi16(c, 8));
+        _mm256_storeu_si256((__m256i *) (dst + i), c);
+    }
+    RGB565_C(TailSrc(src, i, flags), dst + i, count - i, flags);
+}
+
+TARGET_AVX2 static void RGB888_AVX2(const uint32_t * src, uint8_t * dst, int count, int flags)
+{
+    __m256i invert = Invert_AVX2(flags);
+    __m256i shuffle;
+    int i;
+
+    if (flags & kConvSwapRB)
+        shuffle = _mm256_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+                                   0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+    else
+        shuffle = _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+                                   2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+
+    // each half gives 12 bytes but is stored with 16: the last store writes 4 bytes
+    // of the following pixels, so at least 2 more pixels have to follow
+    for (i = 0; i + 10 <= count; i += 8)
+    {
+        __m256i c = _mm256_shuffle_epi8(Load_AVX2(src, count, i, flags, invert), shuffle);
+
+        _mm_storeu_si128((__m128i *) (dst + i * 3), _mm256_castsi256_si128(c));
+        _mm_storeu_si128((__m128i *) (dst + i * 3 + 12), _mm256_extracti128_si256(c, 1));
+    }
+    RGB888_C(TailSrc(src, i, flags), dst + i * 3, count - i, flags);
+}
+
+TARGET_AVX2 static void Mono_AVX2(const uint32_t * src, uint8_t * dst, int count, int threshold, int flags)
+{
+    int i = 0;
+
+    if (threshold <= 255)
+    {
+        __m256i invert = Invert_AVX2(flags);
+        __m256i t = _mm256_set1_epi8((char) threshold);
+
+        for (; i + 32 <= count; i += 32)
+        {
+            __m256i l = Luminance32_AVX2(src, count, i, flags, invert);
+            uint32_t bits = _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_max_epu8(l, t), l));
+
+            for (int n = 0; n < 4; n++)
+                dst[(i >> 3) + n] = ReverseBits((bits >> (n * 8)) & 0xFF);
+        }
+    }
+    Mono_C(TailSrc(src, i, flags), dst + (i >> 3), count - i, threshold, flags);
+}
+
+TARGET_AVX2 static void Grey4_AVX2(const uint32_t * src, uint8_t * dst, int count, int flags)
+{
+    __m256i invert = Invert_AVX2(flags);
+    int i;
+
+    for (i = 0; i + 32 <= count; i += 32)
+    {
+        __m256i l = Luminance32_AVX2(src, count, i, flags, invert);
+        __m256i c = _mm256_or_si256(_mm256_and_si256(l, _mm256_set1_epi16(0x00F0)), _mm256_srli_epi16(l, 12));
+
+        c = _mm256_permute4x64_epi64(_mm256_packus_epi16(c, c), _MM_SHUFFLE(3, 1, 2, 0));
+        _mm_storeu_si128((__m128i *) (dst + (i >> 1)), _mm256_castsi256_si128(c));
+    }
+    Grey4_C(TailSrc(src, i, flags), dst + (i >> 1), count - i, flags);
+}
+
+static bool Supported_AVX2(void)
+{
+    return __builtin_cpu_supports("avx2");
+}
+
+#endif // CONV_X86
+
+#ifdef CONV_NEON
+
+//
+// NEON kernels, 16 pixels split into their channels
+//
+
+// 16 pixels from position i of dst on. val[0] - val[2] hold b, g and r.
+static inline uint8x16x4_t Load_NEON(const uint32_t * src, int count, int i, int flags)
+{
+    uint8x16x4_t v;
+
+    if (flags & kConvReverse)
+    {
+        v = vld4q_u8((const uint8_t *) (src + count - i - 16));
+        for (int c = 0; c < 3; c++)
+        {
+            uint8x16_t r = vrev64q_u8(v.val[c]);
+            v.val[c] = vextq_u8(r, r, 8);
+        }
+    }
+    else
+    {
+        v = vld4q_u8((const uint8_t *) (src + i));
+    }
+    if (flags & kConvInvert)
+    {
+        for (int c = 0; c < 3; c++)
+            v.val[c] = vmvnq_u8(v.val[c]);
+    }
+    return v;
+}
+
+static inline uint16x8_t RGB565_8_NEON(uint8x8_t hi, uint8x8_t g, uint8x8_t lo)
+{
+    uint16x8_t c = vshll_n_u8(hi, 8);
+    c = vsriq_n_u16(c, vshll_n_u8(g, 8), 5);
+    return vsriq_n_u16(c, vshll_n_u8(lo, 8), 11);
+}
+
+static inline uint8x16_t Luminance16_NEON(const uint8x16x4_t & v)
+{
+    uint16x8_t lo = vmull_u8(vget_low_u8(v.val[2]), vdup_n_u8(77));
+    lo = vmlal_u8(lo, vget_low_u8(v.val[1]), vdup_n_u8(150));
+    lo = vmlal_u8(lo, vget_low_u8(v.val[0]), vdup_n_u8(29));
+
+    uint16x8_t hi = vmull_u8(vget_high_u8(v.val[2]), vdup_n_u8(77));
+    hi = vmlal_u8(hi, vget_high_u8(v.val[1]), vdup_n_u8(150));
+    hi = vmlal_u8(hi, vget_high_u8(v.val[0]), vdup_n_u8(29));
+
+    return vcombine_u8(vshrn_n_u16(lo, 8), vshrn_n_u16(hi, 8));
+}
+
+static void RGB565_NEON(const uint32_t * src, uint16_t * dst, int count, int flags)
+{
+    int hi = (flags & kConvSwapRB) ? 0 : 2;
+    int i;
+
+    for (i = 0; i + 16 <= count; i += 16)
+    {
+        uint8x16x4_t v = Load_NEON(src, count, i, flags);
+
+        for (int h = 0; h < 2; h++)
+        {
+            uint16x8_t c;
+
+            if (h == 0)
+                c = RGB565_8_NEON(vget_low_u8(v.val[hi]), vget_low_u8(v.val[1]), vget_low_u8(v.val[2 - hi]));
+            else
+                c = RGB565_8_NEON(vget_high_u8(v.val[hi]), vget_high_u8(v.val[1]), vget_high_u8(v.val[2 - hi]));
+            if (flags & kConvByteSwap)
+                c = vreinterpretq_u16_u8(vrev16q_u8(vreinterpretq_u8_u16(c)));
+            vst1q_u16(dst + i + h * 8, c);
+        }
+    }
+    RGB565_C(TailSrc(src, i, flags), dst + i, count - i, flags);
+}
+
+static void RGB888_NEON(const uint32_t * src, uint8_t * dst, int count, int flags)
+{
+    int first = (flags & kConvSwapRB) ? 0 : 2;
+    int i;
+
+    for (i = 0; i + 16 <= count; i += 16)
+    {
+        uint8x16x4_t v = Load_NEON(src, count, i, flags);
+        uint8x16x3_t c;
+
+        c.val[0] = v.val[first];
+        c.val[1] = v.val[1];
+        c.val[2] = v.val[2 - first];
+        vst3q_u8(dst + i * 3, c);
+    }
+    RGB888_C(TailSrc(src, i, flags), dst + i * 3, count - i, flags);
+}
+
+static void Mono_NEON(const uint32_t * src, uint8_t * dst, int count, int threshold, int flags)
+{
+    static const uint8_t kBits[16] = { 0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01,
+                                       0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01 };
+    int i = 0;
+
+    if (threshold <= 255)
+    {
+        uint8x16_t bitsMask = vld1q_u8(kBits);
+        uint8x16_t t = vdupq_n_u8(threshold);
+
+        for (; i + 16 <= count; i += 16)
+        {
+            uint8x16_t bits = vandq_u8(vcgeq_u8(Luminance16_NEON(Load_NEON(src, count, i, flags)), t), bitsMask);
+
+            dst[i >> 3] = vaddv_u8(vget_low_u8(bits));
+            dst[(i >> 3) + 1] = vaddv_u8(vget_high_u8(bits));
+        }
+    }
+    Mono_C(TailSrc(src, i, flags), dst + (i >> 3), count - i, threshold, flags);
+}
+
+static void Grey4_NEON(const uint32_t * src, uint8_t * dst, int count, int flags)
+{
+    int i;
+
+    for (i = 0; i + 16 <= count; i += 16)
+    {
+        uint8x16_t l = Luminance16_NEON(Load_NEON(src, count, i, flags));
+        uint8x16x2_t p = vuzpq_u8(l, l);    // even and odd pixels
+
+        vst1_u8(dst + (i >> 1), vorr_u8(vand_u8(vget_low_u8(p.val[0]), vdup_n_u8(0xF0)),
+                                        vshr_n_u8(vget_low_u8(p.val[1]), 4)));
+    }
+    Grey4_C(TailSrc(src, i, flags), dst + (i >> 1), count - i, flags);
+}
+
+static bool Supported_NEON(void)
+{
+    return true;
+}
+
+#endif // CONV_NEON
+
+//
+// runtime dispatch
+//
+
+struct tConvKernels
+{
+    const char * name;
+    bool (*supported)(void);
+    void (*rgb565)(const uint32_t * src, uint16_t * dst, int count, int flags);
+    void (*rgb888)(const uint32_t * src, uint8_t * dst, int count, int flags);
+    void (*mono)(const uint32_t * src, uint8_t * dst, int count, int threshold, int flags);
+    void (*grey4)(const uint32_t * src, uint8_t * dst, int count, int flags);
+};
+
+// in order of preference, the C kernels are always available
+static const tConvKernels kKernels[] =
+{
+#ifdef CONV_X86
+    { "avx2", Supported_AVX2, RGB565_AVX2, RGB888_AVX2, Mono_AVX2, Grey4_AVX2 },
+    // rgb888 needs byte shuffles which SSE2 does not have
+    { "sse2", Supported_SSE2, RGB565_SSE2, RGB888_C, Mono_SSE2, Grey4_SSE2 },
+#endif
+#ifdef CONV_NEON
+    { "neon", Supported_NEON, RGB565_NEON, RGB888_NEON, Mono_NEON, Grey4_NEON },
+#endif
+    { "c", NULL, RGB565_C, RGB888_C, Mono_C, Grey4_C }
+};
+static const int kNumKernels = sizeof(kKernels) / sizeof(kKernels[0]);
+
+static const tConvKernels * kernels = &kKernels[kNumKernels - 1];
+static pthread_once_t selectOnce = PTHREAD_ONCE_INIT;
+
+static void SelectKernels(void)
+{
+#ifdef CONV_X86
+    __builtin_cpu_init();
+#endif
+    for (int i = 0; i < kNumKernels; i++)
+    {
+        if (!kKernels[i].supported || kKernels[i].supported())
+        {
+            kernels = &kKernels[i];
+            break;
+        }
+    }
+}
+
+static inline const tConvKernels * Kernels(void)
+{
+    pthread_once(&selectOnce, SelectKernels);
+    return kernels;
+}
+
+void ConvertRGB565(const uint32_t * src, uint16_t * dst, int count, int flags)
+{
+    if (count > 0)
+        Kernels()->rgb565(src, dst, count, flags);
+}
+
+void ConvertRGB888(const uint32_t * src, uint8_t * dst, int count, int flags)
+{
+    if (count > 0)
+        Kernels()->rgb888(src, dst, count, flags);
+}
+
+void ConvertMono(const uint32_t * src, uint8_t * dst, int count, int threshold, int flags)
+{
+    if (count > 0)
+    {
+        clip(threshold, 0, 256);
+        Kernels()->mono(src, dst, count, threshold, flags);
+    }
+}
+
+void ConvertGrey4(const uint32_t * src, uint8_t * dst, int count, int flags)
+{
+    if (count > 0)
+        Kernels()->grey4(src, dst, count, flags);
+}
+
+void TransposeMono8x8(const uint8_t * src, int stride, uint8_t * dst, int flags)
+{
+    // the rows in one word, first row in the high byte
+    uint64_t x = 0;
+    for (int i = 0; i < 8; i++)
+        x = (x << 8) | src[i * stride];
+
+    // swap bits across the diagonal in 2x2, 4x4 and 8x8 steps (Hacker's Delight, transpose8)
+    uint64_t t;
+    t = (x ^ (x >> 7)) & 0x00AA00AA00AA00AAULL;
+    x ^= t ^ (t << 7);
+    t = (x ^ (x >> 14)) & 0x0000CCCC0000CCCCULL;
+    x ^= t ^ (t << 14);
+    t = (x ^ (x >> 28)) & 0x00000000F0F0F0F0ULL;
+    x ^= t ^ (t << 28);
+
+    if (flags & kConvReverse)
+    {
+        // rotated by 180°: reverse the order of all 64 bits
+        x = __builtin_bswap64(x);
+        x = ((x >> 1) & 0x5555555555555555ULL) | ((x & 0x5555555555555555ULL) << 1);
+        x = ((x >> 2) & 0x3333333333333333ULL) | ((x & 0x3333333333333333ULL) << 2);
+        x = ((x >> 4) & 0x0F0F0F0F0F0F0F0FULL) | ((x & 0x0F0F0F0F0F0F0F0FULL) << 4);
+    }
+    for (int i = 7; i >= 0; i--, x >>= 8)
+        dst[i] = (uint8_t) x;
+}
+
+int PackMonoColumns(const uint8_t * data, int wid, int hgt, int lineSize,
+                    uint8_t ** columns, int width, int height, int flags)
+{
+    // whole blocks only if the bytes of the display start at the top of the screen
+    int blockRows = (height % 8 == 0) ? hgt / 8 * 8 : 0;
+    int blockCols = wid / 8 * 8;
+    uint8_t block[8];
+
+    for (int y = 0; y < blockRows; y += 8)
+    {
+        for (int x = 0; x < blockCols; x += 8)
+        {
+            TransposeMono8x8(data + y * lineSize + x / 8, lineSize, block, flags);
+            if (flags & kConvReverse)
+            {
+                for (int i = 0; i < 8; i++)
+                    columns[width - 8 - x + i][(height - 8 - y) / 8] = block[i];
+            }
+            else
+            {
+                for (int i = 0; i < 8; i++)
+                    columns[x + i][y / 8] = block[i];
+            }
+        }
+    }
+    return blockRows;
+}
+
+const char * GetConvertInstructionSet(void)
+{
+    return Kernels()->name;
+}
+
+bool SetConvertInstructionSet(const char * name)
+{
+    pthread_once(&selectOnce, SelectKernels);
+    for (int i = 0; i < kNumKernels; i++)
+    {
+        if (strcmp(kKernels[i].name, name) == 0)
+        {
+            if (kKernels[i].supported && !kKernels[i].supported())
+                return false;
+            kernels = &kKernels[i];
+            return true;
+        }
+    }
+    return false;
+}
+
+} // end of namespace
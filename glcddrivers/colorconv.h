@@ -0,0 +1,64 @@
+/*
+ * GraphLCD driver library
+ *
+ * colorconv.h  -  conversion of ARGB pixels into native display formats
+ *                 Vectorised kernels (SSE2/AVX2/NEON) with a plain C
+ *                 fallback, selected at runtime.
+ *
+ * This file is released under the GNU General Public License. Refer
+ * to the COPYING file distributed with this package.
+ */
+
+#ifndef _GLCDDRIVERS_COLORCONV_H_
+#define _GLCDDRIVERS_COLORCONV_H_
+
+#include <stdint.h>
+
+
+namespace GLCD
+{
+
+// flags of the conversion functions
+enum eConvFlags
+{
+    kConvInvert   = 0x01,   // invert the colour (rgb ^ 0xFFFFFF) before converting it
+    kConvReverse  = 0x02,   // store the pixels in reverse order (line of a display rotated by 180°)
+    kConvSwapRB   = 0x04,   // BGR565 resp. byte order B, G, R for RGB888
+    kConvByteSwap = 0x08    // RGB565 only: high byte first (big endian)
+};
+
+// all functions convert count pixels from src to dst. src and dst must not overlap.
+// the luminance used for the monochrome and the grey formats is (77 r + 150 g + 29 b) / 256.
+
+// 16 bit 5-6-5, native byte order unless kConvByteSwap is given
+void ConvertRGB565(const uint32_t * src, uint16_t * dst, int count, int flags = 0);
+// 3 bytes per pixel: r, g, b (b, g, r with kConvSwapRB)
+void ConvertRGB888(const uint32_t * src, uint8_t * dst, int count, int flags = 0);
+// 1 bit per pixel, first pixel in the msb. a pixel is set if its luminance is >= threshold
+// (0 - 255). unused bits of a last, partly filled byte are cleared.
+void ConvertMono(const uint32_t * src, uint8_t * dst, int count, int threshold, int flags = 0);
+// 4 bit grey, 2 pixels per byte, first pixel in the high nibble.
+// the low nibble of a last, partly filled byte is cleared.
+void ConvertGrey4(const uint32_t * src, uint8_t * dst, int count, int flags = 0);
+
+// transposes a block of 8 x 8 pixels at 1 bit per pixel: src holds the 8 rows, stride bytes
+// apart, first pixel in the msb. dst[i] receives column i, top pixel in the msb (the layout of
+// displays with vertical bytes). with kConvReverse the block is rotated by 180° before.
+void TransposeMono8x8(const uint8_t * src, int stride, uint8_t * dst, int flags = 0);
+// packs the whole 8 x 8 blocks of a wid x hgt screen at 1 bpp (data, lineSize bytes per line, first
+// pixel in the msb) into the vertical bytes columns[x][y / 8] of a width x height display, top pixel
+// in the msb. with kConvReverse the screen is rotated by 180°. returns the number of lines covered
+// by blocks (0 if height is no multiple of 8), their pixels from column wid / 8 * 8 on and all
+// pixels of the lines below are left to the caller.
+int PackMonoColumns(const uint8_t * data, int wid, int hgt, int lineSize,
+                    uint8_t ** columns, int width, int height, int flags = 0);
+
+// instruction set used by the functions above: "avx2", "sse2", "neon" or "c"
+const char * GetConvertInstructionSet(void);
+// use another instruction set, eg. for comparing them. not thread safe, returns false if
+// the instruction set is not supported by the cpu or the build.
+bool SetConvertInstructionSet(const char * name);
+
+} // end of namespace
+
+#endif
@@ -14,6 +14,8 @@
  */
 
 #include <ctype.h>
+#include <limits.h>
+#include <pthread.h>
 #include <sched.h>
 #include <time.h>
 #include <unistd.h>
@@ -23,6 +25,7 @@
 
 #include "common.h"
 #include "config.h"
+#include "porttrace.h"
 
 
 namespace GLCD
@@ -64,10 +67,115 @@ static const int BitReverseTable[256] =
     0x1f, 0x9f, 0x5f, 0xdf, 0x3f, 0xbf, 0x7f, 0xff
 };
 
+#ifdef CLOCK_MONOTONIC_RAW
+static const clockid_t kWaitClock = CLOCK_MONOTONIC_RAW;
+#else
+static const clockid_t kWaitClock = CLOCK_MONOTONIC;
+#endif
+
+static tTimings waitTimings;
+static double spinLoopsPerNs = 1.0;
+static pthread_once_t calibrateOnce = PTHREAD_ONCE_INIT;
+
+static inline long long Now()
+{
+    struct timespec ts;
+    clock_gettime(kWaitClock, &ts);
+    return (long long) ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static inline void CpuRelax()
+{
+#if defined(__i386__) || defined(__x86_64__)
+    __builtin_ia32_pause();
+#else
+    __asm__ __volatile__("" ::: "memory");
+#endif
+}
+
+static void SpinLoops(long loops)
+{
+    for (long i = 0; i < loops; i++)
+        CpuRelax();
+}
+
+static void Calibrate()
+{
+    long long start;
+    long long elapsed;
+
+    // cost of reading the clock
+    const int kClockReads = 1000;
+    start = Now();
+    for (int i = 0; i < kClockReads; i++)
+        Now();
+    waitTimings.clockRead = std::max(1LL, (Now() - start) / kClockReads);
+
+    // speed of the loop used for waits shorter than a clock read
+    const long kLoops = 100000;
+    start = Now();
+    SpinLoops(kLoops);
+    elapsed = Now() - start;
+    if (elapsed > 0)
+        spinLoopsPerNs = (double) kLoops / elapsed;
+
+    // how much longer than requested nanosleep() sleeps, best of a few tries
+    long latency = LONG_MAX;
+    for (int i = 0; i < 5; i++)
+    {
+        struct timespec delay = { 0, 1000 };
+        start = Now();
+        nanosleep(&delay, NULL);
+        latency = std::min(latency, (long) (Now() - start - 1000));
+    }
+    waitTimings.sleepLatency = std::max(0L, latency);
+
+    // sleeping only pays off for waits well above the latency
+    waitTimings.spinThreshold = std::max(2 * waitTimings.sleepLatency, 1000L);
+}
+
+static void CalibratedSleep(long ns)
+{
+    pthread_once(&calibrateOnce, Calibrate);
+
+    // very short strobe delays are spun without reading the clock at all
+    if (ns < 2 * waitTimings.clockRead)
+    {
+        SpinLoops((long) (ns * spinLoopsPerNs) + 1);
+        return;
+    }
+
+    long long deadline = Now() + ns;
+    if (ns > waitTimings.spinThreshold)
+    {
+        // sleep for the bulk of the wait, spin the rest
+        long sleep = ns - waitTimings.sleepLatency;
+        struct timespec delay, remaining;
+        delay.tv_sec = sleep / 1000000000;
+        delay.tv_nsec = sleep % 1000000000;
+        while (nanosleep(&delay, &remaining) == -1)
+            delay = remaining;
+    }
+    while (Now() < deadline)
+        CpuRelax();
+}
+
+void GetWaitTimings(tTimings & timings)
+{
+    pthread_once(&calibrateOnce, Calibrate);
+    timings.clockRead = waitTimings.clockRead;
+    timings.sleepLatency = waitTimings.sleepLatency;
+    timings.spinThreshold = waitTimings.spinThreshold;
+}
+
 int nSleepInit()
 {
     int ret = 0;
 
+    // traced waits do not need a higher priority
+    if (GetSleepTrace())
+        return 0;
+
     if (Config.waitPriority != 0)
     {
         ret = setpriority(PRIO_PROCESS, 0, Config.waitPriority);
@@ -90,6 +198,9 @@ int nSleepInit()
                 break;
             case kWaitGettimeofday: // gettimeofday
                 break;
+            case kWaitCalibrated: // calibrated spinning / sleeping
+                pthread_once(&calibrateOnce, Calibrate);
+                break;
         }
     }
     return ret;
@@ -99,6 +210,9 @@ int nSleepDeInit()
 {
     int ret = 0;
 
+    if (GetSleepTrace())
+        return 0;
+
     if (Config.waitPriority != 0)
     {
         ret = setpriority(PRIO_PROCESS, 0, 0);
@@ -120,6 +234,7 @@ int nSleepDeInit()
                 ret = sched_setscheduler(0, SCHED_OTHER, &param);
                 break;
             case kWaitGettimeofday: // gettimeofday
+            case kWaitCalibrated: // calibrated spinning / sleeping
                 break;
         }
     }
@@ -128,6 +243,13 @@ int nSleepDeInit()
 
 void nSleep(long ns)
 {
+    cPortTrace * trace = GetSleepTrace();
+    if (trace)
+    {
+        trace->Wait(ns);
+        return;
+    }
+
     switch (Config.waitMethod)
     {
         case kWaitUsleep: // usleep
@@ -150,28 +272,24 @@ void nSleep(long ns)
                 }
             }
             break;
-        case kWaitGettimeofday: //getTimeofday for Kernel 2.6
-            long us;
-            struct timeval tv1, tv2;
-            suseconds_t us2;
+        case kWaitGettimeofday: // busy wait on the monotonic clock, at least 1 us
             if (ns > 0)
             {
-                us = ns / 1000;
-                if (us == 0)
-                    us = 1;
-                gettimeofday(&tv1, 0);
-                do
-                {
-                    gettimeofday(&tv2, 0);
-                    us2 = tv2.tv_usec + ((tv2.tv_sec - tv1.tv_sec) * 1000000);
-                } while (us2 - tv1.tv_usec < us);
+                long long deadline = Now() + std::max(1000L, ns);
+                while (Now() < deadline)
+                    CpuRelax();
             }
+            break;
+        case kWaitCalibrated: // calibrated spinning / sleeping
+            if (ns > 0)
+                CalibratedSleep(ns);
+            break;
     }
 }
 
 void uSleep(long us)
 {
-    if (Config.waitMethod == kWaitUsleep)
+    if (Config.waitMethod == kWaitUsleep && !GetSleepTrace())
     {
         // usleep
         if (us > 0)
@@ -20,6 +20,8 @@
 namespace GLCD
 {
 
+struct tTimings;
+
 const unsigned char bitmask[8] = {0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01};
 const unsigned char bitmaskl[8] = {0x80, 0xc0, 0xe0, 0xf0, 0xf8, 0xfc, 0xfe, 0xff};
 const unsigned char bitmaskr[8] = {0xff, 0x7f, 0x3f, 0x1f, 0x0f, 0x07, 0x03, 0x01};
@@ -32,6 +34,9 @@ int nSleepDeInit(void);
 void nSleep(long ns);
 void uSleep(long us);
 
+// fills in the timings measured for the calibrated wait method
+void GetWaitTimings(tTimings & timings);
+
 unsigned char ReverseBits(unsigned char value);
 void clip(int & value, int min, int max);
 std::string trim(const std::string & s);
@@ -37,7 +37,12 @@ cDriverConfig::cDriverConfig()
     contrast(5),
     backlight(true),
     adjustTiming(0),
-    refreshDisplay(5)
+    refreshDisplay(5),
+    asyncRefresh(false),
+    stats(false),
+    statsInterval(0),
+    statsFile(""),
+    timings()
 {
 }
 
@@ -57,6 +62,11 @@ cDriverConfig::cDriverConfig(const cDriverConfig & rhs)
     backlight = rhs.backlight;
     adjustTiming = rhs.adjustTiming;
     refreshDisplay = rhs.refreshDisplay;
+    asyncRefresh = rhs.asyncRefresh;
+    stats = rhs.stats;
+    statsInterval = rhs.statsInterval;
+    statsFile = rhs.statsFile;
+    timings = rhs.timings;
     for (unsigned int i = 0; i < rhs.options.size(); i++)
         options.push_back(rhs.options[i]);
 }
@@ -84,6 +94,11 @@ cDriverConfig & cDriverConfig::operator=(const cDriverConfig & rhs)
     backlight = rhs.backlight;
     adjustTiming = rhs.adjustTiming;
     refreshDisplay = rhs.refreshDisplay;
+    asyncRefresh = rhs.asyncRefresh;
+    stats = rhs.stats;
+    statsInterval = rhs.statsInterval;
+    statsFile = rhs.statsFile;
+    timings = rhs.timings;
     options.clear();
     for (unsigned int i = 0; i < rhs.options.size(); i++)
         options.push_back(rhs.options[i]);
@@ -161,6 +176,22 @@ bool cDriverConfig::Parse(const std::string & line)
     {
         refreshDisplay = GetInt(option.value);
     }
+    else if (option.name == "AsyncRefresh")
+    {
+        asyncRefresh = GetBool(option.value);
+    }
+    else if (option.name == "Stats")
+    {
+        stats = GetBool(option.value);
+    }
+    else if (option.name == "StatsInterval")
+    {
+        statsInterval = GetInt(option.value);
+    }
+    else if (option.name == "StatsFile")
+    {
+        statsFile = option.value;
+    }
     else
     {
         options.push_back(option);
@@ -180,7 +211,7 @@ bool cDriverConfig::GetBool(const std::string & value)
 
 
 cConfig::cConfig()
-:   waitMethod(kWaitGettimeofday),
+:   waitMethod(kWaitCalibrated),
     waitPriority(0)
 {
 }
@@ -257,7 +288,13 @@ bool cConfig::Parse(const std::string & line)
 
     if (option.name == "WaitMethod")
     {
-        waitMethod = GetInt(option.value);
+        int method = GetInt(option.value);
+        if (method < kWaitUsleep || method > kWaitCalibrated)
+        {
+            syslog(LOG_ERR, "Config error: WaitMethod %s out of range, using %d!\n", option.value.c_str(), waitMethod);
+            return false;
+        }
+        waitMethod = method;
     }
     else if (option.name == "WaitPriority")
     {
@@ -24,8 +24,18 @@ const int kWaitUsleep       = 0;
 const int kWaitNanosleep    = 1;
 const int kWaitNanosleepRR  = 2;
 const int kWaitGettimeofday = 3;
+const int kWaitCalibrated   = 4;
 
 
+// measured timings in ns, filled in by drivers that benchmark their port
+struct tTimings
+{
+    long portAccess;        // one access to the port
+    long clockRead;         // one read of the clock
+    long sleepLatency;      // time nanosleep() sleeps longer than requested
+    long spinThreshold;     // shorter waits are spun, longer ones sleep
+};
+
 struct tOption
 {
     std::string name;
@@ -49,6 +59,11 @@ public:
     bool backlight;
     int adjustTiming;
     int refreshDisplay;
+    bool asyncRefresh;
+    bool stats;
+    int statsInterval;
+    std::string statsFile;
+    tTimings timings;
     std::vector <tOption> options;
 
 public:
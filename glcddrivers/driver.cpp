@@ -27,7 +27,8 @@ cTouchEvent::cTouchEvent() : x(0), y(0), touch(0)
 cDriver::cDriver(cDriverConfig * config)
 :   width(0),
     height(0),
-    config(config)
+    config(config),
+    forcedRefreshes(0)
 {
     fgcol = GetDefaultForegroundColor();
     bgcol = GetDefaultBackgroundColor();
@@ -48,39 +49,109 @@ const std::string cDriver::DriverName() {
 }
 
 
+bool cDriver::ClipScreenRect(int & x, int & y, int & w, int & h) const
+{
+    if (x < 0)
+    {
+        w += x;
+        x = 0;
+    }
+    if (y < 0)
+    {
+        h += y;
+        y = 0;
+    }
+    if (x + w > width)
+        w = width - x;
+    if (y + h > height)
+        h = height - y;
+    return (w > 0 && h > 0);
+}
+
 //void cDriver::SetScreen(const unsigned char * data, int wid, int hgt, int lineSize)
 void cDriver::SetScreen(const uint32_t * data, int wid, int hgt)
 {
-    int x, y;
+    //Clear();
+    SetScreenRect(data, wid, 0, 0, wid, hgt);
+}
+
+void cDriver::SetScreenRect(const uint32_t * data, int stride, int x, int y, int w, int h)
+{
+    int xt, yt;
 
-    if (wid > width)
-        wid = width;
-    if (hgt > height)
-        hgt = height;
+    if (!data || !ClipScreenRect(x, y, w, h))
+        return;
 
-    //Clear();
-    if (data)
+    for (yt = y; yt < y + h; yt++)
     {
-        for (y = 0; y < hgt; y++)
+        const uint32_t * line = data + yt * stride;
+        for (xt = x; xt < x + w; xt++)
         {
-          for (x = 0; x < wid; x++)
-          {
-//            printf("%s:%s(%d) - %03d * %03d (linesize %02d), %08x\n", __FILE__, __FUNCTION__, __LINE__, x, y, lineSize, data[y * lineSize + x]);
-            SetPixel(x, y, data[y * wid + x]);
-          }
+            SetPixel(xt, yt, line[xt]);
         }
     }
-/*
-            for (x = 0; x < (wid / 8); x++)
-            {
-                Set8Pixels(x * 8, y, data[y * lineSize + x]);
-            }
-            if (width % 8)
-            {
-                Set8Pixels((wid / 8) * 8, y, data[y * lineSize + wid / 8] & bitmaskl[wid % 8 - 1]);
-            }
+}
+
+void cDriver::SetScreen1BPP(const unsigned char * data, int wid, int hgt, int lineSize)
+{
+    int x = 0, y = 0;
+
+    if (!data || !ClipScreenRect(x, y, wid, hgt))
+        return;
+
+    for (int yt = 0; yt < hgt; yt++)
+    {
+        const unsigned char * line = data + yt * lineSize;
+        for (int xt = 0; xt < wid; xt++)
+        {
+            SetPixel(xt, yt, (line[xt >> 3] & (0x80 >> (xt & 7))) ? GRAPHLCD_White : GRAPHLCD_Black);
         }
-*/
+    }
+}
+
+void cDriver::SetScreenRects(const uint32_t * data, int wid, int hgt, const std::vector<tRect> & rects)
+{
+    std::vector<tRect>::const_iterator it;
+
+    for (it = rects.begin(); it != rects.end(); it++)
+    {
+        tRect r = *it;
+        // clip to the dimensions of the screen buffer
+        if (r.x1 < 0) r.x1 = 0;
+        if (r.y1 < 0) r.y1 = 0;
+        if (r.x2 > wid - 1) r.x2 = wid - 1;
+        if (r.y2 > hgt - 1) r.y2 = hgt - 1;
+        if (!r.IsEmpty())
+            SetScreenRect(data, wid, r.x1, r.y1, r.Width(), r.Height());
+    }
+}
+
+bool cDriver::GetStat(const std::string & Name, uint64_t & value) const
+{
+    tDriverStats stats;
+
+    value = 0;
+    if (!GetStats(stats))
+        return false;
+
+    const char * name = Name.c_str();
+    if (strcasecmp(name, "frames") == 0)
+        value = stats.frames;
+    else if (strcasecmp(name, "fullrefreshes") == 0)
+        value = stats.fullRefreshes;
+    else if (strcasecmp(name, "partialrefreshes") == 0)
+        value = stats.frames - stats.fullRefreshes;
+    else if (strcasecmp(name, "bytes") == 0)
+        value = stats.bytes;
+    else if (strcasecmp(name, "syscalls") == 0)
+        value = stats.syscalls;
+    else if (strcasecmp(name, "setscreentime") == 0)
+        value = stats.setScreenTime;
+    else if (strcasecmp(name, "refreshtime") == 0)
+        value = stats.refreshTime;
+    else
+        return false;
+    return true;
 }
 
 void cDriver::Set8Pixels(int x, int y, unsigned char data)
@@ -17,6 +17,7 @@
 #define _GLCDDRIVERS_DRIVER_H_
 
 #include <stdint.h>
+#include <vector>
 #include "../glcdgraphics/bitmap.h"
 
 // for strcasecmp
@@ -38,6 +39,17 @@ public:
     cTouchEvent();
 };
 
+// statistics of a driver, collected if the driver option Stats is set (see cDriverStats)
+struct tDriverStats
+{
+    uint64_t frames;            // Refresh() calls
+    uint64_t fullRefreshes;     // Refresh() calls with refreshAll, including the ones the driver forced itself
+    uint64_t bytes;             // bytes written to the device, if the driver reports them
+    uint64_t syscalls;          // system calls for writing to the device, if the driver reports them
+    uint64_t setScreenTime;     // ns spent in SetScreenRect() and SetScreen1BPP()
+    uint64_t refreshTime;       // ns spent in Refresh()
+};
+
 class cDriverConfig;
 
 class cDriver
@@ -49,10 +61,25 @@ protected:
     uint32_t fgcol;
     cDriverConfig * config;
     cDriverConfig * oldConfig;
+    // display area changed since the last Refresh() in native (driver buffer) coordinates.
+    // only maintained by drivers that use it to limit their refresh to the changed area.
+    tRect dirtyArea;
+    // partial refreshes the driver turned into full ones (see ForceRefreshAll())
+    uint64_t forcedRefreshes;
 
     virtual bool GetDriverFeature  (const std::string & Feature, int & value) { return false; }
     virtual uint32_t GetDefaultBackgroundColor(void) { return GRAPHLCD_Black; }
             uint32_t GetDefaultForegroundColor(void) { return GetDefaultBackgroundColor() ^ 0x00FFFFFF; }
+
+    // clip a rectangle to the display area, returns false if nothing is left to draw
+    bool ClipScreenRect(int & x, int & y, int & w, int & h) const;
+
+    void MarkDirty(int x, int y) { dirtyArea.Unite(tRect(x, y, x, y)); }
+    void MarkDirty(void) { dirtyArea = tRect(0, 0, width - 1, height - 1); }
+    void ResetDirty(void) { dirtyArea = tRect(); }
+    // drivers call this in Refresh() instead of setting refreshAll themselves (RefreshDisplay
+    // reached, setup changed, no partial update), so that the statistics see the full refresh
+    void ForceRefreshAll(bool & refreshAll) { if (!refreshAll) { refreshAll = true; forcedRefreshes++; } }
 public:
     cDriver(cDriverConfig * config);
     virtual ~cDriver();
@@ -71,6 +98,17 @@ public:
             void Set8Pixels(int x, int y, unsigned char data);
 //    virtual void SetScreen(const unsigned char * data, int width, int height, int lineSize);
     virtual void SetScreen(const uint32_t *data, int width, int height);
+    // transfer the area x/y/w/h of an ARGB screen buffer (line length: stride pixels) to the same
+    // position on the display. data points to the upper left pixel of the whole buffer.
+    // the default implementation calls SetPixel() for every pixel, drivers may override it
+    // with a line- or block-wise conversion into their native buffer.
+    virtual void SetScreenRect(const uint32_t *data, int stride, int x, int y, int w, int h);
+    // transfer only the given areas of a screen buffer (eg. the damage list of a cBitmap)
+            void SetScreenRects(const uint32_t *data, int width, int height, const std::vector<tRect> & rects);
+    // transfer a 1 bpp screen buffer in the layout of a pfMono cBitmap: first pixel in the msb,
+    // bit set: white, lineSize bytes per line. the default implementation calls SetPixel(),
+    // drivers with the same native layout may copy the lines directly.
+    virtual void SetScreen1BPP(const unsigned char *data, int width, int height, int lineSize);
     virtual void Refresh(bool refreshAll = false) {}
 
     virtual void SetBrightness(unsigned int percent) {}
@@ -126,6 +164,16 @@ public:
 
     virtual cGLCDEvent * GetEvent(void) { return NULL; }
 
+    // statistics, false if they are not collected for this driver
+    virtual bool GetStats(tDriverStats & stats) const { return false; }
+    // a single value of the statistics by its name (case insensitive): 'frames', 'fullrefreshes',
+    // 'partialrefreshes', 'bytes', 'syscalls', 'setscreentime', 'refreshtime' (times in ns)
+    bool GetStat(const std::string & Name, uint64_t & value) const;
+    // bytes and system calls written to the device since Init(), false if the driver does not count them
+    virtual bool GetIOStats(uint64_t & bytes, uint64_t & syscalls) const { return false; }
+    // full refreshes the driver forced on its own since it was created
+    virtual uint64_t GetForcedRefreshes(void) const { return forcedRefreshes; }
+
 };
 
 } // end of namespace
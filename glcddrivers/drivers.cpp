@@ -12,6 +12,9 @@
 #include <string.h>
 
 #include "drivers.h"
+#include "config.h"
+#include "async.h"
+#include "stats.h"
 #include "simlcd.h"
 #include "gu140x32f.h"
 #include "gu256x64-372.h"
@@ -32,6 +35,7 @@
 #include "g15daemon.h"
 #include "usbserlcd.h"
 #include "st7565r-reel.h"
+#include "loopback.h"
 #ifdef HAVE_LIBHID
 #include "futabaMDM166A.h"
 #endif
@@ -74,6 +78,7 @@ tDriver drivers[] =
     {"dm140gink",     kDriverDM140GINK},
     {"usbserlcd",     kDriverUSBserLCD},
     {"st7565r-reel",  kDriverST7565RReel},
+    {"loopback",      kDriverLoopback},
 #ifdef HAVE_LIBHID
     {"futabaMDM166A", kDriverFutabaMDM166A},
 #endif
@@ -112,7 +117,7 @@ int GetDriverID(const std::string & driver)
     return kDriverUnknown;
 }
 
-cDriver * CreateDriver(int driverID, cDriverConfig * config)
+static cDriver * CreateDriverInstance(int driverID, cDriverConfig * config)
 {
     switch (driverID)
     {
@@ -152,6 +157,8 @@ cDriver * CreateDriver(int driverID, cDriverConfig * config)
             return new cDriverUSBserLCD(config);
         case kDriverST7565RReel:
             return new cDriverST7565RReel(config);
+        case kDriverLoopback:
+            return new cDriverLoopback(config);
 #ifdef HAVE_LIBHID
         case kDriverFutabaMDM166A:
             return new cDriverFutabaMDM166A(config);
@@ -186,4 +193,15 @@ cDriver * CreateDriver(int driverID, cDriverConfig * config)
     }
 }
 
+cDriver * CreateDriver(int driverID, cDriverConfig * config)
+{
+    cDriver * driver = CreateDriverInstance(driverID, config);
+    // stats inside async: the statistics are collected by the refresh thread, which does the i/o
+    if (driver && config->stats)
+        driver = new cDriverStats(driver, config);
+    if (driver && config->asyncRefresh)
+        driver = new cDriverAsync(driver, config);
+    return driver;
+}
+
 } // end of namespace
@@ -58,6 +58,7 @@ enum eDriver
 #endif
     kDriverUSBserLCD     = 23,
     kDriverST7565RReel   = 24,
+    kDriverLoopback      = 25,
     kDriverSerDisp       = 100,
     kDriverG15daemon     = 200
 };
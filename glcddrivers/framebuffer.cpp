@@ -22,6 +22,7 @@
 
 #include "common.h"
 #include "config.h"
+#include "colorconv.h"
 #include "framebuffer.h"
 
 
@@ -31,7 +32,10 @@ namespace GLCD
 cDriverFramebuffer::cDriverFramebuffer(cDriverConfig * config)
 :   cDriver(config),
     offbuff(0),
-    fbfd(-1)
+    fbfd(-1),
+    lineConvert(false),
+    lineFlags(0),
+    lineBuffer(0)
 {
 }
 
@@ -165,6 +169,34 @@ int cDriverFramebuffer::Init()
     }
     depth = vinfo.bits_per_pixel;
 
+    // common pixel formats are converted line by line
+    lineConvert = false;
+    lineFlags = 0;
+    if (depth == 16 && rlen == 5 && glen == 6 && blen == 5 && goff == 5)
+    {
+        if (roff == 11 && boff == 0)
+            lineConvert = true;
+        else if (roff == 0 && boff == 11)
+        {
+            lineConvert = true;
+            lineFlags |= kConvSwapRB;
+        }
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        lineFlags |= kConvByteSwap;
+#endif
+    }
+    else if (depth == 24 && rlen == 8 && glen == 8 && blen == 8 && goff == 8)
+    {
+        // least significant byte first
+        if (roff == 16 && boff == 0)
+        {
+            lineConvert = true;
+            lineFlags |= kConvSwapRB;
+        }
+        else if (roff == 0 && boff == 16)
+            lineConvert = true;
+    }
+
     // init bounding box
     bbox[0] = width - 1;  // x top
     bbox[1] = height - 1; // y top
@@ -188,6 +220,8 @@ int cDriverFramebuffer::Init()
         syslog(LOG_ERR, "%s: failed to alloc memory for framebuffer device.\n", config->name.c_str());
         return -1;
     }
+    if (lineConvert)
+        lineBuffer = new char[width * (depth >> 3)];
 
     // Map the device to memory
     fbp = mmap(0, screensize, PROT_READ | PROT_WRITE, MAP_SHARED, fbfd, 0);
@@ -211,6 +245,8 @@ int cDriverFramebuffer::DeInit()
 {
     if (offbuff)
         delete[] offbuff;
+    delete[] lineBuffer;
+    lineBuffer = 0;
     munmap(fbp, screensize);
     if (-1 != fbfd)
         close(fbfd);
@@ -239,12 +275,58 @@ int cDriverFramebuffer::CheckSetup()
     return 0;
 }
 
+uint32_t cDriverFramebuffer::NativeColour(uint32_t data) const
+{
+    uint32_t colraw;
+
+    if (vinfo.bits_per_pixel <= 8)
+    {
+        colraw = ((data & 0x00FF0000) >> (16 + 5) << 5) |   // RRRg ggbb
+                 ((data & 0x0000FF00) >> ( 8 + 5) << 2) |   // rrrG GGbb
+                 ((data & 0x000000FF) >> (     6)     );    // rrrg ggBB
+    }
+    else
+    {
+        // remap graphlcd colour representation to framebuffer rep.
+        colraw = ((data & 0x00FF0000) >> (16 + 8 - rlen) << roff) |   // red
+                 ((data & 0x0000FF00) >> ( 8 + 8 - glen) << goff) |   // green
+                 ((data & 0x000000FF) >> ( 0 + 8 - blen) << boff);    // blue
+        if (vinfo.bits_per_pixel == 32 && alen > 0)
+            colraw |= ((data & 0xFF000000) >> (24 + 8 - alen) << aoff);    // transp.
+    }
+    return colraw;
+}
+
+void cDriverFramebuffer::NativeBytes(uint32_t data, char * col) const
+{
+    uint32_t colraw = NativeColour(data);
+    int bytes = vinfo.bits_per_pixel >> 3;
+
+    // framebuffer byte order: least significant byte first
+    for (int i = 0; i < bytes; i++)
+        col[i] = (colraw >> (i * 8)) & 0xFF;
+}
+
+bool cDriverFramebuffer::StorePixel(char * location, const char * col)
+{
+    int bytes = vinfo.bits_per_pixel >> 3;
+
+    if (memcmp(location, col, bytes) == 0)
+        return false;
+
+    memcpy(location, col, bytes);
+    if (zoom == 1)
+    {
+        memcpy(location + bytes, col, bytes);
+        memcpy(location + finfo.line_length, col, bytes);
+        memcpy(location + finfo.line_length + bytes, col, bytes);
+    }
+    return true;
+}
+
 void cDriverFramebuffer::SetPixel(int x, int y, uint32_t data)
 {
     int location;
-    unsigned char col1, col2, col3, alpha = 0;
-    uint32_t colraw;
-    int changed = 0;
 
     if (x >= width || y >= height)
         return;
@@ -255,102 +337,152 @@ void cDriverFramebuffer::SetPixel(int x, int y, uint32_t data)
         y = height - 1 - y;
     }
 
-
     // Figure out where in memory to put the pixel
     location = ( (x << zoom) + vinfo.xoffset) * (vinfo.bits_per_pixel >> 3) +
                ( (y << zoom) + vinfo.yoffset) * finfo.line_length;
 
-    if (vinfo.bits_per_pixel <= 8)
+    char col[4];
+    NativeBytes(data, col);
+
+    if (StorePixel(offbuff + location, col)) {
+        // bounding box changed?
+        if (x < bbox[0]) bbox[0] = x;
+        if (y < bbox[1]) bbox[1] = y;
+        if (x > bbox[2]) bbox[2] = x;
+        if (y > bbox[3]) bbox[3] = y;
+    }
+}
+
+void cDriverFramebuffer::SetScreenRect(const uint32_t * data, int stride, int x, int y, int w, int h)
+{
+    if (!data || !offbuff || !ClipScreenRect(x, y, w, h))
+        return;
+
+    int bytes = vinfo.bits_per_pixel >> 3;
+
+    if (lineConvert)
+    {
+        SetScreenRectConverted(data, stride, x, y, w, h);
+        return;
+    }
+
+    // distance between two neighbouring display pixels in offbuff
+    int step = bytes << zoom;
+    int xs = x;
+
+    if (config->upsideDown)
     {
-        col1 = ((data & 0x00FF0000) >> (16 + 5) << 5) |   // RRRg ggbb
-               ((data & 0x0000FF00) >> ( 8 + 5) << 2) |   // rrrG GGbb
-               ((data & 0x000000FF) >> (     6)     );    // rrrg ggBB
-        if ( *(offbuff + location) != col1) {
-            changed = 1;
-            *(offbuff + location) = col1;
-            if (zoom == 1)
+        xs = width - 1 - x;
+        step = -step;
+    }
+
+    for (int yt = y; yt < y + h; yt++)
+    {
+        const uint32_t * src = data + yt * stride + x;
+        int ys = (config->upsideDown) ? height - 1 - yt : yt;
+        char * dst = offbuff + ( (xs << zoom) + vinfo.xoffset) * bytes +
+                               ( (ys << zoom) + vinfo.yoffset) * finfo.line_length;
+        int minx = -1;
+        int maxx = -1;
+
+        for (int xt = 0; xt < w; xt++, dst += step)
+        {
+            char col[4];
+            NativeBytes(src[xt], col);
+
+            if (StorePixel(dst, col))
             {
-                *(offbuff + location + 1) = col1;
-                *(offbuff + location + finfo.line_length) = col1;
-                *(offbuff + location + finfo.line_length + 1) = col1;
+                if (minx < 0)
+                    minx = xt;
+                maxx = xt;
             }
         }
-    }
-    else if (vinfo.bits_per_pixel <= 16)
-    {
-        
 
-        colraw = ((data & 0x00FF0000) >> (16 + 8 - rlen) << roff) |   // red
-                 ((data & 0x0000FF00) >> ( 8 + 8 - glen) << goff) |   // green
-                 ((data & 0x000000FF) >> ( 0 + 8 - blen) << boff);    // blue
-        col1 = colraw & 0x0000FF;
-        col2 = (colraw & 0x00FF00) >> 8;
-        if ( *(offbuff + location) != col1 || *(offbuff + location + 1) != col2 ) {
-            changed = 1;
-            *(offbuff + location) = col1;
-            *(offbuff + location + 1) = col2;
-            if (zoom == 1)
+        if (minx >= 0)
+        {
+            // convert changed span back to display coordinates
+            if (config->upsideDown)
+            {
+                int tmp = xs - maxx;
+                maxx = xs - minx;
+                minx = tmp;
+            }
+            else
             {
-                *(offbuff + location + 2) = col1;
-                *(offbuff + location + 3) = col2;
-                *(offbuff + location + finfo.line_length) = col1;
-                *(offbuff + location + finfo.line_length + 1) = col2;
-                *(offbuff + location + finfo.line_length + 2) = col1;
-                *(offbuff + location + finfo.line_length + 3) = col2;
+                minx += xs;
+                maxx += xs;
             }
+            if (minx < bbox[0]) bbox[0] = minx;
+            if (ys < bbox[1]) bbox[1] = ys;
+            if (maxx > bbox[2]) bbox[2] = maxx;
+            if (ys > bbox[3]) bbox[3] = ys;
         }
     }
-    else
+}
+
+void cDriverFramebuffer::SetScreenRectConverted(const uint32_t * data, int stride, int x, int y, int w, int h)
+{
+    int bytes = vinfo.bits_per_pixel >> 3;
+    int flags = lineFlags;
+    // leftmost display pixel of the area
+    int xs = x;
+
+    if (config->upsideDown)
     {
-        // remap graphlcd colour representation to framebuffer rep.
-        colraw = ((data & 0x00FF0000) >> (16 + 8 - rlen) << roff) |   // red
-                 ((data & 0x0000FF00) >> ( 8 + 8 - glen) << goff) |   // green
-                 ((data & 0x000000FF) >> ( 0 + 8 - blen) << boff);    // blue
-        col1 =  (colraw & 0x000000FF);
-        col2 =  (colraw & 0x0000FF00) >>  8;
-        col3 =  (colraw & 0x00FF0000) >> 16;
+        xs = width - x - w;
+        flags |= kConvReverse;
+    }
 
-        if (vinfo.bits_per_pixel == 32) {
-          colraw |= ((data & 0xFF000000) >> (24 + 8 - alen) << aoff);    // transp.
-          alpha = (colraw & 0xFF000000) >> 24;
+    for (int yt = y; yt < y + h; yt++)
+    {
+        const uint32_t * src = data + yt * stride + x;
+        int ys = (config->upsideDown) ? height - 1 - yt : yt;
+        char * dst = offbuff + ( (xs << zoom) + vinfo.xoffset) * bytes +
+                               ( (ys << zoom) + vinfo.yoffset) * finfo.line_length;
+        int minx = -1;
+        int maxx = -1;
+
+        if (bytes == 2)
+            ConvertRGB565(src, (uint16_t *) lineBuffer, w, flags);
+        else
+            ConvertRGB888(src, (uint8_t *) lineBuffer, w, flags);
+
+        if (zoom == 0)
+        {
+            int len = w * bytes;
+            if (memcmp(dst, lineBuffer, len) == 0)
+                continue;
+
+            // copy the changed span only
+            int first = 0;
+            int last = len - 1;
+            while (dst[first] == lineBuffer[first])
+                first++;
+            while (dst[last] == lineBuffer[last])
+                last--;
+            memcpy(dst + first, lineBuffer + first, last - first + 1);
+            minx = first / bytes;
+            maxx = last / bytes;
         }
-
-        if ( *(offbuff + location) != col1 || *(offbuff + location + 1) != col2 || *(offbuff + location + 2) != col3 ) {
-            int pos = 0;
-            changed = 1;
-            *(offbuff + location + pos++) = col1;
-            *(offbuff + location + pos++) = col2;
-            *(offbuff + location + pos++) = col3;
-            if (vinfo.bits_per_pixel > 24)
-                *(offbuff + location + pos++) = alpha;     /* should be transparency */
-            if (zoom == 1)
+        else
+        {
+            for (int xt = 0; xt < w; xt++)
             {
-                *(offbuff + location + pos++) = col1;
-                *(offbuff + location + pos++) = col2;
-                *(offbuff + location + pos++) = col3;
-                if (vinfo.bits_per_pixel > 24)
-                    *(offbuff + location + pos++) = alpha;
-                pos = 0;
-                *(offbuff + location + finfo.line_length + pos++) = col1;
-                *(offbuff + location + finfo.line_length + pos++) = col2;
-                *(offbuff + location + finfo.line_length + pos++) = col3;
-                if (vinfo.bits_per_pixel > 24)
-                    *(offbuff + location + finfo.line_length + pos++) = alpha;
-                *(offbuff + location + finfo.line_length + pos++) = col1;
-                *(offbuff + location + finfo.line_length + pos++) = col2;
-                *(offbuff + location + finfo.line_length + pos++) = col3;
-                if (vinfo.bits_per_pixel > 24)
-                    *(offbuff + location + finfo.line_length + pos++) = alpha;
+                if (StorePixel(dst + xt * (bytes << zoom), lineBuffer + xt * bytes))
+                {
+                    if (minx < 0)
+                        minx = xt;
+                    maxx = xt;
+                }
             }
+            if (minx < 0)
+                continue;
         }
-    }
 
-    if (changed) {
-        // bounding box changed?
-        if (x < bbox[0]) bbox[0] = x;
-        if (y < bbox[1]) bbox[1] = y;
-        if (x > bbox[2]) bbox[2] = x;
-        if (y > bbox[3]) bbox[3] = y;
+        if (xs + minx < bbox[0]) bbox[0] = xs + minx;
+        if (ys < bbox[1]) bbox[1] = ys;
+        if (xs + maxx > bbox[2]) bbox[2] = xs + maxx;
+        if (ys > bbox[3]) bbox[3] = ys;
     }
 }
 
@@ -38,9 +38,17 @@ private:
     int depth;
     uint32_t roff, boff, goff, aoff;
     uint32_t rlen, blen, glen, alen;
+    // SetScreenRect() converts whole lines if the pixel format is RGB565 or RGB888
+    bool lineConvert;
+    int lineFlags;
+    char * lineBuffer;
 
     int CheckSetup();
     void processDamage (void);
+    uint32_t NativeColour(uint32_t data) const;
+    void NativeBytes(uint32_t data, char * col) const;
+    bool StorePixel(char * location, const char * col);
+    void SetScreenRectConverted(const uint32_t * data, int stride, int x, int y, int w, int h);
 protected:
     virtual bool GetDriverFeature  (const std::string & Feature, int & value);  
 public:
@@ -51,6 +59,7 @@ public:
 
     virtual void Clear();
     virtual void SetPixel(int x, int y, uint32_t data);
+    virtual void SetScreenRect(const uint32_t * data, int stride, int x, int y, int w, int h);
     //virtual void Set8Pixels(int x, int y, unsigned char data);
     virtual void Refresh(bool refreshAll = false);
 };
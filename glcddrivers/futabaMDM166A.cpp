@@ -395,7 +395,7 @@ void cDriverFutabaMDM166A::Refresh(bool refreshAll)
 	if(s < 0)
 		return;
     if (s > 0)
-        refreshAll = true;
+        ForceRefreshAll(refreshAll);
 
     for (yb = 0; yb < m_iSizeYb; ++yb)
         for (x = 0; x < nWidth; ++x)
@@ -413,7 +413,7 @@ void cDriverFutabaMDM166A::Refresh(bool refreshAll)
     m_nRefreshCounter = (m_nRefreshCounter + 1) % (config->refreshDisplay ? config->refreshDisplay : 50);
 
     if (!refreshAll && !m_nRefreshCounter)
-        refreshAll = true;
+        ForceRefreshAll(refreshAll);
 
     if (refreshAll || doRefresh)
     {
@@ -473,14 +473,15 @@ void cDriverGU126X64D_K610A4::Refresh(bool refreshAll)
     if (checkSetup() > 0)
     {
         syslog(LOG_DEBUG, "%s:   Refresh() checkSetup() returned != 0 -> refreshAll = true", config->name.c_str());
-        refreshAll = true;
+        ForceRefreshAll(refreshAll);
     } // if
 
     // refresh-counter exceeded -> refresh all
     if (!refreshAll && config->refreshDisplay != 0)
     {
         myRefreshCounter = (myRefreshCounter + 1) % config->refreshDisplay;
-        refreshAll = myRefreshCounter == 0;
+        if (myRefreshCounter == 0)
+            ForceRefreshAll(refreshAll);
 
         if (refreshAll && isLogEnabled(LL_REFRESH_START))
         {
@@ -964,5 +965,10 @@ bool cDriverGU126X64D_K610A4::isLogEnabled(int theLevel) const
 } // cDriverGU126X64D_K610A4::isLogEnabled()
 
 //-----------------------------------------------------------------------------
+bool cDriverGU126X64D_K610A4::GetIOStats(uint64_t & bytes, uint64_t & syscalls) const
+{
+    return GetPortIOStats(port, bytes, syscalls);
+}
+
 } // end of namespace
 
@@ -383,7 +383,7 @@ void cDriverGU140X32F::Refresh(bool refreshAll)
     int maxYb = 0;
 
     if (CheckSetup() > 0)
-        refreshAll = true;
+        ForceRefreshAll(refreshAll);
 
     for (yb = 0; yb < m_iSizeYb; ++yb)
         for (x = 0; x < width; ++x)
@@ -403,7 +403,7 @@ void cDriverGU140X32F::Refresh(bool refreshAll)
     m_nRefreshCounter = (m_nRefreshCounter + 1) % config->refreshDisplay;
 
     if (!refreshAll && !m_nRefreshCounter)
-        refreshAll = true;
+        ForceRefreshAll(refreshAll);
 
     if (refreshAll || doRefresh)
     {
@@ -445,4 +445,9 @@ void cDriverGU140X32F::Refresh(bool refreshAll)
     }
 }
 
+bool cDriverGU140X32F::GetIOStats(uint64_t & bytes, uint64_t & syscalls) const
+{
+    return GetPortIOStats(port, bytes, syscalls);
+}
+
 } // end of namespace
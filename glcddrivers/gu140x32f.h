@@ -63,6 +63,7 @@ public:
     virtual void SetPixel(int x, int y, uint32_t data);
     //virtual void Set8Pixels(int x, int y, unsigned char data);
     virtual void Refresh(bool refreshAll = false);
+    virtual bool GetIOStats(uint64_t & bytes, uint64_t & syscalls) const;
 
     virtual void SetBrightness(unsigned int percent);
 };
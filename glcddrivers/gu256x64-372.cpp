@@ -27,6 +27,7 @@
 #include <sys/time.h>
 #include <cstring>
 
+#include "colorconv.h"
 #include "common.h"
 #include "config.h"
 #include "gu256x64-372.h"
@@ -370,6 +371,27 @@ void cDriverGU256X64_372::SetPixel(int x, int y, uint32_t data)
         m_pDrawMem[x][y/8] &= ( 0xFF ^ c );
 }
 
+void cDriverGU256X64_372::SetScreen1BPP(const unsigned char * data, int wid, int hgt, int lineSize)
+{
+    int x = 0, y = 0;
+
+    if (!m_pDrawMem || !data || !ClipScreenRect(x, y, wid, hgt))
+        return;
+
+    // whole blocks of 8 x 8 pixels are transposed into the vertical bytes of the display,
+    // the pixels of partly covered blocks are set one by one
+    int blockRows = PackMonoColumns(data, wid, hgt, lineSize, m_pDrawMem, width, height,
+                                    config->upsideDown ? kConvReverse : 0);
+    int blockCols = wid / 8 * 8;
+
+    for (int yt = 0; yt < hgt; yt++)
+    {
+        const unsigned char * line = data + yt * lineSize;
+        for (int xt = (yt < blockRows) ? blockCols : 0; xt < wid; xt++)
+            cDriverGU256X64_372::SetPixel(xt, yt, (line[xt >> 3] & (0x80 >> (xt & 7))) ? GRAPHLCD_White : GRAPHLCD_Black);
+    }
+}
+
 #if 0
 void cDriverGU256X64_372::Set8Pixels(int x, int y, unsigned char data)
 {
@@ -400,7 +422,7 @@ void cDriverGU256X64_372::Refresh(bool refreshAll)
     int maxYb = 0;
 
     if (CheckSetup() > 0)
-        refreshAll = true;
+        ForceRefreshAll(refreshAll);
 
     for (xb = 0; xb < width; ++xb)
     {
@@ -420,7 +442,7 @@ void cDriverGU256X64_372::Refresh(bool refreshAll)
 
     m_nRefreshCounter = (m_nRefreshCounter + 1) % config->refreshDisplay;
     if (!refreshAll && !m_nRefreshCounter)
-        refreshAll = true;
+        ForceRefreshAll(refreshAll);
 
     if (refreshAll || doRefresh)
     {
@@ -455,4 +477,9 @@ void cDriverGU256X64_372::Refresh(bool refreshAll)
     }
 }
 
+bool cDriverGU256X64_372::GetIOStats(uint64_t & bytes, uint64_t & syscalls) const
+{
+    return GetPortIOStats(port, bytes, syscalls);
+}
+
 } // end of namespace
@@ -67,8 +67,10 @@ public:
 
     virtual void Clear();
     virtual void SetPixel(int x, int y, uint32_t data);
+    virtual void SetScreen1BPP(const unsigned char *data, int width, int height, int lineSize);
     //virtual void Set8Pixels(int x, int y, unsigned char data);
     virtual void Refresh(bool refreshAll = false);
+    virtual bool GetIOStats(uint64_t & bytes, uint64_t & syscalls) const;
 
     virtual void SetBrightness(unsigned int percent);
 };
@@ -33,6 +33,7 @@
 #include <sys/time.h>
 #include <cstring>
 
+#include "colorconv.h"
 #include "common.h"
 #include "config.h"
 #include "gu256x64-3900.h"
@@ -106,7 +107,8 @@ static const int kInterfaceSerial   = 1; // serial mode
 cDriverGU256X64_3900::cDriverGU256X64_3900(cDriverConfig * config)
 :   cDriver(config)
 {
-    portFd = -1;
+    port = NULL;
+    serialPort = NULL;
     m_nRefreshCounter = 0;
 }
 
@@ -218,6 +220,10 @@ int cDriverGU256X64_3900::Init()
         // claim is in InitParallelPort
         port->Release();
     }
+    else
+    {
+        serialPort->Flush();
+    }
 
     *oldConfig = *config;
 
@@ -252,13 +258,11 @@ int cDriverGU256X64_3900::DeInit()
         delete[] m_pDrawMem;
     }
 
-    if (interface == kInterfaceSerial)
+    if (serialPort)
     {
-        if (portFd >= 0)
-        {
-            close(portFd);
-            portFd = -1;
-        }
+        serialPort->Close();
+        delete serialPort;
+        serialPort = NULL;
     }
     if (port)
     {
@@ -307,24 +311,15 @@ int cDriverGU256X64_3900::InitSerialPort()
         return -1;
     }
 
-    portFd = open(config->device.c_str(), O_RDWR | O_NOCTTY);
-    if (portFd >= 0)
-    {
-        struct termios options;
-        tcgetattr(portFd, &options);
-        cfsetispeed(&options, B38400);
-        cfsetospeed(&options, B38400);
-        options.c_cflag &= ~CSIZE;
-        options.c_cflag &= ~PARENB;
-        options.c_cflag &= ~CSTOPB;
-        options.c_cflag |= CS8;
-        tcsetattr(portFd, TCSANOW, &options);
-    }
-    else
+    serialPort = new cSerialPort();
+    if (serialPort->Open(config->device.c_str()) != 0)
     {
         syslog(LOG_ERR, "%s: unable to initialize gu256x64-3900!\n", config->name.c_str());
+        delete serialPort;
+        serialPort = NULL;
         return -1;
     }
+    serialPort->SetBaudRate(38400);
     return 0;
 }
 
@@ -461,6 +456,8 @@ void cDriverGU256X64_3900::SetBrightness(unsigned int percent)
     }
     if (interface == kInterfaceParallel)
         port->Release();
+    else
+        serialPort->Flush();
 }
 
 void cDriverGU256X64_3900::WriteParallel(unsigned char data)
@@ -487,7 +484,8 @@ void cDriverGU256X64_3900::WriteParallel(unsigned char data)
 
 void cDriverGU256X64_3900::WriteSerial(unsigned char data)
 {
-    write(portFd, &data, 1);
+    // buffered, sent by Flush()
+    serialPort->WriteData(data);
 }
 
 void cDriverGU256X64_3900::Write(unsigned char data)
@@ -524,6 +522,27 @@ void cDriverGU256X64_3900::SetPixel(int x, int y, uint32_t data)
         m_pDrawMem[x][y/8] &= ( 0xFF ^ c );
 }
 
+void cDriverGU256X64_3900::SetScreen1BPP(const unsigned char * data, int wid, int hgt, int lineSize)
+{
+    int x = 0, y = 0;
+
+    if (!m_pDrawMem || !data || !ClipScreenRect(x, y, wid, hgt))
+        return;
+
+    // whole blocks of 8 x 8 pixels are transposed into the vertical bytes of the display,
+    // the pixels of partly covered blocks are set one by one
+    int blockRows = PackMonoColumns(data, wid, hgt, lineSize, m_pDrawMem, width, height,
+                                    config->upsideDown ? kConvReverse : 0);
+    int blockCols = wid / 8 * 8;
+
+    for (int yt = 0; yt < hgt; yt++)
+    {
+        const unsigned char * line = data + yt * lineSize;
+        for (int xt = (yt < blockRows) ? blockCols : 0; xt < wid; xt++)
+            cDriverGU256X64_3900::SetPixel(xt, yt, (line[xt >> 3] & (0x80 >> (xt & 7))) ? GRAPHLCD_White : GRAPHLCD_Black);
+    }
+}
+
 #if 0
 void cDriverGU256X64_3900::Set8Pixels(int x, int y, unsigned char data)
 {
@@ -554,7 +573,7 @@ void cDriverGU256X64_3900::Refresh(bool refreshAll)
     int maxYb = 0;
 
     if (CheckSetup() > 0)
-        refreshAll = true;
+        ForceRefreshAll(refreshAll);
 
     for (xb = 0; xb < width; ++xb)
     {
@@ -576,7 +595,7 @@ void cDriverGU256X64_3900::Refresh(bool refreshAll)
     {
         m_nRefreshCounter = (m_nRefreshCounter + 1) % config->refreshDisplay;
         if (!refreshAll && !m_nRefreshCounter)
-            refreshAll = true;
+            ForceRefreshAll(refreshAll);
     }
 
     if (refreshAll || doRefresh)
@@ -638,7 +657,8 @@ void cDriverGU256X64_3900::Refresh(bool refreshAll)
             }
             // parallel port writing is busy waiting - with realtime priority you
             // can lock the system - so don't be so greedy ;)
-            if ((xb % 32) == 31)
+            // the serial output is buffered until the end, pausing would only delay it
+            if (interface == kInterfaceParallel && (xb % 32) == 31)
             {
                 uSleep(1000);
             }
@@ -646,7 +666,16 @@ void cDriverGU256X64_3900::Refresh(bool refreshAll)
 
         if (interface == kInterfaceParallel)
             port->Release();
+        else
+            serialPort->Flush();
     }
 }
 
+bool cDriverGU256X64_3900::GetIOStats(uint64_t & bytes, uint64_t & syscalls) const
+{
+    if (interface == kInterfaceParallel)
+        return GetPortIOStats(port, bytes, syscalls);
+    return GetPortIOStats(serialPort, bytes, syscalls);
+}
+
 } // end of namespace
@@ -35,11 +35,12 @@ namespace GLCD
 
 class cDriverConfig;
 class cParallelPort;
+class cSerialPort;
 
 class cDriverGU256X64_3900 : public cDriver
 {
     cParallelPort * port;
-    int portFd;
+    cSerialPort * serialPort;
 
     int m_iSizeYb;
     int m_nRefreshCounter;
@@ -74,8 +75,10 @@ public:
 
     virtual void Clear();
     virtual void SetPixel(int x, int y, uint32_t data);
+    virtual void SetScreen1BPP(const unsigned char *data, int width, int height, int lineSize);
     //virtual void Set8Pixels(int x, int y, unsigned char data);
     virtual void Refresh(bool refreshAll = false);
+    virtual bool GetIOStats(uint64_t & bytes, uint64_t & syscalls) const;
 
     virtual void SetBrightness(unsigned int percent);
 };
@@ -74,9 +74,7 @@ cDriverHD61830::~cDriverHD61830()
 
 int cDriverHD61830::Init()
 {
-    int i;
     int x;
-    struct timeval tv1, tv2;
 
     width = config->width;
     if (width <= 0)
@@ -138,15 +136,14 @@ int cDriverHD61830::Init()
     }
 
     syslog(LOG_DEBUG, "%s: benchmark started.\n", config->name.c_str());
-    gettimeofday(&tv1, 0);
-    for (i = 0; i < 1000; i++)
-    {
-        port->WriteData(1 % 0x100);
-    }
-    gettimeofday(&tv2, 0);
+    timeForPortCmdInNs = port->MeasureWriteTime(1000);
     if (useSleepInit)
         nSleepDeInit();
-    timeForPortCmdInNs = (tv2.tv_sec-tv1.tv_sec) * 1000000 + (tv2.tv_usec-tv1.tv_usec);
+    port->SetSleepInit(useSleepInit);
+    // the calibration spins and sleeps for a while, only needed by the calibrated method
+    if (Config.waitMethod == kWaitCalibrated)
+        GetWaitTimings(config->timings);
+    config->timings.portAccess = timeForPortCmdInNs;
     syslog(LOG_DEBUG, "%s: benchmark stopped. Time for Port Command: %ldns\n", config->name.c_str(), timeForPortCmdInNs);
 
     // initialize graphic mode
@@ -234,39 +231,38 @@ int cDriverHD61830::InitGraphic()
 
 void cDriverHD61830::Write(unsigned char cmd, unsigned char data)
 {
-    if (useSleepInit)
-        nSleepInit();
+    // queued, executed when the port is released
 
     // set RS high (instruction), RW low (write) and E low
-    port->WriteControl(RSHI | RWLO | ENLO);
-    nSleep(140 - timeForPortCmdInNs + 100 * config->adjustTiming);
+    port->QueueControl(RSHI | RWLO | ENLO);
+    port->QueueDelay(140 - timeForPortCmdInNs + 100 * config->adjustTiming);
 
     // Output the actual command
-    port->WriteData(cmd);
+    port->QueueData(cmd);
 
     // set E high
-    port->WriteControl(RSHI | RWLO | ENHI);
-    nSleep(450 - timeForPortCmdInNs + 100 * config->adjustTiming);
+    port->QueueControl(RSHI | RWLO | ENHI);
+    port->QueueDelay(450 - timeForPortCmdInNs + 100 * config->adjustTiming);
 
     // set E low
-    port->WriteControl(RSHI | RWLO | ENLO);
-    nSleep(450 - timeForPortCmdInNs + 100 * config->adjustTiming);
+    port->QueueControl(RSHI | RWLO | ENLO);
+    port->QueueDelay(450 - timeForPortCmdInNs + 100 * config->adjustTiming);
 
 
     // set RS low (data), RW low (write) and E low
-    port->WriteControl(RSLO | RWLO | ENLO);
-    nSleep(140 - timeForPortCmdInNs + 100 * config->adjustTiming);
+    port->QueueControl(RSLO | RWLO | ENLO);
+    port->QueueDelay(140 - timeForPortCmdInNs + 100 * config->adjustTiming);
 
     // Output the actual data
-    port->WriteData(data);
+    port->QueueData(data);
 
     // set E high
-    port->WriteControl(RSLO | RWLO | ENHI);
-    nSleep(450 - timeForPortCmdInNs + 100 * config->adjustTiming);
+    port->QueueControl(RSLO | RWLO | ENHI);
+    port->QueueDelay(450 - timeForPortCmdInNs + 100 * config->adjustTiming);
 
     // set E low
-    port->WriteControl(RSLO | RWLO | ENLO);
-    nSleep(450 - timeForPortCmdInNs + 100 * config->adjustTiming);
+    port->QueueControl(RSLO | RWLO | ENLO);
+    port->QueueDelay(450 - timeForPortCmdInNs + 100 * config->adjustTiming);
 
     switch (cmd)
     {
@@ -279,19 +275,17 @@ void cDriverHD61830::Write(unsigned char cmd, unsigned char data)
         case DSAH:
         case CACL:
         case CACH:
-            nSleep(4000 - std::max(450l, timeForPortCmdInNs) + 100 * config->adjustTiming);
+            port->QueueDelay(4000 - std::max(450l, timeForPortCmdInNs) + 100 * config->adjustTiming);
             break;
         case WDDI:
         case RDDI:
-            nSleep(6000 - std::max(450l, timeForPortCmdInNs) + 100 * config->adjustTiming);
+            port->QueueDelay(6000 - std::max(450l, timeForPortCmdInNs) + 100 * config->adjustTiming);
             break;
         case CBIT:
         case SBIT:
-            nSleep(36000 - std::max(450l, timeForPortCmdInNs) + 100 * config->adjustTiming);
+            port->QueueDelay(36000 - std::max(450l, timeForPortCmdInNs) + 100 * config->adjustTiming);
             break;
     }
-    if (useSleepInit)
-        nSleepDeInit();
 }
 
 void cDriverHD61830::Clear()
@@ -350,13 +344,13 @@ void cDriverHD61830::Refresh(bool refreshAll)
     int pos = 0;
 
     if (CheckSetup() > 0)
-        refreshAll = true;
+        ForceRefreshAll(refreshAll);
 
     if (config->refreshDisplay > 0)
     {
         refreshCounter = (refreshCounter + 1) % config->refreshDisplay;
         if (!refreshAll && !refreshCounter)
-            refreshAll = true;
+            ForceRefreshAll(refreshAll);
     }
 
     port->Claim();
@@ -412,4 +406,9 @@ void cDriverHD61830::Refresh(bool refreshAll)
     port->Release();
 }
 
+bool cDriverHD61830::GetIOStats(uint64_t & bytes, uint64_t & syscalls) const
+{
+    return GetPortIOStats(port, bytes, syscalls);
+}
+
 } // end of namespace
@@ -19,6 +19,7 @@
 
 #include "common.h"
 #include "config.h"
+#include "colorconv.h"
 #include "ili9341.h"
 
 
@@ -276,39 +277,65 @@ void cDriverILI9341::SetPixel(int x, int y, uint32_t data)
     newLCD[y * width + x] = data;
 }
 
+void cDriverILI9341::SetScreenRect(const uint32_t * data, int stride, int x, int y, int w, int h)
+{
+    if (!data || !ClipScreenRect(x, y, w, h))
+        return;
+
+    for (int yt = y; yt < y + h; yt++)
+    {
+        const uint32_t * src = data + yt * stride + x;
+
+        if (config->upsideDown)
+        {
+            uint32_t * dst = &newLCD[(height - 1 - yt) * width + (width - 1 - x)];
+            for (int xt = 0; xt < w; xt++)
+                *dst-- = src[xt];
+        }
+        else
+        {
+            memcpy(&newLCD[yt * width + x], src, w * sizeof(uint32_t));
+        }
+    }
+}
+
 
 void cDriverILI9341::Refresh(bool refreshAll)
 {
     int y;
 
     if (CheckSetup() == 1)
-        refreshAll = true;
+        ForceRefreshAll(refreshAll);
 
     if (config->refreshDisplay > 0)
     {
         refreshCounter = (refreshCounter + 1) % config->refreshDisplay;
         if (!refreshAll && !refreshCounter)
-            refreshAll = true;
+            ForceRefreshAll(refreshAll);
     }
 
-    refreshAll = true;
+    ForceRefreshAll(refreshAll);
     if (refreshAll)
     {
         SetWindow(0, 0, height - 1, width - 1);
         WriteCommand(kCmdMemoryWrite);
         for (y = 0; y < width; y++)
         {
-            uint8_t line[height * 2];
+            uint32_t column[height];
+            uint16_t line[height];
             uint32_t * pixel = &newLCD[width - 1 - y];
 
-            for (int x = 0; x < (height * 2); x += 2)
+            for (int x = 0; x < height; x++)
             {
-                line[x] = ((*pixel & 0x00F80000) >> 16)
-                        | ((*pixel & 0x0000E000) >> 13);
-                line[x + 1] = ((*pixel & 0x00001C00) >> 5)
-                            | ((*pixel & 0x000000F8) >> 3);
+                column[x] = *pixel;
                 pixel += width;
             }
+            // the controller expects the high byte first
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+            ConvertRGB565(column, line, height, kConvByteSwap);
+#else
+            ConvertRGB565(column, line, height);
+#endif
             WriteData((uint8_t *) line, height * 2);
         }
         memcpy(oldLCD, newLCD, width * height * sizeof(uint32_t));
@@ -43,6 +43,7 @@ public:
 
     virtual void Clear();
     virtual void SetPixel(int x, int y, uint32_t data);
+    virtual void SetScreenRect(const uint32_t * data, int stride, int x, int y, int w, int h);
     //virtual void Set8Pixels(int x, int y, unsigned char data);
     virtual void Refresh(bool refreshAll = false);
     virtual void SetBrightness(unsigned int percent);
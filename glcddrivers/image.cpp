@@ -108,6 +108,7 @@ int cDriverImage::CheckSetup()
 void cDriverImage::Clear()
 {
     memset(newLCD, 0, lineSize * height);
+    MarkDirty();
 }
 
 #if 0
@@ -150,6 +151,7 @@ void cDriverImage::SetPixel(int x, int y, uint32_t data)
         newLCD[y * cols + (x >> 3)] |= ( 1 << pos );
     else
         newLCD[y * cols + (x >> 3)] &= ( 0xFF ^ ( 1 << pos) );
+    MarkDirty(x, y);
 }
 
 void cDriverImage::Refresh(bool refreshAll)
@@ -165,12 +167,16 @@ void cDriverImage::Refresh(bool refreshAll)
     if (CheckSetup() > 0)
         refresh = true;
 
-    for (i = 0; i < lineSize * height; i++)
+    // only lines that were touched since the last refresh can differ
+    if (!refresh && !dirtyArea.IsEmpty())
     {
-        if (newLCD[i] != oldLCD[i])
+        for (i = dirtyArea.y1 * lineSize; i < (dirtyArea.y2 + 1) * lineSize; i++)
         {
-            refresh = true;
-            break;
+            if (newLCD[i] != oldLCD[i])
+            {
+                refresh = true;
+                break;
+            }
         }
     }
 
@@ -189,11 +195,16 @@ void cDriverImage::Refresh(bool refreshAll)
                 oldLCD[i] = newLCD[i];
             }
             fclose(fp);
+            ResetDirty();
         }
         counter++;
         if (counter > 99999)
             counter = 0;
     }
+    else
+    {
+        ResetDirty();
+    }
 }
 
 } // end of namespace
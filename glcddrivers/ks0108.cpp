@@ -46,6 +46,8 @@ cDriverKS0108::cDriverKS0108(cDriverConfig * config)
 {
     port = new cParallelPort();
 
+    LCD_sent = NULL;
+    sentValid = false;
     refreshCounter = 0;
     timeForLCDInNs = 50;
     control = 1;
@@ -59,8 +61,6 @@ cDriverKS0108::~cDriverKS0108()
 int cDriverKS0108::Init()
 {
     int x;
-    int i;
-    struct timeval tv1, tv2;
 
     if (config->width <= 128) {
         width = 128;
@@ -134,6 +134,14 @@ int cDriverKS0108::Init()
             memset(LCD_page[x], 0, (height + 7) / 8);
         }
     }
+    // the paged contents last sent to the display
+    LCD_sent = new unsigned char *[width];
+    for (x = 0; x < width; x++)
+    {
+        LCD_sent[x] = new unsigned char[(height + 7) / 8];
+        memset(LCD_sent[x], 0, (height + 7) / 8);
+    }
+    sentValid = false;
 
     if (config->device == "")
     {
@@ -160,15 +168,14 @@ int cDriverKS0108::Init()
     }
 
     syslog(LOG_DEBUG, "%s: benchmark started.\n", config->name.c_str());
-    gettimeofday(&tv1, 0);
-    for (i = 0; i < 1000; i++)
-    {
-        port->WriteData(i % 0x100);
-    }
-    gettimeofday(&tv2, 0);
+    timeForPortCmdInNs = port->MeasureWriteTime(1000);
     if (useSleepInit)
         nSleepDeInit();
-    timeForPortCmdInNs = (tv2.tv_sec - tv1.tv_sec) * 1000000 + (tv2.tv_usec - tv1.tv_usec);
+    port->SetSleepInit(useSleepInit);
+    // the calibration spins and sleeps for a while, only needed by the calibrated method
+    if (Config.waitMethod == kWaitCalibrated)
+        GetWaitTimings(config->timings);
+    config->timings.portAccess = timeForPortCmdInNs;
     syslog(LOG_DEBUG, "%s: benchmark stopped. Time for Command: %ldns\n", config->name.c_str(), timeForPortCmdInNs);
 
     // initialize graphic mode
@@ -207,6 +214,15 @@ int cDriverKS0108::DeInit()
         }
         delete[] LCD_page;
     }
+    if (LCD_sent)
+    {
+        for (x = 0; x < width; x++)
+        {
+            delete[] LCD_sent[x];
+        }
+        delete[] LCD_sent;
+        LCD_sent = NULL;
+    }
     if (port->Close() != 0)
         return -1;
     return 0;
@@ -264,158 +280,50 @@ int cDriverKS0108::InitGraphic()
     return 0;
 }
 
-void cDriverKS0108::KS0108Cmd(unsigned char data, int cs)
+void cDriverKS0108::KS0108Write(unsigned char cd, unsigned char data, int cs)
 {
-    if (useSleepInit)
-        nSleepInit();
+    int chip;
     switch (cs) {
-        case 1:
-            if (control == 1)
-                port->WriteControl(CDHI | CS1 | CELO);
-            else
-                port->WriteControl(CDHI | CS1 | CEHI);
-            nSleep((timeForLCDInNs + timeForPortCmdInNs) + 100 * config->adjustTiming);
-            port->WriteData(data);
-            nSleep((timeForLCDInNs + timeForPortCmdInNs) + 100 * config->adjustTiming);
-            if (control == 1)
-            {
-                port->WriteControl(CDHI | CS1 | CEHI);
-                nSleep((timeForLCDInNs + timeForPortCmdInNs) + 100 * config->adjustTiming);
-            }
-            port->WriteControl(CDHI | CS1 | CELO);
-            nSleep((timeForLCDInNs + timeForPortCmdInNs) + 100 * config->adjustTiming);
-            break;
-        case 2:
-            if (control == 1)
-                port->WriteControl(CDHI | CS2 | CELO);
-            else
-                port->WriteControl(CDHI | CS2 | CEHI);
-            nSleep((timeForLCDInNs + timeForPortCmdInNs) + 100 * config->adjustTiming);
-            port->WriteData(data);
-            nSleep((timeForLCDInNs + timeForPortCmdInNs) + 100 * config->adjustTiming);
-            if (control == 1)
-            {
-                port->WriteControl(CDHI | CS2 | CEHI);
-                nSleep((timeForLCDInNs + timeForPortCmdInNs) + 100 * config->adjustTiming);
-            }
-            port->WriteControl(CDHI | CS2 | CELO);
-            nSleep((timeForLCDInNs + timeForPortCmdInNs) + 100 * config->adjustTiming);
-            break;
-        case 3:
-            if (control == 1)
-                port->WriteControl(CDHI | CS3 | CELO);
-            else
-                port->WriteControl(CDHI | CS3 | CEHI);
-            nSleep((timeForLCDInNs + timeForPortCmdInNs) + 100 * config->adjustTiming);
-            port->WriteData(data);
-            nSleep((timeForLCDInNs + timeForPortCmdInNs) + 100 * config->adjustTiming);
-            if (control == 1)
-            {
-                port->WriteControl(CDHI | CS3 | CEHI);
-                nSleep((timeForLCDInNs + timeForPortCmdInNs) + 100 * config->adjustTiming);
-            }
-            port->WriteControl(CDHI | CS3 | CELO);
-            nSleep((timeForLCDInNs + timeForPortCmdInNs) + 100 * config->adjustTiming);
-            break;
-        case 4:
-            if (control == 1)
-                port->WriteControl(CDHI | CS4 | CELO);
-            else
-                port->WriteControl(CDHI | CS4 | CEHI);
-            nSleep((timeForLCDInNs + timeForPortCmdInNs) + 100 * config->adjustTiming);
-            port->WriteData(data);
-            nSleep((timeForLCDInNs + timeForPortCmdInNs) + 100 * config->adjustTiming);
-            if (control == 1)
-            {
-                port->WriteControl(CDHI | CS4 | CEHI);
-                nSleep((timeForLCDInNs + timeForPortCmdInNs) + 100 * config->adjustTiming);
-            }
-            port->WriteControl(CDHI | CS4 | CELO);
-            nSleep((timeForLCDInNs + timeForPortCmdInNs) + 100 * config->adjustTiming);
-            break;
+        case 1: chip = CS1; break;
+        case 2: chip = CS2; break;
+        case 3: chip = CS3; break;
+        case 4: chip = CS4; break;
+        default: return;
     }
-    if (useSleepInit)
-        nSleepDeInit();
+    long delay = (timeForLCDInNs + timeForPortCmdInNs) + 100 * config->adjustTiming;
+
+    // queued, executed when the port is released
+    if (control == 1)
+        port->QueueControl(cd | chip | CELO);
+    else
+        port->QueueControl(cd | chip | CEHI);
+    port->QueueDelay(delay);
+    port->QueueData(data);
+    port->QueueDelay(delay);
+    if (control == 1)
+    {
+        port->QueueControl(cd | chip | CEHI);
+        port->QueueDelay(delay);
+    }
+    port->QueueControl(cd | chip | CELO);
+    port->QueueDelay(delay);
+}
+
+void cDriverKS0108::KS0108Cmd(unsigned char data, int cs)
+{
+    KS0108Write(CDHI, data, cs);
 }
 
 void cDriverKS0108::KS0108Data(unsigned char data, int cs)
 {
-    if (useSleepInit)
-        nSleepInit();
-    switch (cs) {
-        case 1:
-            if (control == 1)
-                port->WriteControl(CDLO | CS1 | CELO);
-            else
-                port->WriteControl(CDLO | CS1 | CEHI);
-            nSleep((timeForLCDInNs + timeForPortCmdInNs) + 100 * config->adjustTiming);
-            port->WriteData(data);
-            nSleep((timeForLCDInNs + timeForPortCmdInNs) + 100 * config->adjustTiming);
-            if (control == 1)
-            {
-                port->WriteControl(CDLO | CS1 | CEHI);
-                nSleep((timeForLCDInNs + timeForPortCmdInNs) + 100 * config->adjustTiming);
-            }
-            port->WriteControl(CDLO | CS1 | CELO);
-            nSleep((timeForLCDInNs + timeForPortCmdInNs) + 100 * config->adjustTiming);
-            break;
-        case 2:
-            if (control == 1)
-                port->WriteControl(CDLO | CS2 | CELO);
-            else
-                port->WriteControl(CDLO | CS2 | CEHI);
-            nSleep((timeForLCDInNs + timeForPortCmdInNs) + 100 * config->adjustTiming);
-            port->WriteData(data);
-            nSleep((timeForLCDInNs + timeForPortCmdInNs) + 100 * config->adjustTiming);
-            if (control == 1)
-            {
-                port->WriteControl(CDLO | CS2 | CEHI);
-                nSleep((timeForLCDInNs + timeForPortCmdInNs) + 100 * config->adjustTiming);
-            }
-            port->WriteControl(CDLO | CS2 | CELO);
-            nSleep((timeForLCDInNs + timeForPortCmdInNs) + 100 * config->adjustTiming);
-            break;
-        case 3:
-            if (control == 1)
-                port->WriteControl(CDLO | CS3 | CELO);
-            else
-                port->WriteControl(CDLO | CS3 | CEHI);
-            nSleep((timeForLCDInNs + timeForPortCmdInNs) + 100 * config->adjustTiming);
-            port->WriteData(data);
-            nSleep((timeForLCDInNs + timeForPortCmdInNs) + 100 * config->adjustTiming);
-            if (control == 1)
-            {
-                port->WriteControl(CDLO | CS3 | CEHI);
-                nSleep((timeForLCDInNs + timeForPortCmdInNs) + 100 * config->adjustTiming);
-            }
-            port->WriteControl(CDLO | CS3 | CELO);
-            nSleep((timeForLCDInNs + timeForPortCmdInNs) + 100 * config->adjustTiming);
-            break;
-        case 4:
-            if (control == 1)
-                port->WriteControl(CDLO | CS4 | CELO);
-            else
-                port->WriteControl(CDLO | CS4 | CEHI);
-            nSleep((timeForLCDInNs + timeForPortCmdInNs) + 100 * config->adjustTiming);
-            port->WriteData(data);
-            nSleep((timeForLCDInNs + timeForPortCmdInNs) + 100 * config->adjustTiming);
-            if (control == 1)
-            {
-                port->WriteControl(CDLO | CS4 | CEHI);
-                nSleep((timeForLCDInNs + timeForPortCmdInNs) + 100 * config->adjustTiming);
-            }
-            port->WriteControl(CDLO | CS4 | CELO);
-            nSleep((timeForLCDInNs + timeForPortCmdInNs) + 100 * config->adjustTiming);
-            break;
-    }
-    if (useSleepInit)
-        nSleepDeInit();
+    KS0108Write(CDLO, data, cs);
 }
 
 void cDriverKS0108::Clear()
 {
     for (int x = 0; x < (width + 7) / 8; x++)
         memset(LCD[x], 0, height);
+    MarkDirty();
 }
 
 
@@ -437,6 +345,7 @@ void cDriverKS0108::SetPixel(int x, int y, uint32_t data)
         LCD[x / 8][y] |= (1 << pos);
     else
         LCD[x / 8][y] &= ( 0xFF ^ (1 << pos) );
+    MarkDirty(x, y);
 }
 
 
@@ -468,149 +377,111 @@ void cDriverKS0108::Refresh(bool refreshAll)
     unsigned char dByte, oneBlock[8];
 
     if (CheckSetup() > 0)
-        refreshAll = true;
+        ForceRefreshAll(refreshAll);
 
     if (config->refreshDisplay > 0)
     {
         refreshCounter = (refreshCounter + 1) % config->refreshDisplay;
         if (!refreshAll && !refreshCounter)
-            refreshAll=true;
+            ForceRefreshAll(refreshAll);
     }
 
-    refreshAll = true; // differential update is not yet supported
+    // nothing is known about the display contents before the first refresh
+    if (!sentValid)
+        ForceRefreshAll(refreshAll);
 
-    if (refreshAll)
-    {
-        // draw all
+    if (!refreshAll && dirtyArea.IsEmpty())
+        return;
 
-        // convert the linear lcd array to the paged array for the display
-        for (y = 0; y < (height + 7) / 8; y++)
+    // convert the changed part of the linear lcd array to the paged array for the display
+    int xFirst = 0;
+    int xLast = (width + 7) / 8 - 1;
+    int yFirst = 0;
+    int yLast = (height + 7) / 8 - 1;
+    if (!refreshAll)
+    {
+        xFirst = dirtyArea.x1 / 8;
+        xLast = dirtyArea.x2 / 8;
+        yFirst = dirtyArea.y1 / 8;
+        yLast = dirtyArea.y2 / 8;
+    }
+    for (y = yFirst; y <= yLast; y++)
+    {
+        for (x = xFirst; x <= xLast; x++)
         {
-            for (x = 0; x < (width + 7) / 8; x++)
+            for (yy = 0; yy < 8; yy++)
+            {
+                oneBlock[yy] = LCD[x][yy + (y * 8)] ^ (config->invert ? 0xff : 0x00);
+            }
+            for (xx = 0; xx < 8; xx++)
             {
+                dByte = 0;
                 for (yy = 0; yy < 8; yy++)
                 {
-                    oneBlock[yy] = LCD[x][yy + (y * 8)] ^ (config->invert ? 0xff : 0x00);
-                }
-                for (xx = 0; xx < 8; xx++)
-                {
-                    dByte = 0;
-                    for (yy = 0; yy < 8; yy++)
+                    if (oneBlock[yy] & bitmask[xx])
                     {
-                        if (oneBlock[yy] & bitmask[xx])
-                        {
-                            dByte += (1 << yy);
-                        }
+                        dByte += (1 << yy);
                     }
-                    LCD_page[x * 8 + xx][y] = dByte;
                 }
+                LCD_page[x * 8 + xx][y] = dByte;
             }
         }
-
-        port->Claim();
-
-        if (width == 128 && height == 64) {
-            for (y = 0; y < 64/8; y++) {
-                KS0108Cmd(SEPA + y, 1);
-                KS0108Cmd(SEAD, 1);
-
-                for (x = 0; x < 64; x++) {
-                    KS0108Data(LCD_page[x][y], 1);
-                }
-            }
-
-            for (y = 0; y < 64/8; y++) {
-                KS0108Cmd(SEPA + y, 2);
-                KS0108Cmd(SEAD, 2);
-
-                for (x = 64; x < 128; x++) {
-                    KS0108Data(LCD_page[x][y], 2);
-                }
-            }
+    }
+    ResetDirty();
+
+    // the controller chips, each one drives 64 columns of 8 pages
+    int chips = 0;
+    int chipX[4];
+    int chipPage[4];
+    if (height == 128) {
+        for (int i = 0; i < 4; i++) {
+            chipX[i] = (i % 2) * 64;
+            chipPage[i] = (i / 2) * 8;
         }
-
-        if (width > 128 && height == 64) {
-            for (y = 0; y < 64/8; y++) {
-                KS0108Cmd(SEPA + y, 1);
-                KS0108Cmd(SEAD, 1);
-
-                for (x = 0; x < 64; x++) {
-                    KS0108Data(LCD_page[x][y], 1);
-                }
-            }
-
-            for (y = 0; y < 64/8; y++) {
-                KS0108Cmd(SEPA + y, 2);
-                KS0108Cmd(SEAD, 2);
-                for (x = 64; x < 128; x++) {
-                    KS0108Data(LCD_page[x][y], 2);
-                }
-            }
-
-            for (y = 0; y < 64/8; y++) {
-                KS0108Cmd(SEPA + y, 3);
-                KS0108Cmd(SEAD, 3);
-
-                for (x = 128; x < 192; x++) {
-                    KS0108Data(LCD_page[x][y], 3);
-                }
-            }
-
-            for (y = 0; y < 64/8; y++) {
-                if (width > 192) {
-                    KS0108Cmd(SEPA + y, 4);
-                    KS0108Cmd(SEAD, 4);
-                    for (x = 192; x < 256; x++) {
-                        KS0108Data(LCD_page[x][y], 4);
-                    }
-                }
-            }
+        chips = 4;
+    } else {
+        for (chips = 0; chips < 4 && chips * 64 < width; chips++) {
+            chipX[chips] = chips * 64;
+            chipPage[chips] = 0;
         }
+    }
 
-        if (width == 128 && height == 128) {
-            for (y = 0; y < 64/8; y++) {
-                KS0108Cmd(SEPA + y, 1);
-                KS0108Cmd(SEAD, 1);
-
-                for (x = 0; x < 64; x++) {
-                    KS0108Data(LCD_page[x][y], 1);
-                }
-            }
-
-            for (y = 0; y < 64/8; y++) {
-                KS0108Cmd(SEPA + y, 2);
-                KS0108Cmd(SEAD, 2);
-
-                for (x = 64; x < 128; x++) {
-                    KS0108Data(LCD_page[x][y], 2);
-                }
-            }
-
-            for (y = 0; y < 64/8; y++) {
-                KS0108Cmd(SEPA + y, 3);
-                KS0108Cmd(SEAD, 3);
-
-                for (x = 0; x < 64; x++) {
-                    KS0108Data(LCD_page[x][y+8], 3);
+    // only the column runs that differ from what was sent last are written
+    bool claimed = false;
+    for (int chip = 0; chip < chips; chip++) {
+        int cs = chip + 1;
+        for (y = 0; y < 64/8; y++) {
+            int page = chipPage[chip] + y;
+            int next = -1; // column the address counter of the chip points to
+            for (x = chipX[chip]; x < chipX[chip] + 64; x++) {
+                if (!refreshAll && LCD_page[x][page] == LCD_sent[x][page])
+                    continue;
+                if (!claimed) {
+                    port->Claim();
+                    claimed = true;
                 }
+                if (next == -1)
+                    KS0108Cmd(SEPA + y, cs);
+                if (next != x)
+                    KS0108Cmd(SEAD + (x - chipX[chip]), cs);
+                KS0108Data(LCD_page[x][page], cs);
+                LCD_sent[x][page] = LCD_page[x][page];
+                next = x + 1;
             }
+        }
+    }
 
-            for (y = 0; y < 64/8; y++) {
-                KS0108Cmd(SEPA + y, 4);
-                KS0108Cmd(SEAD, 4);
+    sentValid = true;
 
-                for (x = 64; x < 128; x++) {
-                    KS0108Data(LCD_page[x][y+8], 4);
-                }
-            }
-        }
+    if (claimed) {
         port->WriteData(0);
         port->Release();
     }
-    else
-    {
-        // draw only the changed bytes
-    }
+}
+
+bool cDriverKS0108::GetIOStats(uint64_t & bytes, uint64_t & syscalls) const
+{
+    return GetPortIOStats(port, bytes, syscalls);
 }
 
 } // end of namespace
@@ -28,6 +28,8 @@ private:
     cParallelPort * port;
     unsigned char ** LCD;      // linear lcd display "memory"
     unsigned char ** LCD_page; // paged lcd display "memory"
+    unsigned char ** LCD_sent; // paged contents last sent to the display
+    bool sentValid;            // LCD_sent matches the display
     int refreshCounter;
     long timeForPortCmdInNs;
     long timeForLCDInNs;
@@ -35,6 +37,7 @@ private:
 
     int CheckSetup();
     int InitGraphic();
+    void KS0108Write(unsigned char cd, unsigned char data, int cs);
     void KS0108Cmd(unsigned char data, int cs);
     void KS0108Data(unsigned char data, int cs);
 
@@ -67,6 +70,7 @@ public:
     virtual void SetPixel(int x, int y, uint32_t data);
     //virtual void Set8Pixels(int x, int y, unsigned char data);
     virtual void Refresh(bool refreshAll = false);
+    virtual bool GetIOStats(uint64_t & bytes, uint64_t & syscalls) const;
 };
 
 } // end of namespace
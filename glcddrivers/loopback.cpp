@@ -0,0 +1,305 @@
+/*
+ * GraphLCD driver library
+ *
+ * loopback.c  -  loopback driver class
+ *                Without hardware: either keeps the screen in memory
+ *                only or runs another driver on traced ports and
+ *                reports the simulated bus time of its refreshes.
+ *
+ * This file is released under the GNU General Public License. Refer
+ * to the COPYING file distributed with this package.
+ */
+
+#include <string.h>
+#include <syslog.h>
+
+#include <algorithm>
+
+#include "common.h"
+#include "drivers.h"
+#include "loopback.h"
+
+
+namespace GLCD
+{
+
+// the emulated driver waits into the trace while one of these exists
+class cTraceScope
+{
+private:
+    cPortTrace * previous;
+public:
+    cTraceScope(cPortTrace * trace) : previous(GetSleepTrace()) { SetSleepTrace(trace); }
+    ~cTraceScope() { SetSleepTrace(previous); }
+};
+
+cDriverLoopback::cDriverLoopback(cDriverConfig * config)
+:   cDriver(config),
+    emulated(NULL)
+{
+    memset(&stats, 0, sizeof(stats));
+}
+
+cDriverLoopback::~cDriverLoopback()
+{
+    if (emulated)
+        DeInit();
+}
+
+int cDriverLoopback::Init()
+{
+    std::string emulate;
+    tBusCost cost;
+    unsigned char readValue = 0xFF;
+
+    for (unsigned int i = 0; i < config->options.size(); i++)
+    {
+        const tOption & option = config->options[i];
+        if (option.name == "Emulate")
+            emulate = option.value;
+        else if (option.name == "TraceFile")
+            traceFile = option.value;
+        else if (option.name == "DataWriteTime")
+            cost.dataWrite = config->GetInt(option.value);
+        else if (option.name == "ControlWriteTime")
+            cost.controlWrite = config->GetInt(option.value);
+        else if (option.name == "ReadTime")
+            cost.read = config->GetInt(option.value);
+        else if (option.name == "WriteCallTime")
+            cost.writeCall = config->GetInt(option.value);
+        else if (option.name == "BaudRate")
+            cost.baudRate = config->GetInt(option.value);
+        else if (option.name == "ReadValue")
+            readValue = config->GetInt(option.value);
+    }
+    if (cost.baudRate <= 0)
+    {
+        syslog(LOG_ERR, "%s: invalid BaudRate %d (cDriverLoopback::Init)\n", config->name.c_str(), cost.baudRate);
+        return -1;
+    }
+
+    trace.SetCost(cost);
+    trace.SetReadValue(readValue);
+    trace.SetRecording(traceFile.length() > 0);
+    trace.Clear();
+    memset(&stats, 0, sizeof(stats));
+
+    if (emulate.length() == 0)
+    {
+        width = config->width;
+        if (width <= 0)
+            width = 240;
+        height = config->height;
+        if (height <= 0)
+            height = 128;
+        frame.assign(width * height, GetBackgroundColor());
+        monoFrame.assign((width + 7) / 8 * height, 0);
+
+        syslog(LOG_INFO, "%s: loopback driver initialized.\n", config->name.c_str());
+        return 0;
+    }
+
+    int id = GetDriverID(emulate);
+    if (id == kDriverUnknown || id == kDriverLoopback)
+    {
+        syslog(LOG_ERR, "%s: cannot emulate driver %s (cDriverLoopback::Init)\n", config->name.c_str(), emulate.c_str());
+        return -1;
+    }
+
+    // the emulated driver opens its ports on the trace
+    device = "loopback:" + config->name;
+    emulatedConfig = *config;
+    emulatedConfig.driver = emulate;
+    emulatedConfig.id = id;
+    emulatedConfig.device = device;
+    emulatedConfig.asyncRefresh = false;
+    emulatedConfig.stats = false;
+    cPortTrace::Register(device, &trace);
+
+    emulated = CreateDriver(id, &emulatedConfig);
+    if (!emulated)
+    {
+        cPortTrace::Unregister(device);
+        return -1;
+    }
+
+    cTraceScope scope(&trace);
+    if (emulated->Init() != 0)
+    {
+        delete emulated;
+        emulated = NULL;
+        cPortTrace::Unregister(device);
+        return -1;
+    }
+    width = emulated->Width();
+    height = emulated->Height();
+    bgcol = emulated->GetBackgroundColor();
+    fgcol = emulated->GetForegroundColor();
+
+    syslog(LOG_INFO, "%s: loopback driver initialized, emulating %s.\n", config->name.c_str(), emulate.c_str());
+    return 0;
+}
+
+int cDriverLoopback::DeInit()
+{
+    int ret = 0;
+
+    if (emulated)
+    {
+        {
+            cTraceScope scope(&trace);
+            ret = emulated->DeInit();
+        }
+        delete emulated;
+        emulated = NULL;
+        cPortTrace::Unregister(device);
+    }
+    if (traceFile.length() > 0 && !trace.Save(traceFile))
+        syslog(LOG_ERR, "%s: cannot write trace file %s (cDriverLoopback::DeInit)\n", config->name.c_str(), traceFile.c_str());
+    return ret;
+}
+
+void cDriverLoopback::Clear()
+{
+    if (emulated)
+    {
+        cTraceScope scope(&trace);
+        emulated->Clear();
+        return;
+    }
+    std::fill(frame.begin(), frame.end(), GetBackgroundColor());
+}
+
+void cDriverLoopback::SetPixel(int x, int y, uint32_t data)
+{
+    if (emulated)
+    {
+        cTraceScope scope(&trace);
+        emulated->SetPixel(x, y, data);
+        return;
+    }
+    if (x >= 0 && x < width && y >= 0 && y < height)
+        frame[y * width + x] = data;
+}
+
+void cDriverLoopback::SetScreenRect(const uint32_t * data, int stride, int x, int y, int w, int h)
+{
+    if (emulated)
+    {
+        cTraceScope scope(&trace);
+        uint64_t start = trace.BusTime();
+        emulated->SetScreenRect(data, stride, x, y, w, h);
+        stats.setScreenTime += trace.BusTime() - start;
+        return;
+    }
+    if (!data || !ClipScreenRect(x, y, w, h))
+        return;
+
+    for (int yt = y; yt < y + h; yt++)
+        memcpy(&frame[yt * width + x], data + yt * stride + x, w * sizeof(uint32_t));
+}
+
+void cDriverLoopback::SetScreen1BPP(const unsigned char * data, int wid, int hgt, int lineSize)
+{
+    if (emulated)
+    {
+        cTraceScope scope(&trace);
+        uint64_t start = trace.BusTime();
+        emulated->SetScreen1BPP(data, wid, hgt, lineSize);
+        stats.setScreenTime += trace.BusTime() - start;
+        return;
+    }
+
+    int x = 0, y = 0;
+    int size = (width + 7) / 8;
+
+    if (!data || !ClipScreenRect(x, y, wid, hgt))
+        return;
+
+    for (int yt = 0; yt < hgt; yt++)
+        memcpy(&monoFrame[yt * size], data + yt * lineSize, std::min(size, lineSize));
+}
+
+void cDriverLoopback::Refresh(bool refreshAll)
+{
+    if (emulated)
+    {
+        cTraceScope scope(&trace);
+        uint64_t start = trace.BusTime();
+        uint64_t forced = emulated->GetForcedRefreshes();
+        emulated->Refresh(refreshAll);
+        stats.refreshTime += trace.BusTime() - start;
+        // the emulated driver may have made it a full refresh on its own (RefreshDisplay)
+        if (emulated->GetForcedRefreshes() != forced)
+            refreshAll = true;
+    }
+    stats.frames++;
+    if (refreshAll)
+        stats.fullRefreshes++;
+    trace.Frame(stats.frames, refreshAll);
+}
+
+void cDriverLoopback::SetBrightness(unsigned int percent)
+{
+    if (emulated)
+    {
+        cTraceScope scope(&trace);
+        emulated->SetBrightness(percent);
+    }
+}
+
+bool cDriverLoopback::SetFeature(const std::string & Feature, int value)
+{
+    if (emulated)
+    {
+        cTraceScope scope(&trace);
+        return emulated->SetFeature(Feature, value);
+    }
+    return false;
+}
+
+cGLCDEvent * cDriverLoopback::GetEvent(void)
+{
+    if (emulated)
+    {
+        cTraceScope scope(&trace);
+        return emulated->GetEvent();
+    }
+    return NULL;
+}
+
+bool cDriverLoopback::GetStats(tDriverStats & Stats) const
+{
+    Stats = stats;
+    Stats.bytes = trace.Bytes();
+    Stats.syscalls = trace.WriteCalls();
+    return true;
+}
+
+bool cDriverLoopback::GetIOStats(uint64_t & bytes, uint64_t & syscalls) const
+{
+    bytes = trace.Bytes();
+    syscalls = trace.WriteCalls();
+    return true;
+}
+
+uint64_t cDriverLoopback::GetForcedRefreshes(void) const
+{
+    return emulated ? emulated->GetForcedRefreshes() : 0;
+}
+
+bool cDriverLoopback::GetDriverFeature(const std::string & Feature, int & value)
+{
+    if (emulated)
+        return emulated->GetFeature(Feature, value);
+    return false;
+}
+
+uint32_t cDriverLoopback::GetDefaultBackgroundColor(void)
+{
+    if (emulated)
+        return emulated->GetBackgroundColor(true);
+    return cDriver::GetDefaultBackgroundColor();
+}
+
+} // end of namespace
@@ -0,0 +1,69 @@
+/*
+ * GraphLCD driver library
+ *
+ * loopback.h  -  loopback driver class
+ *                Without hardware: either keeps the screen in memory
+ *                only or runs another driver on traced ports and
+ *                reports the simulated bus time of its refreshes.
+ *
+ * This file is released under the GNU General Public License. Refer
+ * to the COPYING file distributed with this package.
+ */
+
+#ifndef _GLCDDRIVERS_LOOPBACK_H_
+#define _GLCDDRIVERS_LOOPBACK_H_
+
+#include <vector>
+
+#include "driver.h"
+#include "config.h"
+#include "porttrace.h"
+
+
+namespace GLCD
+{
+
+class cDriverLoopback : public cDriver
+{
+private:
+    cDriverConfig emulatedConfig;
+    cDriver * emulated;         // NULL: the screen is only kept in memory
+    cPortTrace trace;
+    std::string device;         // name the trace is registered under
+    std::string traceFile;
+    tDriverStats stats;         // times are simulated bus times
+    std::vector<uint32_t> frame;
+    std::vector<unsigned char> monoFrame;
+
+protected:
+    virtual bool GetDriverFeature(const std::string & Feature, int & value);
+    virtual uint32_t GetDefaultBackgroundColor(void);
+
+public:
+    cDriverLoopback(cDriverConfig * config);
+    virtual ~cDriverLoopback();
+
+    virtual int Init();
+    virtual int DeInit();
+
+    virtual void Clear();
+    virtual void SetPixel(int x, int y, uint32_t data);
+    virtual void SetScreenRect(const uint32_t *data, int stride, int x, int y, int w, int h);
+    virtual void SetScreen1BPP(const unsigned char *data, int width, int height, int lineSize);
+    virtual void Refresh(bool refreshAll = false);
+
+    virtual void SetBrightness(unsigned int percent);
+    virtual bool SetFeature(const std::string & Feature, int value);
+    virtual cGLCDEvent * GetEvent(void);
+
+    virtual bool GetStats(tDriverStats & stats) const;
+    virtual bool GetIOStats(uint64_t & bytes, uint64_t & syscalls) const;
+    virtual uint64_t GetForcedRefreshes(void) const;
+
+    const cPortTrace & Trace(void) const { return trace; }
+    cDriver * Emulated(void) const { return emulated; }
+};
+
+} // end of namespace
+
+#endif
@@ -12,10 +12,13 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <syslog.h>
 #include <unistd.h>
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <errno.h>
@@ -29,12 +32,75 @@
 namespace GLCD
 {
 
+// binary protocol, all numbers are big endian:
+//   frame:  "GLCD" version:8 flags:8 width:16 height:16 rows:16 row*
+//   row:    y:16 encoding:8 length:16 data[length]
+static const char kMagic[4] = { 'G', 'L', 'C', 'D' };
+static const int kVersion = 1;
+static const int kFlagKeyFrame = 0x01;      // rows are complete, not relative to the previous frame
+
+static const int kRowRaw = 0;               // the bytes of the row
+static const int kRowRunLength = 1;         // (count:8, value:8) pairs
+static const int kRowXorRunLength = 2;      // (count:8, value:8) pairs, XORed onto the row the client has
+
+static const int kDefaultPort = 2003;
+
+static void Put16(std::string & out, int value)
+{
+    out += (char) ((value >> 8) & 0xff);
+    out += (char) (value & 0xff);
+}
+
+// size of the run length encoding of data XOR base (base may be NULL)
+static int RunLengthSize(const unsigned char * data, const unsigned char * base, int length)
+{
+    int size = 0;
+    int i = 0;
+    while (i < length)
+    {
+        unsigned char value = base ? data[i] ^ base[i] : data[i];
+        int count = 1;
+        while (i + count < length && count < 255 &&
+               (base ? data[i + count] ^ base[i + count] : data[i + count]) == value)
+            count++;
+        size += 2;
+        i += count;
+    }
+    return size;
+}
+
+static void RunLength(std::string & out, const unsigned char * data, const unsigned char * base, int length)
+{
+    int i = 0;
+    while (i < length)
+    {
+        unsigned char value = base ? data[i] ^ base[i] : data[i];
+        int count = 1;
+        while (i + count < length && count < 255 &&
+               (base ? data[i + count] ^ base[i + count] : data[i + count]) == value)
+            count++;
+        out += (char) count;
+        out += (char) value;
+        i += count;
+    }
+}
+
 cDriverNetwork::cDriverNetwork(cDriverConfig * config)
 :   cDriver(config)
 {
+    newLCD = NULL;
+    oldLCD = NULL;
+    port = kDefaultPort;
+    protocol = netText;
     childTid = 0;
     running = false;
-    clientConnected = false;
+    wakeupFd = -1;
+    pthread_mutex_init(&clientMutex, NULL);
+}
+
+cDriverNetwork::~cDriverNetwork()
+{
+    pthread_mutex_destroy(&clientMutex);
 }
 
 int cDriverNetwork::Init()
@@ -49,28 +115,46 @@ int cDriverNetwork::Init()
 
     for (unsigned int i = 0; i < config->options.size(); i++)
     {
-        if (config->options[i].name == "")
+        if (config->options[i].name == "Protocol")
         {
+            if (config->options[i].value == "text")
+                protocol = netText;
+            else if (config->options[i].value == "binary")
+                protocol = netBinary;
+            else
+                syslog(LOG_ERR, "%s error: unknown protocol %s, using default (text)!\n",
+                       config->name.c_str(), config->options[i].value.c_str());
         }
     }
 
+    // the generic Port option selects the TCP port
+    port = kDefaultPort;
+    if (config->port > 0 && config->port <= 65535)
+        port = config->port;
+
     newLCD = new unsigned char[lineSize * height];
-    if (newLCD)
-        memset(newLCD, 0, lineSize * height);
+    memset(newLCD, 0, lineSize * height);
     oldLCD = new unsigned char[lineSize * height];
-    if (oldLCD)
-        memset(oldLCD, 0, lineSize * height);
+    memset(oldLCD, 0, lineSize * height);
 
     *oldConfig = *config;
 
     // clear display
     Clear();
 
+    wakeupFd = eventfd(0, 0);
+    if (wakeupFd == -1)
+    {
+        syslog(LOG_ERR, "%s: error creating eventfd: %s.\n", config->name.c_str(), strerror(errno));
+        return 1;
+    }
+
     running = true;
     if (pthread_create(&childTid, NULL, (void *(*) (void *)) &ServerThread, (void *)this) != 0)
     {
         syslog(LOG_ERR, "%s: error creating server thread.\n", config->name.c_str());
         running = false;
+        childTid = 0;
         return 1;
     }
     syslog(LOG_INFO, "%s: network driver initialized.\n", config->name.c_str());
@@ -81,14 +165,30 @@ int cDriverNetwork::DeInit()
 {
     // stop server thread
     running = false;
-    usleep(3000000); // wait 3 seconds
-    pthread_cancel(childTid);
-    childTid = 0;
+    if (childTid)
+    {
+        uint64_t value = 1;
+        if (write(wakeupFd, &value, sizeof(value)) != sizeof(value))
+            syslog(LOG_ERR, "%s: error waking up server thread.\n", config->name.c_str());
+        pthread_join(childTid, NULL);
+        childTid = 0;
+    }
+    if (wakeupFd != -1)
+    {
+        close(wakeupFd);
+        wakeupFd = -1;
+    }
+
+    pthread_mutex_lock(&clientMutex);
+    for (unsigned int i = 0; i < clients.size(); i++)
+        close(clients[i].socket);
+    clients.clear();
+    pthread_mutex_unlock(&clientMutex);
 
-    if (newLCD)
-        delete[] newLCD;
-    if (oldLCD)
-        delete[] oldLCD;
+    delete[] newLCD;
+    newLCD = NULL;
+    delete[] oldLCD;
+    oldLCD = NULL;
     return 0;
 }
 
@@ -115,6 +215,7 @@ int cDriverNetwork::CheckSetup()
 void cDriverNetwork::Clear()
 {
     memset(newLCD, 0, lineSize * height);
+    MarkDirty();
 }
 
 
@@ -136,6 +237,33 @@ void cDriverNetwork::SetPixel(int x, int y, uint32_t data)
         newLCD[lineSize * y + x / 8] |= (1 << pos);
     else
         newLCD[lineSize * y + x / 8] &= ( 0xFF ^ (1 << pos) );
+    MarkDirty(x, y);
+}
+
+void cDriverNetwork::SetScreen1BPP(const unsigned char * data, int wid, int hgt, int stride)
+{
+    int x = 0, y = 0;
+
+    // newLCD has the same layout unless the display is upside down
+    if (config->upsideDown)
+    {
+        cDriver::SetScreen1BPP(data, wid, hgt, stride);
+        return;
+    }
+    if (!data || !ClipScreenRect(x, y, wid, hgt))
+        return;
+
+    int bytes = wid / 8;
+    unsigned char mask = 0xFF << (8 - (wid & 7));
+    for (y = 0; y < hgt; y++)
+    {
+        unsigned char * dst = newLCD + y * lineSize;
+        const unsigned char * src = data + y * stride;
+        memcpy(dst, src, bytes);
+        if (wid & 7)
+            dst[bytes] = (dst[bytes] & ~mask) | (src[bytes] & mask);
+    }
+    dirtyArea.Unite(tRect(0, 0, wid - 1, hgt - 1));
 }
 
 
@@ -160,78 +288,213 @@ void cDriverNetwork::Set8Pixels(int x, int y, unsigned char data)
 }
 #endif
 
-void cDriverNetwork::Refresh(bool refreshAll)
+void cDriverNetwork::EncodeText(std::string & frame, int firstLine, int lastLine)
 {
-    int i;
-    bool refresh;
-
-    refresh = false;
-    if (CheckSetup() > 0)
-        refresh = true;
+    static const char hex[] = "0123456789ABCDEF";
+    char msg[64];
+
+    frame.clear();
+    frame.reserve(32 + (lastLine - firstLine + 1) * (lineSize * 2 + 24));
+    snprintf(msg, sizeof(msg), "update begin %d %d\r\n", width, height);
+    frame += msg;
+    for (int y = firstLine; y <= lastLine; y++)
+    {
+        snprintf(msg, sizeof(msg), "update line %d ", y);
+        frame += msg;
+        const unsigned char * line = newLCD + y * lineSize;
+        for (int x = 0; x < lineSize; x++)
+        {
+            frame += hex[line[x] >> 4];
+            frame += hex[line[x] & 0x0f];
+        }
+        frame += "\r\n";
+    }
+    frame += "update end\r\n";
+}
 
-    for (i = 0; i < lineSize * height; i++)
+void cDriverNetwork::EncodeRow(std::string & frame, int y, bool keyFrame)
+{
+    const unsigned char * row = newLCD + y * lineSize;
+    const unsigned char * base = oldLCD + y * lineSize;
+
+    // use the smallest of the encodings
+    int encoding = kRowRaw;
+    int length = lineSize;
+    int size = RunLengthSize(row, NULL, lineSize);
+    if (size < length)
+    {
+        encoding = kRowRunLength;
+        length = size;
+    }
+    if (!keyFrame)
     {
-        if (newLCD[i] != oldLCD[i])
+        size = RunLengthSize(row, base, lineSize);
+        if (size < length)
         {
-            refresh = true;
-            break;
+            encoding = kRowXorRunLength;
+            length = size;
         }
     }
 
-    if (refresh && clientConnected)
+    Put16(frame, y);
+    frame += (char) encoding;
+    Put16(frame, length);
+    if (encoding == kRowRaw)
+        frame.append((const char *) row, lineSize);
+    else
+        RunLength(frame, row, encoding == kRowXorRunLength ? base : NULL, lineSize);
+}
+
+void cDriverNetwork::EncodeBinary(std::string & frame, bool keyFrame, int firstLine, int lastLine)
+{
+    frame.clear();
+    frame.append(kMagic, sizeof(kMagic));
+    frame += (char) kVersion;
+    frame += (char) (keyFrame ? kFlagKeyFrame : 0);
+    Put16(frame, width);
+    Put16(frame, height);
+    size_t rowsPos = frame.size();
+    Put16(frame, 0);
+
+    int rows = 0;
+    for (int y = firstLine; y <= lastLine; y++)
     {
-        char msg[1024];
-        int x;
-        int y;
-        int sent;
+        // a delta frame only contains the rows that changed
+        if (!keyFrame && memcmp(newLCD + y * lineSize, oldLCD + y * lineSize, lineSize) == 0)
+            continue;
+        EncodeRow(frame, y, keyFrame);
+        rows++;
+    }
+    frame[rowsPos] = (char) ((rows >> 8) & 0xff);
+    frame[rowsPos + 1] = (char) (rows & 0xff);
+}
 
-        sprintf(msg, "update begin %d %d\r\n", width, height);
-        sent = send(clientSocket, msg, strlen(msg), 0);
+bool cDriverNetwork::SendFrame(int socket, const std::string & frame)
+{
+    size_t pos = 0;
+    while (pos < frame.size())
+    {
+        ssize_t sent = send(socket, frame.data() + pos, frame.size() - pos, MSG_NOSIGNAL);
         if (sent == -1)
         {
+            if (errno == EINTR)
+                continue;
             syslog(LOG_ERR, "%s: error sending message: %s.\n", config->name.c_str(), strerror(errno));
-            clientConnected = false;
-            return;
+            return false;
         }
-        for (y = 0; y < height; y++)
+        pos += sent;
+    }
+    return true;
+}
+
+void cDriverNetwork::Refresh(bool refreshAll)
+{
+    bool full = CheckSetup() > 0 || refreshAll;
+    int firstLine = 0;
+    int lastLine = height - 1;
+    bool changed = false;
+
+    // only lines that were touched since the last refresh can differ
+    if (full)
+    {
+        changed = true;
+    }
+    else if (!dirtyArea.IsEmpty())
+    {
+        firstLine = dirtyArea.y1;
+        lastLine = dirtyArea.y2;
+        changed = memcmp(newLCD + firstLine * lineSize, oldLCD + firstLine * lineSize,
+                         (lastLine - firstLine + 1) * lineSize) != 0;
+    }
+
+    pthread_mutex_lock(&clientMutex);
+    bool anyNew = false;
+    bool anySynced = false;
+    for (unsigned int i = 0; i < clients.size(); i++)
+    {
+        if (full)
+            clients[i].synced = false;
+        if (clients[i].broken)
+            continue;
+        if (clients[i].synced)
+            anySynced = true;
+        else
+            anyNew = true;
+    }
+
+    // every frame is encoded once and sent to all clients that need it
+    if (anyNew)
+    {
+        if (protocol == netBinary)
+            EncodeBinary(fullFrame, true, 0, height - 1);
+        else
+            EncodeText(fullFrame, 0, height - 1);
+    }
+    if (changed && anySynced)
+    {
+        if (protocol == netBinary)
+            EncodeBinary(deltaFrame, false, firstLine, lastLine);
+        else
+            EncodeText(deltaFrame, firstLine, lastLine);
+    }
+
+    for (unsigned int i = 0; i < clients.size(); i++)
+    {
+        tClient & client = clients[i];
+        if (client.broken || (client.synced && !changed))
+            continue;
+        if (!SendFrame(client.socket, client.synced ? deltaFrame : fullFrame))
         {
-            sprintf(msg, "update line %d ", y);
-            for (x = 0; x < lineSize; x++)
-            {
-                char tmp[3];
-                sprintf(tmp, "%02X", newLCD[y * lineSize + x]);
-                strcat(msg, tmp);
-                oldLCD[i] = newLCD[i];
-            }
-            strcat(msg, "\r\n");
-            sent = send(clientSocket, msg, strlen(msg), 0);
-            if (sent == -1)
-            {
-                syslog(LOG_ERR, "%s: error sending message: %s.\n", config->name.c_str(), strerror(errno));
-                clientConnected = false;
-                return;
-            }
+            // the server thread removes the client when it notices the hangup
+            client.broken = true;
+            shutdown(client.socket, SHUT_RDWR);
+            continue;
         }
-        sprintf(msg, "update end\r\n");
-        sent = send(clientSocket, msg, strlen(msg), 0);
-        if (sent == -1)
+        client.synced = true;
+    }
+    pthread_mutex_unlock(&clientMutex);
+
+    if (changed)
+        memcpy(oldLCD + firstLine * lineSize, newLCD + firstLine * lineSize,
+               (lastLine - firstLine + 1) * lineSize);
+    ResetDirty();
+}
+
+void cDriverNetwork::AddClient(int socket)
+{
+    tClient client;
+    client.socket = socket;
+    client.synced = false;
+    client.broken = false;
+
+    pthread_mutex_lock(&clientMutex);
+    clients.push_back(client);
+    pthread_mutex_unlock(&clientMutex);
+}
+
+void cDriverNetwork::RemoveClient(int socket)
+{
+    pthread_mutex_lock(&clientMutex);
+    for (unsigned int i = 0; i < clients.size(); i++)
+    {
+        if (clients[i].socket == socket)
         {
-            syslog(LOG_ERR, "%s: error sending message: %s.\n", config->name.c_str(), strerror(errno));
-            clientConnected = false;
-            return;
+            clients.erase(clients.begin() + i);
+            break;
         }
     }
+    pthread_mutex_unlock(&clientMutex);
+    close(socket);
 }
 
 void * cDriverNetwork::ServerThread(cDriverNetwork * Driver)
 {
     int serverSocket;
+    int epollFd;
     struct sockaddr_in address;
     socklen_t addrlen;
-    int clientSocket;
-    fd_set set;
-    fd_set setsave;
-    struct timeval timeout;
+    struct epoll_event event;
+    struct epoll_event events[16];
 
     serverSocket = socket(AF_INET, SOCK_STREAM, 0);
     if (serverSocket == -1)
@@ -245,41 +508,82 @@ void * cDriverNetwork::ServerThread(cDriverNetwork * Driver)
 
     address.sin_family = AF_INET;
     address.sin_addr.s_addr = INADDR_ANY;
-    address.sin_port = htons(2003);
+    address.sin_port = htons(Driver->port);
     if (bind(serverSocket, (struct sockaddr *) &address, sizeof(address)) != 0)
     {
-        syslog(LOG_ERR, "%s: error port %d is already used.\n", Driver->config->name.c_str(), 2003);
+        syslog(LOG_ERR, "%s: error port %d is already used.\n", Driver->config->name.c_str(), Driver->port);
+        close(serverSocket);
         return NULL;
     }
 
-    listen(serverSocket, 1);
-    addrlen = sizeof(struct sockaddr_in);
+    listen(serverSocket, 5);
 
-    FD_ZERO(&set);
-    FD_SET(serverSocket, &set);
-    setsave = set;
+    epollFd = epoll_create1(0);
+    if (epollFd == -1)
+    {
+        syslog(LOG_ERR, "%s: error creating epoll instance.\n", Driver->config->name.c_str());
+        close(serverSocket);
+        return NULL;
+    }
+    event.events = EPOLLIN;
+    event.data.fd = serverSocket;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, serverSocket, &event);
+    event.events = EPOLLIN;
+    event.data.fd = Driver->wakeupFd;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, Driver->wakeupFd, &event);
 
     while (Driver->running)
     {
-        set = setsave;
-        timeout.tv_sec = 1;
-        timeout.tv_usec = 0;
-        if (select(FD_SETSIZE, &set, NULL, NULL, &timeout) < 0)
+        int count = epoll_wait(epollFd, events, 16, -1);
+        if (count < 0)
         {
-            syslog(LOG_ERR, "%s: error during select.\n", Driver->config->name.c_str());
+            if (errno == EINTR)
+                continue;
+            syslog(LOG_ERR, "%s: error during epoll_wait.\n", Driver->config->name.c_str());
             break;
         }
 
-        if (FD_ISSET(serverSocket, &set))
+        for (int i = 0; i < count; i++)
         {
-            clientSocket = accept(serverSocket, (struct sockaddr *) &address, &addrlen);
-            if (clientSocket > 0)
+            int fd = events[i].data.fd;
+            if (fd == Driver->wakeupFd)
+            {
+                // DeInit() wants the thread to end, running is checked by the loop
+                continue;
+            }
+            else if (fd == serverSocket)
+            {
+                addrlen = sizeof(struct sockaddr_in);
+                int clientSocket = accept(serverSocket, (struct sockaddr *) &address, &addrlen);
+                if (clientSocket < 0)
+                    continue;
+
+                // a stalled client must not block Refresh() for long
+                struct timeval timeout;
+                timeout.tv_sec = 1;
+                timeout.tv_usec = 0;
+                setsockopt(clientSocket, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+                event.events = EPOLLIN | EPOLLRDHUP;
+                event.data.fd = clientSocket;
+                epoll_ctl(epollFd, EPOLL_CTL_ADD, clientSocket, &event);
+                Driver->AddClient(clientSocket);
+            }
+            else
             {
-                Driver->clientSocket = clientSocket;
-                Driver->clientConnected = true;
+                // clients do not send anything, data is discarded, a hangup removes the client
+                char buffer[256];
+                ssize_t received = recv(fd, buffer, sizeof(buffer), MSG_DONTWAIT);
+                if (received == 0 || (received < 0 && errno != EAGAIN && errno != EINTR) ||
+                    (events[i].events & (EPOLLRDHUP | EPOLLHUP | EPOLLERR)))
+                {
+                    epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, NULL);
+                    Driver->RemoveClient(fd);
+                }
             }
         }
     }
+    close(epollFd);
     close(serverSocket);
     return NULL;
 }
@@ -16,6 +16,9 @@
 
 #include <pthread.h>
 
+#include <string>
+#include <vector>
+
 #include "driver.h"
 
 
@@ -24,28 +27,55 @@ namespace GLCD
 
 class cDriverConfig;
 
+enum eNetworkProtocol
+{
+    netText,        // "update line" messages with hex encoded lines
+    netBinary       // versioned binary frames with encoded rows
+};
+
 class cDriverNetwork : public cDriver
 {
 private:
+    struct tClient
+    {
+        int socket;
+        bool synced;    // client has received a complete screen
+        bool broken;    // sending failed, waiting for the server thread to remove it
+    };
+
     unsigned char * newLCD;
     unsigned char * oldLCD;
     int lineSize;
-    bool running;
+    int port;
+    eNetworkProtocol protocol;
+    volatile bool running;
     pthread_t childTid;
-    int clientSocket;
-    bool clientConnected;
+    int wakeupFd;                   // eventfd to stop the server thread
+    std::vector<tClient> clients;
+    pthread_mutex_t clientMutex;    // serialises access to clients
+    std::string fullFrame;
+    std::string deltaFrame;
 
     int CheckSetup();
     static void * ServerThread(cDriverNetwork * Driver);
+    void AddClient(int socket);
+    void RemoveClient(int socket);
+    bool SendFrame(int socket, const std::string & frame);
+
+    void EncodeText(std::string & frame, int firstLine, int lastLine);
+    void EncodeBinary(std::string & frame, bool keyFrame, int firstLine, int lastLine);
+    void EncodeRow(std::string & frame, int y, bool keyFrame);
 
 public:
     cDriverNetwork(cDriverConfig * config);
+    virtual ~cDriverNetwork();
 
     virtual int Init();
     virtual int DeInit();
 
     virtual void Clear();
     virtual void SetPixel(int x, int y, uint32_t data);
+    virtual void SetScreen1BPP(const unsigned char * data, int width, int height, int lineSize);
     //virtual void Set8Pixels(int x, int y, unsigned char data);
     virtual void Refresh(bool refreshAll = false);
 };
@@ -340,7 +340,7 @@ void cDriverNoritake800::Refresh(bool refreshAll)
     int xb, yb;
 
     if (CheckSetup() > 0)
-        refreshAll = true;
+        ForceRefreshAll(refreshAll);
 
     if (!m_pVFDMem || !m_pDrawMem)
         return;
@@ -349,7 +349,7 @@ void cDriverNoritake800::Refresh(bool refreshAll)
     {
         m_nRefreshCounter = (m_nRefreshCounter + 1) % config->refreshDisplay;
         if (m_nRefreshCounter == 0)
-            refreshAll = true;
+            ForceRefreshAll(refreshAll);
     }
 
     if (!m_pport->Claim())
@@ -580,5 +580,10 @@ void cDriverNoritake800::N800WriteByte(unsigned char data, int nCol, int nRow, i
     N800Data(ReverseBits(data));
 }
 
+bool cDriverNoritake800::GetIOStats(uint64_t & bytes, uint64_t & syscalls) const
+{
+    return GetPortIOStats(m_pport, bytes, syscalls);
+}
+
 } // end of namespace
 
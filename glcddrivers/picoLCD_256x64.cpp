@@ -185,7 +185,7 @@ void cDriverPicoLCD_256x64::Refresh(bool refreshAll)
 
     s = CheckSetup();
     if ((s > 0) || dirty)
-        refreshAll = true;
+        ForceRefreshAll(refreshAll);
 
     /* do not redraw display if frame buffer has not changed */
     if (!refreshAll) {
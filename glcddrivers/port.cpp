@@ -15,6 +15,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <syslog.h>
+#include <time.h>
 #include <unistd.h>
 #include <pthread.h>
 #include <sys/ioctl.h>
@@ -23,7 +24,9 @@
 
 
 
+#include "common.h"
 #include "port.h"
+#include "porttrace.h"
 
 #if defined(__linux__) && (defined(__i386__) || defined(__x86_64__))
   #define __HAS_DIRECTIO__ 1
@@ -35,6 +38,9 @@ namespace GLCD
 
 static pthread_mutex_t claimport_mutex;
 
+// queued accesses are flushed when the queue gets this long
+static const size_t kMaxBatchSize = 4096;
+
 static inline int port_in(int port)
 {
 #ifdef __HAS_DIRECTIO__
@@ -61,7 +67,14 @@ cParallelPort::cParallelPort()
 :   fd(-1),
     port(0),
     usePPDev(false),
-    portClaimed(false)
+    portClaimed(false),
+    control(-1),
+    portControl(-1),
+    pendingDelay(0),
+    sleepInit(false),
+    trace(NULL),
+    writeCalls(0),
+    bytesWritten(0)
 {
 }
 
@@ -73,7 +86,10 @@ int cParallelPort::Open(int portIO)
 {
 #ifdef __HAS_DIRECTIO__
     usePPDev = false;
+    trace = NULL;
     port = portIO;
+    control = portControl = -1;
+    writeCalls = bytesWritten = 0;
 
     if (port < 0x400)
     {
@@ -103,6 +119,12 @@ int cParallelPort::Open(int portIO)
 int cParallelPort::Open(const char * device)
 {
     usePPDev = true;
+    control = portControl = -1;
+    writeCalls = bytesWritten = 0;
+
+    trace = cPortTrace::Find(device);
+    if (trace)
+        return Claim() ? 0 : -1;
 
     fd = open(device, O_RDWR);
     if (fd == -1)
@@ -134,7 +156,13 @@ int cParallelPort::Open(const char * device)
 
 int cParallelPort::Close()
 {
-    if (usePPDev)
+    Flush();
+    if (trace)
+    {
+        trace = NULL;
+        portClaimed = false;
+    }
+    else if (usePPDev)
     {
         if (fd != -1)
         {
@@ -175,19 +203,26 @@ bool cParallelPort::Claim()
 {
     if (!IsPortClaimed())
     {
-        if (usePPDev)
+        if (trace)
+            portClaimed = true;
+        else if (usePPDev)
             portClaimed = (ioctl(fd, PPCLAIM) == 0);
         else
             portClaimed = (pthread_mutex_lock(&claimport_mutex) == 0);
+        // someone else may have changed the port meanwhile
+        control = portControl = -1;
     }
     return IsPortClaimed();
 }
 
 void cParallelPort::Release()
 {
+    Flush();
     if (IsPortClaimed())
     {
-        if (usePPDev)
+        if (trace)
+            portClaimed = false;
+        else if (usePPDev)
             portClaimed = !(ioctl(fd, PPRELEASE) == 0);
         else
             portClaimed = !(pthread_mutex_unlock(&claimport_mutex) == 0);
@@ -196,7 +231,13 @@ void cParallelPort::Release()
 
 void cParallelPort::SetDirection(int direction)
 {
-    if (usePPDev)
+    Flush();
+    control = portControl = -1;
+    if (trace)
+    {
+        trace->Direction(direction);
+    }
+    else if (usePPDev)
     {
         if (ioctl(fd, PPDATADIR, &direction) == -1)
         {
@@ -217,7 +258,16 @@ unsigned char cParallelPort::ReadControl()
 {
     unsigned char value;
 
-    if (usePPDev)
+    // the register only changes by our own writes
+    if (control != -1)
+        return control;
+
+    Flush();
+    if (trace)
+    {
+        value = trace->Read();
+    }
+    else if (usePPDev)
     {
         if (ioctl(fd, PPRCONTROL, &value) == -1)
         {
@@ -229,31 +279,51 @@ unsigned char cParallelPort::ReadControl()
     {
         value = port_in(port + 2);
     }
+    control = portControl = value;
 
     return value;
 }
 
-void cParallelPort::WriteControl(unsigned char value)
+void cParallelPort::OutControl(unsigned char value)
 {
-    if (usePPDev)
+    if (trace)
+    {
+        trace->Control(value);
+        writeCalls++;
+    }
+    else if (usePPDev)
     {
         if (ioctl(fd, PPWCONTROL, &value) == -1)
         {
             perror("ioctl(PPWCONTROL)");
             //exit(1);
         }
+        writeCalls++;
     }
     else
     {
         port_out(port + 2, value);
     }
+    portControl = value;
+}
+
+void cParallelPort::WriteControl(unsigned char value)
+{
+    Flush();
+    OutControl(value);
+    control = value;
 }
 
 unsigned char cParallelPort::ReadStatus()
 {
     unsigned char value;
 
-    if (usePPDev)
+    Flush();
+    if (trace)
+    {
+        value = trace->Read();
+    }
+    else if (usePPDev)
     {
         if (ioctl(fd, PPRSTATUS, &value) == -1)
         {
@@ -273,7 +343,12 @@ unsigned char cParallelPort::ReadData()
 {
     unsigned char data;
 
-    if (usePPDev)
+    Flush();
+    if (trace)
+    {
+        data = trace->Read();
+    }
+    else if (usePPDev)
     {
         if (ioctl(fd, PPRDATA, &data) == -1)
         {
@@ -289,26 +364,126 @@ unsigned char cParallelPort::ReadData()
     return data;
 }
 
-void cParallelPort::WriteData(unsigned char data)
+void cParallelPort::OutData(unsigned char data)
 {
-    if (usePPDev)
+    if (trace)
+    {
+        trace->Data(data);
+        writeCalls++;
+    }
+    else if (usePPDev)
     {
         if (ioctl(fd, PPWDATA, &data) == -1)
         {
             perror("ioctl(PPWDATA)");
             //exit(1);
         }
+        writeCalls++;
     }
     else
     {
         port_out(port, data);
     }
+    bytesWritten++;
+}
+
+void cParallelPort::WriteData(unsigned char data)
+{
+    Flush();
+    OutData(data);
+}
+
+void cParallelPort::QueueControl(unsigned char value)
+{
+    if (control == value)
+        return;
+
+    tPortAccess access;
+    access.control = true;
+    access.value = value;
+    access.delay = pendingDelay;
+    batch.push_back(access);
+    pendingDelay = 0;
+    control = value;
+    if (batch.size() >= kMaxBatchSize)
+        Flush();
+}
+
+void cParallelPort::QueueData(unsigned char data)
+{
+    tPortAccess access;
+    access.control = false;
+    access.value = data;
+    access.delay = pendingDelay;
+    batch.push_back(access);
+    pendingDelay = 0;
+    if (batch.size() >= kMaxBatchSize)
+        Flush();
+}
+
+void cParallelPort::QueueDelay(long ns)
+{
+    if (ns > 0)
+        pendingDelay += ns;
+}
+
+void cParallelPort::Flush()
+{
+    if (batch.empty() && pendingDelay == 0)
+        return;
+
+    if (sleepInit && !trace)
+        nSleepInit();
+    for (size_t i = 0; i < batch.size(); i++)
+    {
+        const tPortAccess & access = batch[i];
+        if (access.delay > 0)
+            Wait(access.delay);
+        if (!access.control)
+            OutData(access.value);
+        else if (portControl != access.value)
+            OutControl(access.value);
+    }
+    if (pendingDelay > 0)
+        Wait(pendingDelay);
+    if (sleepInit && !trace)
+        nSleepDeInit();
+
+    batch.clear();
+    pendingDelay = 0;
+}
+
+void cParallelPort::Wait(long ns)
+{
+    if (trace)
+        trace->Wait(ns);
+    else
+        nSleep(ns);
+}
+
+long cParallelPort::MeasureWriteTime(int count)
+{
+    struct timespec start, end;
+
+    Flush();
+    // the modelled time, without filling the trace with the measurement
+    if (trace)
+        return trace->Cost().dataWrite;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < count; i++)
+        OutData(i % 0x100);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return ((end.tv_sec - start.tv_sec) * 1000000000L + (end.tv_nsec - start.tv_nsec)) / count;
 }
 
 
 
 cSerialPort::cSerialPort()
-:   fd(-1)
+:   fd(-1),
+    outLength(0),
+    trace(NULL),
+    writeCalls(0),
+    bytesWritten(0)
 {
 }
 
@@ -320,6 +495,13 @@ int cSerialPort::Open(const char * device)
 {
     struct termios options;
 
+    outLength = 0;
+    writeCalls = 0;
+    bytesWritten = 0;
+    trace = cPortTrace::Find(device);
+    if (trace)
+        return 0;
+
     fd = open(device, O_RDWR | O_NOCTTY | O_NDELAY);
     if (fd == -1)
     {
@@ -364,15 +546,30 @@ int cSerialPort::Open(const char * device)
 
 int cSerialPort::Close()
 {
+    if (trace)
+    {
+        Flush();
+        trace = NULL;
+        return 0;
+    }
     if (fd == -1)
         return -1;
+    Flush();
     close(fd);
+    fd = -1;
     return 0;
 }
 
 void cSerialPort::SetBaudRate(int speed)
 {
     struct termios2 tio;
+
+    Flush();
+    if (trace)
+    {
+        trace->SetBaudRate(speed);
+        return;
+    }
     if (ioctl(fd, TCGETS2, &tio) < 0)
     {
         printf("TCGETS2 ioctl failed!\n");
@@ -394,6 +591,9 @@ void cSerialPort::SetBaudRate(int speed)
 bool cSerialPort::DisableHangup()
 {
     struct termios options;
+    Flush();
+    if (trace)
+        return false;
     tcgetattr(fd, &options);
     if (!(options.c_cflag & HUPCL))
         return false;
@@ -404,21 +604,75 @@ bool cSerialPort::DisableHangup()
 
 int cSerialPort::ReadData(unsigned char * data)
 {
-    if (fd == -1)
+    if (!IsOpen())
         return 0;
+    // the device may wait for what we have sent
+    Flush();
+    if (trace)
+    {
+        *data = trace->Read();
+        return 1;
+    }
     return read(fd, data, 1);
 }
 
+void cSerialPort::Write(const unsigned char * data, int length)
+{
+    if (trace)
+    {
+        trace->Write(data, length);
+        writeCalls++;
+        bytesWritten += length;
+        return;
+    }
+    while (length > 0)
+    {
+        ssize_t written = write(fd, data, length);
+        if (written == -1)
+        {
+            if (errno == EINTR || errno == EAGAIN)
+                continue;
+            syslog(LOG_ERR, "glcd drivers: ERROR writing to serial port. Err:%s (cSerialPort::Write)\n",
+                   strerror(errno));
+            return;
+        }
+        writeCalls++;
+        bytesWritten += written;
+        data += written;
+        length -= written;
+    }
+}
+
+void cSerialPort::Flush()
+{
+    if (IsOpen() && outLength > 0)
+        Write(outBuffer, outLength);
+    outLength = 0;
+}
+
 void cSerialPort::WriteData(unsigned char data)
 {
-    WriteData(&data, 1);
+    if (!IsOpen())
+        return;
+    if (outLength == kOutBufferSize)
+        Flush();
+    outBuffer[outLength++] = data;
 }
 
 void cSerialPort::WriteData(unsigned char * data, unsigned short length)
 {
-    if (fd == -1)
+    if (!IsOpen())
         return;
-    write(fd, data, length);
+    if (outLength + length > kOutBufferSize)
+        Flush();
+    if (length >= kOutBufferSize)
+    {
+        // too large to be buffered
+        Write(data, length);
+        return;
+    }
+    memcpy(outBuffer + outLength, data, length);
+    outLength += length;
 }
 
 void cSerialPort::WriteData(std::string data) {
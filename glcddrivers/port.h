@@ -12,7 +12,9 @@
 #ifndef _GLCDDRIVERS_PORT_H_
 #define _GLCDDRIVERS_PORT_H_
 
+#include <stdint.h>
 #include <string>
+#include <vector>
 #include <termios.h>
 
 // The following block is copied from "asm/termbits.h"
@@ -36,6 +38,8 @@ struct termios2 {
 namespace GLCD
 {
 
+class cPortTrace;
+
 const int kForward = 0;
 const int kReverse = 1;
 
@@ -51,16 +55,37 @@ const unsigned char kSelectLow  = 0x08;
 class cParallelPort
 {
 private:
+    // a queued port access and the time to wait before it
+    struct tPortAccess
+    {
+        bool control;
+        unsigned char value;
+        long delay;
+    };
+
     int fd;
     int port;
     bool usePPDev;
     bool portClaimed;
+    int control;                // control register after all queued accesses, -1 if unknown
+    int portControl;            // control register as last written to the port, -1 if unknown
+    long pendingDelay;          // queued delay not yet followed by an access
+    bool sleepInit;
+    std::vector<tPortAccess> batch;
+    cPortTrace * trace;         // accesses go to this trace instead of the port
+    unsigned long writeCalls;
+    unsigned long bytesWritten;
+
+    void OutControl(unsigned char value);
+    void OutData(unsigned char data);
+    void Wait(long ns);
 
 public:
     cParallelPort();
     ~cParallelPort();
 
     int Open(int port);
+    // a device registered with cPortTrace::Register() is not opened, its trace records the accesses
     int Open(const char * device);
     int Close();
 
@@ -77,28 +102,74 @@ public:
     unsigned char ReadStatus();
     unsigned char ReadData();
     void WriteData(unsigned char data);
+
+    // batched access: writes and the delays between them are queued and
+    // executed by Flush(). consecutive delays are merged and control writes
+    // that do not change the register are dropped. every unbatched access and
+    // Release() flush the queue first.
+    void QueueControl(unsigned char value);
+    void QueueData(unsigned char data);
+    void QueueDelay(long ns);
+    void Flush();
+    // call nSleepInit() / nSleepDeInit() around the execution of a batch
+    void SetSleepInit(bool enable) { sleepInit = enable; }
+
+    // average time in ns of WriteData(), measured with count writes
+    long MeasureWriteTime(int count = 1000);
+
+    // number of writing ioctl() calls (ppdev only) and data bytes written since Open()
+    unsigned long WriteCalls() const { return writeCalls; }
+    unsigned long BytesWritten() const { return bytesWritten; }
 };
 
 class cSerialPort
 {
 private:
+    static const int kOutBufferSize = 4096;
+
     int fd;
+    unsigned char outBuffer[kOutBufferSize];
+    int outLength;
+    cPortTrace * trace;         // writes go to this trace instead of the port
+    unsigned long writeCalls;
+    unsigned long bytesWritten;
+
+    void Write(const unsigned char * data, int length);
+    bool IsOpen() const { return fd != -1 || trace; }
 
 public:
     cSerialPort();
     ~cSerialPort();
 
+    // a device registered with cPortTrace::Register() is not opened, its trace records the writes
     int Open(const char * device);
     int Close();
     void SetBaudRate(int speed);
     bool DisableHangup();
 
     int ReadData(unsigned char * data);
+    // writes are buffered until Flush(), a full buffer or the next read
     void WriteData(unsigned char data);
     void WriteData(unsigned char * data, unsigned short length);
     void WriteData(std::string data);
+    void Flush();
+
+    // number of write() calls and bytes written since Open()
+    unsigned long WriteCalls() const { return writeCalls; }
+    unsigned long BytesWritten() const { return bytesWritten; }
 };
 
+// i/o counters of a port for cDriver::GetIOStats()
+template <class Port>
+inline bool GetPortIOStats(const Port * port, uint64_t & bytes, uint64_t & syscalls)
+{
+    if (!port)
+        return false;
+    bytes = port->BytesWritten();
+    syscalls = port->WriteCalls();
+    return true;
+}
+
 } // end of namespace
 
 #endif
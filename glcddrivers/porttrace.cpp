@@ -0,0 +1,190 @@
+/*
+ * GraphLCD driver library
+ *
+ * porttrace.c  -  recording of port accesses
+ *                 Ports opened on a registered trace device do no
+ *                 i/o but record the accesses and waits and sum up
+ *                 the time they would take on the bus.
+ *
+ * This file is released under the GNU General Public License. Refer
+ * to the COPYING file distributed with this package.
+ */
+
+#include <stdio.h>
+#include <pthread.h>
+
+#include <map>
+
+#include "porttrace.h"
+
+
+namespace GLCD
+{
+
+static pthread_mutex_t registryMutex = PTHREAD_MUTEX_INITIALIZER;
+static std::map<std::string, cPortTrace *> registry;
+
+static __thread cPortTrace * sleepTrace = NULL;
+
+tBusCost::tBusCost()
+:   dataWrite(1000),
+    controlWrite(1000),
+    read(1000),
+    writeCall(0),
+    baudRate(921600)
+{
+}
+
+cPortTrace::cPortTrace()
+:   recording(false),
+    baudRate(cost.baudRate),
+    readValue(0xFF),
+    bytes(0),
+    writeCalls(0),
+    busTime(0)
+{
+}
+
+void cPortTrace::Register(const std::string & device, cPortTrace * trace)
+{
+    pthread_mutex_lock(&registryMutex);
+    registry[device] = trace;
+    pthread_mutex_unlock(&registryMutex);
+}
+
+void cPortTrace::Unregister(const std::string & device)
+{
+    pthread_mutex_lock(&registryMutex);
+    registry.erase(device);
+    pthread_mutex_unlock(&registryMutex);
+}
+
+cPortTrace * cPortTrace::Find(const std::string & device)
+{
+    cPortTrace * trace = NULL;
+
+    pthread_mutex_lock(&registryMutex);
+    std::map<std::string, cPortTrace *>::iterator it = registry.find(device);
+    if (it != registry.end())
+        trace = it->second;
+    pthread_mutex_unlock(&registryMutex);
+    return trace;
+}
+
+void cPortTrace::Clear()
+{
+    events.clear();
+    bytes = 0;
+    writeCalls = 0;
+    busTime = 0;
+}
+
+void cPortTrace::Add(char type, unsigned char value, long time)
+{
+    if (!recording)
+        return;
+
+    tEvent event;
+    event.type = type;
+    event.value = value;
+    event.time = time;
+    events.push_back(event);
+}
+
+void cPortTrace::Data(unsigned char value)
+{
+    Add(kData, value, 0);
+    bytes++;
+    writeCalls++;
+    busTime += cost.dataWrite;
+}
+
+void cPortTrace::Control(unsigned char value)
+{
+    Add(kControl, value, 0);
+    writeCalls++;
+    busTime += cost.controlWrite;
+}
+
+unsigned char cPortTrace::Read()
+{
+    Add(kRead, readValue, 0);
+    busTime += cost.read;
+    return readValue;
+}
+
+void cPortTrace::Wait(long ns)
+{
+    if (ns <= 0)
+        return;
+    Add(kWait, 0, ns);
+    busTime += ns;
+}
+
+void cPortTrace::Direction(int direction)
+{
+    Add(kDirection, direction, 0);
+    writeCalls++;
+}
+
+void cPortTrace::SetBaudRate(int speed)
+{
+    Add(kBaudRate, 0, speed);
+    if (speed > 0)
+        baudRate = speed;
+}
+
+void cPortTrace::Write(const unsigned char * data, int length)
+{
+    for (int i = 0; i < length; i++)
+        Add(kData, data[i], 0);
+    bytes += length;
+    writeCalls++;
+    busTime += cost.writeCall + (uint64_t) length * 10 * 1000000000ULL / baudRate;
+}
+
+void cPortTrace::Frame(long number, bool refreshAll)
+{
+    Add(kFrame, refreshAll, number);
+}
+
+bool cPortTrace::Save(const std::string & fileName) const
+{
+    FILE * fp = fopen(fileName.c_str(), "w");
+    if (!fp)
+        return false;
+
+    for (size_t i = 0; i < events.size(); i++)
+    {
+        const tEvent & event = events[i];
+        switch (event.type)
+        {
+            case kWait:
+            case kBaudRate:
+                fprintf(fp, "%c %ld\n", event.type, event.time);
+                break;
+            case kFrame:
+                fprintf(fp, "%c %ld %d\n", event.type, event.time, event.value);
+                break;
+            default:
+                fprintf(fp, "%c %02X\n", event.type, event.value);
+                break;
+        }
+    }
+    fprintf(fp, "# %llu bytes, %llu writes, %llu ns\n",
+            (unsigned long long) bytes, (unsigned long long) writeCalls, (unsigned long long) busTime);
+    fclose(fp);
+    return true;
+}
+
+void SetSleepTrace(cPortTrace * trace)
+{
+    sleepTrace = trace;
+}
+
+cPortTrace * GetSleepTrace(void)
+{
+    return sleepTrace;
+}
+
+} // end of namespace
@@ -0,0 +1,112 @@
+/*
+ * GraphLCD driver library
+ *
+ * porttrace.h  -  recording of port accesses
+ *                 Ports opened on a registered trace device do no
+ *                 i/o but record the accesses and waits and sum up
+ *                 the time they would take on the bus.
+ *
+ * This file is released under the GNU General Public License. Refer
+ * to the COPYING file distributed with this package.
+ */
+
+#ifndef _GLCDDRIVERS_PORTTRACE_H_
+#define _GLCDDRIVERS_PORTTRACE_H_
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+
+namespace GLCD
+{
+
+// time in ns the accesses take on the bus
+struct tBusCost
+{
+    long dataWrite;     // write of a data byte to a parallel port
+    long controlWrite;  // write of the control register
+    long read;          // read of a register or of a byte from a serial port
+    long writeCall;     // overhead of a write() to a serial port
+    int baudRate;       // of a serial port, 10 bits per byte
+
+    tBusCost();
+};
+
+class cPortTrace
+{
+public:
+    enum eEvent
+    {
+        kData = 'D',        // value: byte written to the data register or a serial port
+        kControl = 'C',     // value: new control register
+        kRead = 'R',        // value: returned by the read
+        kWait = 'W',        // time: requested wait
+        kDirection = 'V',   // value: kForward or kReverse
+        kBaudRate = 'B',    // time: new baud rate
+        kFrame = 'F'        // value: full refresh, time: number of the frame
+    };
+
+    struct tEvent
+    {
+        char type;
+        unsigned char value;
+        long time;
+    };
+
+private:
+    tBusCost cost;
+    bool recording;
+    std::vector<tEvent> events;
+    int baudRate;
+    unsigned char readValue;
+    uint64_t bytes;
+    uint64_t writeCalls;
+    uint64_t busTime;       // ns
+
+    void Add(char type, unsigned char value, long time);
+
+public:
+    cPortTrace();
+
+    // registers the trace under a device name, so ports opened on it use it
+    static void Register(const std::string & device, cPortTrace * trace);
+    static void Unregister(const std::string & device);
+    static cPortTrace * Find(const std::string & device);
+
+    void SetCost(const tBusCost & Cost) { cost = Cost; baudRate = Cost.baudRate; }
+    const tBusCost & Cost() const { return cost; }
+    // keep the single events, not only the counters
+    void SetRecording(bool enable) { recording = enable; }
+    // value returned by all reads, e.g. ready flags of a status register
+    void SetReadValue(unsigned char value) { readValue = value; }
+    void Clear();
+
+    // accesses of the ports
+    void Data(unsigned char value);
+    void Control(unsigned char value);
+    unsigned char Read();
+    void Wait(long ns);
+    void Direction(int direction);
+    void SetBaudRate(int speed);
+    void Write(const unsigned char * data, int length);
+    // marks the end of a frame
+    void Frame(long number, bool refreshAll);
+
+    uint64_t Bytes() const { return bytes; }
+    uint64_t WriteCalls() const { return writeCalls; }
+    uint64_t BusTime() const { return busTime; }
+    const std::vector<tEvent> & Events() const { return events; }
+
+    // writes the events as text, one per line: type, value in hex or time in decimal
+    bool Save(const std::string & fileName) const;
+};
+
+// while a trace is set for the calling thread, nSleep() and uSleep() do not
+// wait but add the requested time to it
+void SetSleepTrace(cPortTrace * trace);
+cPortTrace * GetSleepTrace(void);
+
+} // end of namespace
+
+#endif
@@ -146,7 +146,6 @@ cDriverSED1330::~cDriverSED1330()
 int cDriverSED1330::Init()
 {
     int x;
-    struct timeval tv1, tv2;
 
     width = config->width;
     if (width <= 0)
@@ -307,15 +306,13 @@ int cDriverSED1330::Init()
     }
 
     syslog(LOG_DEBUG, "%s: benchmark started.\n", config->name.c_str());
-    gettimeofday(&tv1, 0);
-    for (x = 0; x < 1000; x++)
-    {
-        port->WriteData(x % 0x100);
-    }
-    gettimeofday(&tv2, 0);
+    timeForPortCmdInNs = port->MeasureWriteTime(1000);
     if (useSleepInit)
         nSleepDeInit();
-    timeForPortCmdInNs = (tv2.tv_sec - tv1.tv_sec) * 1000000 + (tv2.tv_usec - tv1.tv_usec);
+    // the calibration spins and sleeps for a while, only needed by the calibrated method
+    if (Config.waitMethod == kWaitCalibrated)
+        GetWaitTimings(config->timings);
+    config->timings.portAccess = timeForPortCmdInNs;
     syslog(LOG_DEBUG, "%s: benchmark stopped. Time for Command: %ldns\n", config->name.c_str(), timeForPortCmdInNs);
 
     // initialize graphic mode
@@ -457,34 +454,35 @@ void cDriverSED1330::WriteCmd(unsigned char cmd)
     //if (useSleepInit)
     //    nSleepInit();
 
+    // queued, executed when the port is released
     if (interface == kInterface6800)
     {
         // set A0 high (instruction), RW low (write) and E low
-        port->WriteControl(A0HI | CSLO | RWLO | ENLO);
+        port->QueueControl(A0HI | CSLO | RWLO | ENLO);
         //nSleep(140 - timeForPortCmdInNs + 100 * config->adjustTiming);
         // Output the actual command
-        port->WriteData(cmd);
+        port->QueueData(cmd);
         //nSleep(140 - timeForPortCmdInNs + 100 * config->adjustTiming);
         // set E high
-        port->WriteControl(A0HI | CSLO | RWLO | ENHI);
+        port->QueueControl(A0HI | CSLO | RWLO | ENHI);
         //nSleep(450 - timeForPortCmdInNs + 100 * config->adjustTiming);
         // set E low
-        port->WriteControl(A0HI | CSLO | RWLO | ENLO);
+        port->QueueControl(A0HI | CSLO | RWLO | ENLO);
         //nSleep(450 - timeForPortCmdInNs + 100 * config->adjustTiming);
     }
     else
     {
         // set A0 high (instruction), CS low, RD and WR high
-        port->WriteControl(A0HI | CSLO | RDHI | WRHI);
+        port->QueueControl(A0HI | CSLO | RDHI | WRHI);
         //nSleep(140 - timeForPortCmdInNs + 100 * config->adjustTiming);
         // Output the actual command
-        port->WriteData(cmd);
+        port->QueueData(cmd);
         //nSleep(140 - timeForPortCmdInNs + 100 * config->adjustTiming);
         // set WR low
-        port->WriteControl(A0HI | CSLO | RDHI | WRLO);
+        port->QueueControl(A0HI | CSLO | RDHI | WRLO);
         //nSleep(450 - timeForPortCmdInNs + 100 * config->adjustTiming);
         // set WR high
-        port->WriteControl(A0HI | CSLO | RDHI | WRHI);
+        port->QueueControl(A0HI | CSLO | RDHI | WRHI);
         //nSleep(450 - timeForPortCmdInNs + 100 * config->adjustTiming);
     }
 
@@ -497,34 +495,35 @@ void cDriverSED1330::WriteData(unsigned char data)
     //if (useSleepInit)
     //    nSleepInit();
 
+    // queued, executed when the port is released
     if (interface == kInterface6800)
     {
         // set A0 low (data), RW low (write) and E low
-        port->WriteControl(A0LO | CSLO | RWLO | ENLO);
+        port->QueueControl(A0LO | CSLO | RWLO | ENLO);
         //nSleep(140 - timeForPortCmdInNs + 100 * config->adjustTiming);
         // Output the actual data
-        port->WriteData(data);
+        port->QueueData(data);
         //nSleep(140 - timeForPortCmdInNs + 100 * config->adjustTiming);
         // set E high
-        port->WriteControl(A0LO | CSLO | RWLO | ENHI);
+        port->QueueControl(A0LO | CSLO | RWLO | ENHI);
         //nSleep(450 - timeForPortCmdInNs + 100 * config->adjustTiming);
         // set E low
-        port->WriteControl(A0LO | CSLO | RWLO | ENLO);
+        port->QueueControl(A0LO | CSLO | RWLO | ENLO);
         //nSleep(450 - timeForPortCmdInNs + 100 * config->adjustTiming);
     }
     else
     {
         // set A0 low (data), CS low, RD and WR high
-        port->WriteControl(A0LO | CSLO | RDHI | WRHI);
+        port->QueueControl(A0LO | CSLO | RDHI | WRHI);
         //nSleep(140 - timeForPortCmdInNs + 100 * config->adjustTiming);
         // Output the actual data
-        port->WriteData(data);
+        port->QueueData(data);
         //nSleep(140 - timeForPortCmdInNs + 100 * config->adjustTiming);
         // set WR low
-        port->WriteControl(A0LO | CSLO | RDHI | WRLO);
+        port->QueueControl(A0LO | CSLO | RDHI | WRLO);
         //nSleep(450 - timeForPortCmdInNs + 100 * config->adjustTiming);
         // set WR high
-        port->WriteControl(A0LO | CSLO | RDHI | WRHI);
+        port->QueueControl(A0LO | CSLO | RDHI | WRHI);
         //nSleep(450 - timeForPortCmdInNs + 100 * config->adjustTiming);
     }
 
@@ -588,13 +587,13 @@ void cDriverSED1330::Refresh(bool refreshAll)
     int pos = SAD1;
 
     if (CheckSetup() > 0)
-        refreshAll = true;
+        ForceRefreshAll(refreshAll);
 
     if (config->refreshDisplay > 0)
     {
         refreshCounter = (refreshCounter + 1) % config->refreshDisplay;
         if (!refreshAll && !refreshCounter)
-            refreshAll = true;
+            ForceRefreshAll(refreshAll);
     }
 
     port->Claim();
@@ -652,4 +651,9 @@ void cDriverSED1330::Refresh(bool refreshAll)
     port->Release();
 }
 
+bool cDriverSED1330::GetIOStats(uint64_t & bytes, uint64_t & syscalls) const
+{
+    return GetPortIOStats(port, bytes, syscalls);
+}
+
 } // end of namespace
@@ -61,8 +61,6 @@ cDriverSED1520::~cDriverSED1520()
 int cDriverSED1520::Init()
 {
     int x;
-    int i;
-    struct timeval tv1, tv2;
 
     if (!(config->width % 8) == 0) {
         width = config->width + (8 - (config->width % 8));
@@ -147,15 +145,13 @@ int cDriverSED1520::Init()
     }
 
     syslog(LOG_DEBUG, "%s: benchmark started.\n", config->name.c_str());
-    gettimeofday(&tv1, 0);
-    for (i = 0; i < 1000; i++)
-    {
-        port->WriteData(i % 0x100);
-    }
-    gettimeofday(&tv2, 0);
+    timeForPortCmdInNs = port->MeasureWriteTime(1000);
     if (useSleepInit)
         nSleepDeInit();
-    timeForPortCmdInNs = (tv2.tv_sec - tv1.tv_sec) * 1000000 + (tv2.tv_usec - tv1.tv_usec);
+    // the calibration spins and sleeps for a while, only needed by the calibrated method
+    if (Config.waitMethod == kWaitCalibrated)
+        GetWaitTimings(config->timings);
+    config->timings.portAccess = timeForPortCmdInNs;
     syslog(LOG_DEBUG, "%s: benchmark stopped. Time for Command: %ldns\n", config->name.c_str(), timeForPortCmdInNs);
 
     // initialize graphic mode
@@ -350,16 +346,16 @@ void cDriverSED1520::Refresh(bool refreshAll)
     unsigned char dByte, oneBlock[8];
 
     if (CheckSetup() > 0)
-        refreshAll = true;
+        ForceRefreshAll(refreshAll);
 
     if (config->refreshDisplay > 0)
     {
         refreshCounter = (refreshCounter + 1) % config->refreshDisplay;
         if (!refreshAll && !refreshCounter)
-            refreshAll = true;
+            ForceRefreshAll(refreshAll);
     }
 
-    refreshAll = true; // differential update is not yet supported
+    ForceRefreshAll(refreshAll); // differential update is not yet supported
 
     if (refreshAll)
     {
@@ -422,4 +418,9 @@ void cDriverSED1520::Refresh(bool refreshAll)
     }
 }
 
+bool cDriverSED1520::GetIOStats(uint64_t & bytes, uint64_t & syscalls) const
+{
+    return GetPortIOStats(port, bytes, syscalls);
+}
+
 } // end of namespace
@@ -528,7 +528,7 @@ void cDriverSerDisp::SetScreen(const unsigned char * data, int wid, int hgt, int
 void cDriverSerDisp::Refresh(bool refreshAll)
 {
     if (CheckSetup() == 1)
-        refreshAll = true;
+        ForceRefreshAll(refreshAll);
 
     if (refreshAll)
         fp_serdisp_rewrite(dd);
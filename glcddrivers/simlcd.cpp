@@ -139,7 +139,7 @@ void cDriverSimLCD::Refresh(bool refreshAll)
     int y;
 
     if (CheckSetup() > 0)
-        refreshAll = true;
+        ForceRefreshAll(refreshAll);
 
     fp = fopen(DISPLAY_REFRESH_FILE, "r");
     if (!fp || refreshAll)
@@ -269,16 +269,16 @@ void cDriverSSD1306::Refresh(bool refreshAll)
     unsigned char data[16];
 
     if (CheckSetup() == 1)
-        refreshAll = true;
+        ForceRefreshAll(refreshAll);
 
     if (config->refreshDisplay > 0)
     {
         refreshCounter = (refreshCounter + 1) % config->refreshDisplay;
         if (!refreshAll && !refreshCounter)
-            refreshAll = true;
+            ForceRefreshAll(refreshAll);
     }
 
-    refreshAll = true;
+    ForceRefreshAll(refreshAll);
     if (refreshAll)
     {
         WriteCommand(kCmdSetColumnAddress, 0, width - 1);
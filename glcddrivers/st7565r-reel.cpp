@@ -217,6 +217,7 @@ void cDriverST7565RReel::Refresh(bool refreshAll)
             display_data( d,32);
         }
     }
+    port->Flush();
 
 // syslog(LOG_INFO, "refresh.\n");
 }
@@ -269,6 +270,7 @@ void cDriverST7565RReel::set_displaymode(unsigned char m)
 {
     unsigned char buf[]={0xa5,0x09,m};
     port->WriteData(buf, 3);
+    port->Flush();
 //    syslog(LOG_INFO, "displaymode.\n");
 }
 
@@ -280,6 +282,7 @@ void cDriverST7565RReel::SetBrightness(unsigned int percent)
         n=255;
     buf[2]=(char)(n);
     port->WriteData(buf,4);
+    port->Flush();
 }
 
 void cDriverST7565RReel::SetContrast(unsigned int val)
@@ -287,7 +290,13 @@ void cDriverST7565RReel::SetContrast(unsigned int val)
     unsigned char buf[]={0xa5,0x03, 0x00, 0x00};
     buf[2]=(char)(val*25);
     port->WriteData(buf,4);
+    port->Flush();
 }
 
 
+bool cDriverST7565RReel::GetIOStats(uint64_t & bytes, uint64_t & syscalls) const
+{
+    return GetPortIOStats(port, bytes, syscalls);
+}
+
 }
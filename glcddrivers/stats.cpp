@@ -0,0 +1,182 @@
+/*
+ * GraphLCD driver library
+ *
+ * stats.c  -  statistics of a driver
+ *             Counts the frames of a driver and the time spent in
+ *             it, optionally written to syslog or a file periodically.
+ *
+ * This file is released under the GNU General Public License. Refer
+ * to the COPYING file distributed with this package.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <syslog.h>
+#include <time.h>
+
+#include "config.h"
+#include "stats.h"
+
+
+namespace GLCD
+{
+
+cDriverStats::cDriverStats(cDriver * Driver, cDriverConfig * config)
+:   cDriver(config),
+    mDriver(Driver),
+    mLastDump(0)
+{
+    memset(&mStats, 0, sizeof(mStats));
+}
+
+cDriverStats::~cDriverStats()
+{
+    delete mDriver;
+}
+
+uint64_t cDriverStats::Now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+int cDriverStats::Init()
+{
+    int ret = mDriver->Init();
+    if (ret != 0)
+        return ret;
+
+    width = mDriver->Width();
+    height = mDriver->Height();
+    bgcol = mDriver->GetBackgroundColor();
+    fgcol = mDriver->GetForegroundColor();
+
+    memset(&mStats, 0, sizeof(mStats));
+    mLastDump = Now();
+    return 0;
+}
+
+int cDriverStats::DeInit()
+{
+    if (config->statsInterval > 0)
+        Dump();
+    return mDriver->DeInit();
+}
+
+void cDriverStats::Clear()
+{
+    mDriver->Clear();
+}
+
+void cDriverStats::SetPixel(int x, int y, uint32_t data)
+{
+    mDriver->SetPixel(x, y, data);
+}
+
+void cDriverStats::SetScreenRect(const uint32_t * data, int stride, int x, int y, int w, int h)
+{
+    uint64_t start = Now();
+    mDriver->SetScreenRect(data, stride, x, y, w, h);
+    mStats.setScreenTime += Now() - start;
+}
+
+void cDriverStats::SetScreen1BPP(const unsigned char * data, int wid, int hgt, int lineSize)
+{
+    uint64_t start = Now();
+    mDriver->SetScreen1BPP(data, wid, hgt, lineSize);
+    mStats.setScreenTime += Now() - start;
+}
+
+void cDriverStats::Refresh(bool refreshAll)
+{
+    uint64_t forced = mDriver->GetForcedRefreshes();
+    uint64_t start = Now();
+    mDriver->Refresh(refreshAll);
+    uint64_t end = Now();
+
+    mStats.refreshTime += end - start;
+    mStats.frames++;
+    if (refreshAll || mDriver->GetForcedRefreshes() != forced)
+        mStats.fullRefreshes++;
+
+    if (config->statsInterval > 0 && end - mLastDump >= config->statsInterval * 1000000000ULL)
+    {
+        Dump();
+        mLastDump = end;
+    }
+}
+
+void cDriverStats::Dump(void)
+{
+    tDriverStats stats;
+    GetStats(stats);
+
+    if (config->statsFile.length() == 0)
+    {
+        syslog(LOG_INFO, "%s: %llu frames (%llu full), %llu bytes, %llu syscalls, setscreen %llu ms, refresh %llu ms\n",
+               config->name.c_str(), (unsigned long long) stats.frames, (unsigned long long) stats.fullRefreshes,
+               (unsigned long long) stats.bytes, (unsigned long long) stats.syscalls,
+               (unsigned long long) stats.setScreenTime / 1000000, (unsigned long long) stats.refreshTime / 1000000);
+        return;
+    }
+
+    FILE * fp = fopen(config->statsFile.c_str(), "a");
+    if (!fp)
+    {
+        syslog(LOG_ERR, "%s: error opening stats file %s: %s\n", config->name.c_str(), config->statsFile.c_str(), strerror(errno));
+        return;
+    }
+    // one line per dump: time and display, then the counters as name=value
+    fprintf(fp, "%ld %s frames=%llu fullrefreshes=%llu bytes=%llu syscalls=%llu setscreentime=%llu refreshtime=%llu\n",
+            (long) time(NULL), config->name.c_str(), (unsigned long long) stats.frames, (unsigned long long) stats.fullRefreshes,
+            (unsigned long long) stats.bytes, (unsigned long long) stats.syscalls,
+            (unsigned long long) stats.setScreenTime, (unsigned long long) stats.refreshTime);
+    fclose(fp);
+}
+
+void cDriverStats::SetBrightness(unsigned int percent)
+{
+    mDriver->SetBrightness(percent);
+}
+
+bool cDriverStats::SetFeature(const std::string & Feature, int value)
+{
+    return mDriver->SetFeature(Feature, value);
+}
+
+cGLCDEvent * cDriverStats::GetEvent(void)
+{
+    return mDriver->GetEvent();
+}
+
+bool cDriverStats::GetStats(tDriverStats & stats) const
+{
+    stats = mStats;
+    if (!mDriver->GetIOStats(stats.bytes, stats.syscalls))
+        stats.bytes = stats.syscalls = 0;
+    return true;
+}
+
+bool cDriverStats::GetIOStats(uint64_t & bytes, uint64_t & syscalls) const
+{
+    return mDriver->GetIOStats(bytes, syscalls);
+}
+
+uint64_t cDriverStats::GetForcedRefreshes(void) const
+{
+    return mDriver->GetForcedRefreshes();
+}
+
+bool cDriverStats::GetDriverFeature(const std::string & Feature, int & value)
+{
+    return mDriver->GetFeature(Feature, value);
+}
+
+uint32_t cDriverStats::GetDefaultBackgroundColor(void)
+{
+    return mDriver ? mDriver->GetBackgroundColor(true) : cDriver::GetDefaultBackgroundColor();
+}
+
+} // end of namespace
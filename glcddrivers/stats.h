@@ -0,0 +1,68 @@
+/*
+ * GraphLCD driver library
+ *
+ * stats.h  -  statistics of a driver
+ *             Counts the frames of a driver and the time spent in
+ *             it, optionally written to syslog or a file periodically.
+ *
+ * This file is released under the GNU General Public License. Refer
+ * to the COPYING file distributed with this package.
+ */
+
+#ifndef _GLCDDRIVERS_STATS_H_
+#define _GLCDDRIVERS_STATS_H_
+
+#include "driver.h"
+
+
+namespace GLCD
+{
+
+class cDriverConfig;
+
+// wraps a driver and collects its statistics (see tDriverStats). bytes and system calls
+// are taken from the GetIOStats() of the wrapped driver, full refreshes forced by the driver
+// from GetForcedRefreshes(). CreateDriver() puts it inside a cDriverAsync, so that with an
+// asynchronous refresh it counts the frames and times of the refresh thread.
+class cDriverStats : public cDriver
+{
+private:
+    cDriver * mDriver;
+    tDriverStats mStats;
+    uint64_t mLastDump;     // ns, monotonic clock
+
+    static uint64_t Now(void);
+    void Dump(void);
+
+protected:
+    virtual bool GetDriverFeature(const std::string & Feature, int & value);
+    virtual uint32_t GetDefaultBackgroundColor(void);
+
+public:
+    // takes over the ownership of Driver
+    cDriverStats(cDriver * Driver, cDriverConfig * config);
+    virtual ~cDriverStats();
+
+    virtual int Init();
+    virtual int DeInit();
+
+    virtual void Clear();
+    virtual void SetPixel(int x, int y, uint32_t data);
+    virtual void SetScreenRect(const uint32_t *data, int stride, int x, int y, int w, int h);
+    virtual void SetScreen1BPP(const unsigned char *data, int width, int height, int lineSize);
+    virtual void Refresh(bool refreshAll = false);
+
+    virtual void SetBrightness(unsigned int percent);
+    virtual bool SetFeature(const std::string & Feature, int value);
+    virtual cGLCDEvent * GetEvent(void);
+
+    virtual bool GetStats(tDriverStats & stats) const;
+    virtual bool GetIOStats(uint64_t & bytes, uint64_t & syscalls) const;
+    virtual uint64_t GetForcedRefreshes(void) const;
+
+    cDriver * Driver(void) const { return mDriver; }
+};
+
+} // end of namespace
+
+#endif
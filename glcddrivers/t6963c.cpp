@@ -372,6 +372,7 @@ void cDriverT6963C::Clear()
 {
     for (int x = 0; x < (width + (FS - 1)) / FS; x++)
         memset(newLCD[x], 0, height);
+    MarkDirty();
 }
 
 
@@ -399,6 +400,7 @@ void cDriverT6963C::SetPixel(int x, int y, uint32_t data)
             newLCD[col][y] |= (1 << pos);
         else
             newLCD[col][y] &= ( 0x3F ^ (1 << pos) );        
+        MarkDirty(x, y);
     }
     else
     {
@@ -415,10 +417,62 @@ void cDriverT6963C::SetPixel(int x, int y, uint32_t data)
             newLCD[x / 8][y] |= (1 << pos);
         else
             newLCD[x / 8][y] &= ( 0xFF ^ (1 << pos) );
+        MarkDirty(x, y);
     }
 }
 
 
+void cDriverT6963C::SetScreen1BPP(const unsigned char * data, int wid, int hgt, int lineSize)
+{
+    int x = 0, y = 0;
+
+    if (!data || !ClipScreenRect(x, y, wid, hgt))
+        return;
+
+    // with 8 pixels per byte the bytes of a line are the bytes of the display,
+    // rotated by 180° they are reversed (if the bytes line up with the right border)
+    int bytes = 0;
+    if (FS == 8 && (!config->upsideDown || width % 8 == 0))
+        bytes = wid / 8;
+
+    if (bytes > 0)
+    {
+        for (int yt = 0; yt < hgt; yt++)
+        {
+            const unsigned char * line = data + yt * lineSize;
+            if (config->upsideDown)
+            {
+                int row = height - 1 - yt;
+                for (int c = 0; c < bytes; c++)
+                    newLCD[width / 8 - 1 - c][row] = ReverseBits(line[c]);
+            }
+            else
+            {
+                for (int c = 0; c < bytes; c++)
+                    newLCD[c][yt] = line[c];
+            }
+        }
+        if (config->upsideDown)
+        {
+            MarkDirty(width - bytes * 8, height - hgt);
+            MarkDirty(width - 1, height - 1);
+        }
+        else
+        {
+            MarkDirty(0, 0);
+            MarkDirty(bytes * 8 - 1, hgt - 1);
+        }
+    }
+
+    // the remaining pixels (and all with 6 pixels per byte) one by one
+    for (int yt = 0; yt < hgt; yt++)
+    {
+        const unsigned char * line = data + yt * lineSize;
+        for (int xt = bytes * 8; xt < wid; xt++)
+            cDriverT6963C::SetPixel(xt, yt, (line[xt >> 3] & (0x80 >> (xt & 7))) ? GRAPHLCD_White : GRAPHLCD_Black);
+    }
+}
+
 #if 0
 void cDriverT6963C::Set8Pixels(int x, int y, unsigned char data)
 {
@@ -498,13 +552,13 @@ void cDriverT6963C::Refresh(bool refreshAll)
     int addr = 0;
 
     if (CheckSetup() == 1)
-        refreshAll = true;
+        ForceRefreshAll(refreshAll);
 
     if (config->refreshDisplay > 0)
     {
         refreshCounter = (refreshCounter + 1) % config->refreshDisplay;
         if (!refreshAll && !refreshCounter)
-            refreshAll = true;
+            ForceRefreshAll(refreshAll);
     }
 
     port->Claim();
@@ -536,14 +590,27 @@ void cDriverT6963C::Refresh(bool refreshAll)
         // and reset RefreshCounter
         refreshCounter = 0;
     }
-    else
+    else if (!dirtyArea.IsEmpty())
     {
-        // draw only the changed bytes
+        // draw only the changed bytes inside the area touched since the last refresh
+        int cols = (width + (FS - 1)) / FS;
+        int xFirst = dirtyArea.x1 / FS;
+        int xLast = dirtyArea.x2 / FS;
 
         bool cs = false;
-        for (y = 0; y < height; y++)
+        for (y = dirtyArea.y1; y <= dirtyArea.y2; y++)
         {
-            for (x = 0; x < (width + (FS - 1)) / FS; x++)
+            if (xFirst > 0 || xLast < cols - 1)
+            {
+                // the address pointer only continues into the next line if whole lines are written
+                if (autoWrite)
+                {
+                    T6963CCommand(kAutoReset);
+                    autoWrite = false;
+                }
+                cs = false;
+            }
+            for (x = xFirst; x <= xLast; x++)
             {
                 if (oldLCD[x][y] != newLCD[x][y])
                 {
@@ -584,15 +651,17 @@ void cDriverT6963C::Refresh(bool refreshAll)
             autoWrite = false;
         }
     }
+    ResetDirty();
     port->Release();
 }
 
 void cDriverT6963C::T6963CSetControl(unsigned char flags)
 {
+    // queued, executed when the port is released or read from
     unsigned char status = port->ReadControl();
     status &= 0xF0; // mask 4 bits
     status |= flags; // add new flags
-    port->WriteControl(status);
+    port->QueueControl(status);
 }
 
 void cDriverT6963C::T6963CDSPReady()
@@ -651,7 +720,7 @@ void cDriverT6963C::T6963CData(unsigned char data)
             T6963CDSPReady();
         T6963CSetControl(WRHI | CEHI | CDLO | RDHI); // CD down (data)
         T6963CSetControl(WRLO | CELO | CDLO | RDHI); // CE & WR down
-        port->WriteData(data);
+        port->QueueData(data);
         T6963CSetControl(WRHI | CEHI | CDLO | RDHI); // CE & WR up again
         T6963CSetControl(WRHI | CEHI | CDHI | RDHI); // CD up again
     }
@@ -687,7 +756,7 @@ void cDriverT6963C::T6963CCommand(unsigned char cmd)
             T6963CDSPReady();
         T6963CSetControl(WRHI | CEHI | CDHI | RDHI); // CD up (command)
         T6963CSetControl(WRLO | CELO | CDHI | RDHI); // CE & WR down
-        port->WriteData(cmd);
+        port->QueueData(cmd);
         T6963CSetControl(WRHI | CEHI | CDHI | RDHI); // CE & WR up again
         T6963CSetControl(WRHI | CEHI | CDLO | RDHI); // CD down again
     }
@@ -722,4 +791,9 @@ void cDriverT6963C::T6963CDisplayMode(unsigned char mode, bool enable)
     T6963CCommand(kSetDisplayMode | displayMode);
 }
 
+bool cDriverT6963C::GetIOStats(uint64_t & bytes, uint64_t & syscalls) const
+{
+    return GetPortIOStats(port, bytes, syscalls);
+}
+
 }
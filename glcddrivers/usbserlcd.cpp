@@ -185,13 +185,13 @@ void cDriverUSBserLCD::Refresh(bool refreshAll)
     uint16_t addr = 0;
 
     if (CheckSetup() == 1)
-        refreshAll = true;
+        ForceRefreshAll(refreshAll);
 
     if (config->refreshDisplay > 0)
     {
         refreshCounter = (refreshCounter + 1) % config->refreshDisplay;
         if (!refreshAll && !refreshCounter)
-            refreshAll = true;
+            ForceRefreshAll(refreshAll);
     }
 
     // draw all
@@ -212,6 +212,7 @@ void cDriverUSBserLCD::Refresh(bool refreshAll)
 
     if (refreshAll) {
         port->WriteData(full_seq);
+        port->Flush();
         // and reset RefreshCounter
         refreshCounter = 0;
         return;
@@ -257,6 +258,7 @@ void cDriverUSBserLCD::Refresh(bool refreshAll)
         port->WriteData(part_seq);
     else
         port->WriteData(full_seq);
+    port->Flush();
 }
 
 void cDriverUSBserLCD::SetBrightness(unsigned int percent)
@@ -266,6 +268,7 @@ void cDriverUSBserLCD::SetBrightness(unsigned int percent)
     pkg += PKGTYPE_BRIGHTNESS;
     pkg += brightness;
     port->WriteData(pkg);
+    port->Flush();
 }
 
 
@@ -293,4 +296,9 @@ cDriverUSBserLCDBuffer::operator std::string() const
 }
 
 
+bool cDriverUSBserLCD::GetIOStats(uint64_t & bytes, uint64_t & syscalls) const
+{
+    return GetPortIOStats(port, bytes, syscalls);
+}
+
 } // end of namespace
@@ -47,6 +47,7 @@ public:
     virtual void Clear();
     virtual void SetPixel(int x, int y, uint32_t data);
     virtual void Refresh(bool refreshAll = false);
+    virtual bool GetIOStats(uint64_t & bytes, uint64_t & syscalls) const;
     virtual void SetBrightness(unsigned int percent);
 };
 
@@ -19,9 +19,13 @@
 #include <string.h>
 #include <math.h>
 
+#include <algorithm>
+
 #include "bitmap.h"
+#include "blend.h"
 #include "common.h"
 #include "font.h"
+#include "pixfmt.h"
 
 
 namespace GLCD
@@ -86,21 +90,100 @@ const unsigned char bitmask[8]  = {0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x0
 const unsigned char bitmaskl[8] = {0x80, 0xc0, 0xe0, 0xf0, 0xf8, 0xfc, 0xfe, 0xff};
 const unsigned char bitmaskr[8] = {0xff, 0x7f, 0x3f, 0x1f, 0x0f, 0x07, 0x03, 0x01};
 
+// max. number of separate damage rectangles before they are merged into one
+static const size_t kMaxDamageRects = 8;
+
+// drawing into the formats other than pfARGB32, instantiated per format (see pixfmt.h)
+
+template <class F>
+static void FillNative(unsigned char * line, int x1, int x2, uint32_t color, bool blend)
+{
+    uint32_t alpha = color >> 24;
+
+    if (!blend || alpha == 255)
+    {
+        F::Fill(line, x1, x2, F::Encode(color));
+        return;
+    }
+    if (F::Levels > 0)
+    {
+        // only a few different results, each one is blended once
+        uint32_t blended[F::Levels > 0 ? F::Levels : 1];
+        for (int v = 0; v < F::Levels; v++)
+            blended[v] = F::Encode(BlendPixel(F::Decode(v), color, alpha));
+        for (int x = x1; x <= x2; x++)
+            F::Set(line, x, blended[F::Get(line, x)]);
+        return;
+    }
+    for (int x = x1; x <= x2; x++)
+        F::Set(line, x, F::Encode(BlendPixel(F::Decode(F::Get(line, x)), color, alpha)));
+}
+
+// draws count ARGB pixels starting at x, pixels with alpha 0 (after applying opacity) are skipped
+template <class F>
+static void BlendLineNative(unsigned char * line, int x, const uint32_t * src, int count, int opacity, bool blend)
+{
+    for (int i = 0; i < count; i++)
+    {
+        uint32_t cl = src[i];
+        uint32_t alpha = cl >> 24;
+
+        if (opacity != 255)
+            alpha = Div255(alpha * opacity);
+        if (alpha == 0)
+            continue;
+        if (blend && alpha != 255)
+            cl = BlendPixel(F::Decode(F::Get(line, x + i)), cl, alpha);
+        F::Set(line, x + i, F::Encode(cl));
+    }
+}
+
+template <class F>
+static void DecodeLine(const unsigned char * line, int x, int count, uint32_t * dst)
+{
+    for (int i = 0; i < count; i++)
+        dst[i] = F::Decode(F::Get(line, x + i));
+}
+
+template <class F>
+static void ClearNative(unsigned char * pixels, int lineSize, int width, int height, uint32_t color)
+{
+    F::Fill(pixels, 0, width - 1, F::Encode(color));
+    for (int y = 1; y < height; y++)
+        memcpy(pixels + y * lineSize, pixels, lineSize);
+}
+
+static void BlendLine(ePixelFormat format, unsigned char * line, int x, const uint32_t * src, int count, int opacity, bool blend)
+{
+    switch (format)
+    {
+        case pfMono:   BlendLineNative<tFormatMono>(line, x, src, count, opacity, blend); break;
+        case pfGrey4:  BlendLineNative<tFormatGrey4>(line, x, src, count, opacity, blend); break;
+        case pfRGB565: BlendLineNative<tFormatRGB565>(line, x, src, count, opacity, blend); break;
+        default: break;
+    }
+}
+
 cBitmap::cBitmap(int width, int height, uint32_t * data)
 :   width(width),
     height(height),
+    lineSize(width * sizeof(uint32_t)),
+    format(pfARGB32),
     bitmap(NULL),
+    pixels(NULL),
     ismonochrome(false),
     processAlpha(true)
 {
 #ifdef HAVE_DEBUG
     printf("%s:%s(%d) cBitmap Size %03d * %03d\n", __FILE__, __FUNCTION__, __LINE__, width, height);
 #endif
+    clipArea = tRect(0, 0, width - 1, height - 1);
     if (width > 0 && height > 0) {
         bitmap = new uint32_t[width * height];
         if (data && bitmap) {
             memcpy(bitmap, data, width * height * sizeof(uint32_t));
         }
+        MergeDamage(clipArea);
     }
     backgroundColor = cColor::White;
 }
@@ -109,7 +192,10 @@ cBitmap::cBitmap(int width, int height, uint32_t * data)
 cBitmap::cBitmap(int width, int height, uint32_t initcol)
 :   width(width),
     height(height),
+    lineSize(width * sizeof(uint32_t)),
+    format(pfARGB32),
     bitmap(NULL),
+    pixels(NULL),
     ismonochrome(false),
     processAlpha(true)
 {
@@ -117,24 +203,65 @@ cBitmap::cBitmap(int width, int height, uint32_t initcol)
     printf("%s:%s(%d) cBitmap Size %03d * %03d\n", __FILE__, __FUNCTION__, __LINE__, width, height);
 #endif
 
+    clipArea = tRect(0, 0, width - 1, height - 1);
     if (width > 0 && height > 0) {
         bitmap = new uint32_t[width * height];
         Clear(initcol);
     }
 }
 
+cBitmap::cBitmap(int width, int height, ePixelFormat format, uint32_t initcol)
+:   width(width),
+    height(height),
+    format(format),
+    bitmap(NULL),
+    pixels(NULL),
+    ismonochrome(format == pfMono),
+    processAlpha(true)
+{
+#ifdef HAVE_DEBUG
+    printf("%s:%s(%d) cBitmap Size %03d * %03d, format %d\n", __FILE__, __FUNCTION__, __LINE__, width, height, format);
+#endif
+
+    switch (format)
+    {
+        case pfMono:   lineSize = (width + 7) / 8; break;
+        case pfGrey4:  lineSize = (width + 1) / 2; break;
+        case pfRGB565: lineSize = width * 2; break;
+        default:       lineSize = width * sizeof(uint32_t); break;
+    }
+    clipArea = tRect(0, 0, width - 1, height - 1);
+    if (width > 0 && height > 0) {
+        if (format == pfARGB32)
+            bitmap = new uint32_t[width * height];
+        else
+            pixels = new unsigned char[lineSize * height](); // unused bits at the end of a line stay 0
+        Clear(initcol);
+    }
+}
+
 cBitmap::cBitmap(const cBitmap & b)
 {
     width = b.width;
     height = b.height;
     lineSize = b.lineSize;
+    format = b.format;
     backgroundColor = b.backgroundColor;
     ismonochrome = b.ismonochrome;
     processAlpha = b.processAlpha;
-    bitmap = new uint32_t[b.width * b.height];
-    if (b.bitmap && bitmap) {
+    damage = b.damage;
+    clipArea = b.clipArea;
+    clipStack = b.clipStack;
+    bitmap = NULL;
+    pixels = NULL;
+    if (b.bitmap) {
+        bitmap = new uint32_t[b.width * b.height];
         memcpy(bitmap, b.bitmap, b.width * b.height * sizeof(uint32_t));
     }
+    if (b.pixels) {
+        pixels = new unsigned char[b.lineSize * b.height];
+        memcpy(pixels, b.pixels, b.lineSize * b.height);
+    }
 }
 
 cBitmap::~cBitmap()
@@ -142,6 +269,8 @@ cBitmap::~cBitmap()
     if (bitmap)
         delete[] bitmap;
     bitmap = NULL;
+    delete[] pixels;
+    pixels = NULL;
 }
 
 void cBitmap::Clear(uint32_t color)
@@ -155,49 +284,232 @@ void cBitmap::Clear(uint32_t color)
     if ( color != cColor::Transparent )
         color = (color & 0x00FFFFFF) | 0xFF000000;
 
-    for (int i = 0; i < width * height; i++)
-        bitmap[i] = color;
+    if (pixels)
+    {
+        // no alpha channel, transparent becomes black
+        if (color == cColor::Transparent)
+            color = cColor::Black;
+        switch (format)
+        {
+            case pfMono:   ClearNative<tFormatMono>(pixels, lineSize, width, height, color); break;
+            case pfGrey4:  ClearNative<tFormatGrey4>(pixels, lineSize, width, height, color); break;
+            case pfRGB565: ClearNative<tFormatRGB565>(pixels, lineSize, width, height, color); break;
+            default: break;
+        }
+    }
+    else if (bitmap)
+        std::fill_n(bitmap, width * height, color);
     backgroundColor = color;
+    MergeDamage(tRect(0, 0, width - 1, height - 1));
+}
+
+void cBitmap::ClearArea(int x1, int y1, int x2, int y2, uint32_t color)
+{
+    sort(x1, x2);
+    sort(y1, y2);
+    tRect area(x1, y1, x2, y2);
+    area.Intersect(clipArea);
+    if (area.IsEmpty())
+        return;
+
+    // same colours as Clear()
+    if ( color != cColor::Transparent )
+        color = (color & 0x00FFFFFF) | 0xFF000000;
+
+    for (int y = area.y1; y <= area.y2; y++)
+    {
+        if (pixels)
+        {
+            unsigned char * line = pixels + y * lineSize;
+            uint32_t c = (color == cColor::Transparent) ? (uint32_t) cColor::Black : color;
+            switch (format)
+            {
+                case pfMono:   tFormatMono::Fill(line, area.x1, area.x2, tFormatMono::Encode(c)); break;
+                case pfGrey4:  tFormatGrey4::Fill(line, area.x1, area.x2, tFormatGrey4::Encode(c)); break;
+                case pfRGB565: tFormatRGB565::Fill(line, area.x1, area.x2, tFormatRGB565::Encode(c)); break;
+                default: break;
+            }
+        }
+        else if (bitmap)
+            std::fill_n(bitmap + y * width + area.x1, area.Width(), color);
+    }
+    AddDamage(area.x1, area.y1, area.x2, area.y2);
 }
 
 void cBitmap::Invert()
 {
     int i;
 
-    for (i = 0; i < width * height; i++)
+    if (pixels)
+    {
+        // all bits of a pixel inverted inverts its colour in each of the native formats
+        for (i = 0; i < lineSize * height; i++)
+            pixels[i] ^= 0xFF;
+    }
+    else if (bitmap)
+    {
+        for (i = 0; i < width * height; i++)
+            bitmap[i] ^= 0xFFFFFF;
+    }
+    MergeDamage(tRect(0, 0, width - 1, height - 1));
+}
+
+void cBitmap::AddDamage(int x1, int y1, int x2, int y2)
+{
+    sort(x1, x2);
+    sort(y1, y2);
+
+    // nothing outside the clip area is changed by drawing
+    tRect rect(x1, y1, x2, y2);
+    rect.Intersect(clipArea);
+    if (rect.IsEmpty())
+        return;
+    MergeDamage(rect);
+}
+
+void cBitmap::MergeDamage(tRect rect)
+{
+    std::vector<tRect>::iterator it;
+
+    // most recently added areas first: drawing primitives record their bounding box before drawing
+    for (std::vector<tRect>::reverse_iterator rit = damage.rbegin(); rit != damage.rend(); rit++)
+    {
+        if (rit->Contains(rect))
+            return;
+    }
+
+    // merge with all overlapping or adjacent areas (a merged area may touch further ones)
+    it = damage.begin();
+    while (it != damage.end())
+    {
+        if (it->Touches(rect))
+        {
+            rect.Unite(*it);
+            damage.erase(it);
+            it = damage.begin();
+        }
+        else
+            it++;
+    }
+    damage.push_back(rect);
+
+    if (damage.size() > kMaxDamageRects)
+    {
+        tRect bbox;
+        for (it = damage.begin(); it != damage.end(); it++)
+            bbox.Unite(*it);
+        damage.clear();
+        damage.push_back(bbox);
+    }
+}
+
+void cBitmap::PushClip(int x1, int y1, int x2, int y2)
+{
+    sort(x1, x2);
+    sort(y1, y2);
+    clipStack.push_back(clipArea);
+    clipArea.Intersect(tRect(x1, y1, x2, y2));
+}
+
+void cBitmap::PopClip(void)
+{
+    if (clipStack.empty())
+        return;
+    clipArea = clipStack.back();
+    clipStack.pop_back();
+}
+
+void cBitmap::FillSpan(int x1, int x2, int y, uint32_t color)
+{
+    sort(x1, x2);
+    if (color == cColor::Transparent || y < clipArea.y1 || y > clipArea.y2)
+        return;
+    x1 = std::max(x1, clipArea.x1);
+    x2 = std::min(x2, clipArea.x2);
+    if (x1 > x2)
+        return;
+
+    if (pixels)
+    {
+        unsigned char * line = pixels + y * lineSize;
+        switch (format)
+        {
+            case pfMono:   FillNative<tFormatMono>(line, x1, x2, color, processAlpha); break;
+            case pfGrey4:  FillNative<tFormatGrey4>(line, x1, x2, color, processAlpha); break;
+            case pfRGB565: FillNative<tFormatRGB565>(line, x1, x2, color, processAlpha); break;
+            default: break;
+        }
+        return;
+    }
+
+    uint32_t * dst = bitmap + y * width + x1;
+    if (processAlpha)
+        BlendSpan(dst, color, x2 - x1 + 1);
+    else
+        std::fill_n(dst, x2 - x1 + 1, color);
+}
+
+void cBitmap::FillRect(int x1, int y1, int x2, int y2, uint32_t color)
+{
+    sort(x1, x2);
+    sort(y1, y2);
+    tRect area(x1, y1, x2, y2);
+    area.Intersect(clipArea);
+    if (color == cColor::Transparent || area.IsEmpty())
+        return;
+
+    if (pixels)
+    {
+        for (int y = area.y1; y <= area.y2; y++)
+            FillSpan(area.x1, area.x2, y, color);
+        return;
+    }
+
+    // whole lines are consecutive, they are filled in one go
+    if ((!processAlpha || (color & 0xFF000000) == 0xFF000000) && area.Width() == width)
+    {
+        std::fill_n(bitmap + area.y1 * width, width * area.Height(), color);
+        return;
+    }
+    for (int y = area.y1; y <= area.y2; y++)
     {
-        bitmap[i] ^= 0xFFFFFF;
+        uint32_t * dst = bitmap + y * width + area.x1;
+        if (processAlpha)
+            BlendSpan(dst, color, area.Width());
+        else
+            std::fill_n(dst, area.Width(), color);
     }
 }
 
 void cBitmap::DrawPixel(int x, int y, uint32_t color)
 {
-    if (x < 0 || x > width - 1)
+    if (x < clipArea.x1 || x > clipArea.x2)
         return;
-    if (y < 0 || y > height - 1)
+    if (y < clipArea.y1 || y > clipArea.y2)
+        return;
+
+    if (color != GLCD::cColor::Transparent)
+        AddDamage(x, y, x, y);
+    PutPixel(x, y, color);
+}
+
+void cBitmap::PutPixel(int x, int y, uint32_t color)
+{
+    if (x < clipArea.x1 || x > clipArea.x2)
+        return;
+    if (y < clipArea.y1 || y > clipArea.y2)
         return;
 
     if (color != GLCD::cColor::Transparent) {
         uint32_t col = cColor::AlignAlpha(color);
+        if (pixels) {
+            FillSpan(x, x, y, col);
+            return;
+        }
         if (processAlpha) {
-            uint32_t bg = bitmap[x + (width * y)];
-            uint32_t afg = (col & 0xFF000000) >> 24;
-            uint32_t rfg = (col & 0x00FF0000) >> 16;
-            uint32_t gfg = (col & 0x0000FF00) >> 8;
-            uint32_t bfg = (col & 0x000000FF);
-
-            uint32_t rbg = (bg & 0x00FF0000) >> 16;
-            uint32_t gbg = (bg & 0x0000FF00) >> 8;
-            uint32_t bbg = (bg & 0x000000FF);
-            
-            // calculate colour channels of new colour depending on alpha channel and background colour
-            rfg = (rfg * afg + rbg * (255 - afg)) / 255;
-            gfg = (gfg * afg + gbg * (255 - afg)) / 255;
-            bfg = (bfg * afg + bbg * (255 - afg)) / 255;
-            
             // as we draw from bottom to top, the new colour will always have alpha level == 0xFF
             // (it will serve as background colour for future objects that will be drawn onto the current object)
-            col = 0xFF000000 | (rfg << 16) | (gfg << 8) | bfg;
+            col = BlendPixel(bitmap[x + (width * y)], col, col >> 24);
         }
         bitmap[x + (width * y)] = col;
     }
@@ -212,6 +524,7 @@ void cBitmap::DrawLine(int x1, int y1, int x2, int y2, uint32_t color)
     unsigned int ax, ay;
 
     color = cColor::AlignAlpha(color);
+    AddDamage(x1, y1, x2, y2);
 
     dx = x2 - x1;
     ax = abs(dx) << 1;
@@ -227,7 +540,7 @@ void cBitmap::DrawLine(int x1, int y1, int x2, int y2, uint32_t color)
     else
         sy = 1;
 
-    DrawPixel(x1, y1, color);
+    PutPixel(x1, y1, color);
     if (ax > ay)
     {
         d = ay - (ax >> 1);
@@ -240,7 +553,7 @@ void cBitmap::DrawLine(int x1, int y1, int x2, int y2, uint32_t color)
             }
             x1 += sx;
             d += ay;
-            DrawPixel(x1, y1, color);
+            PutPixel(x1, y1, color);
         }
     }
     else
@@ -255,7 +568,7 @@ void cBitmap::DrawLine(int x1, int y1, int x2, int y2, uint32_t color)
             }
             y1 += sy;
             d += ax;
-            DrawPixel(x1, y1, color);
+            PutPixel(x1, y1, color);
         }
     }
 }
@@ -266,12 +579,9 @@ void cBitmap::DrawHLine(int x1, int y, int x2, uint32_t color)
     printf("%s:%s(%d) %03d -> %03d, %03d (color %08x)\n", __FILE__, __FUNCTION__, __LINE__, x1, x2, y, color);
 #endif
     color = cColor::AlignAlpha(color);
+    AddDamage(x1, y, x2, y);
 
-    sort(x1,x2);
-    while (x1 <= x2) {
-      DrawPixel(x1, y, color);
-      x1++;
-    };
+    FillSpan(x1, x2, y, color);
 }
 
 void cBitmap::DrawVLine(int x, int y1, int y2, uint32_t color)
@@ -280,12 +590,9 @@ void cBitmap::DrawVLine(int x, int y1, int y2, uint32_t color)
     printf("%s:%s(%d) %03d, %03d -> %03d (color %08x)\n", __FILE__, __FUNCTION__, __LINE__, x, y1, y2, color);
 #endif
     color = cColor::AlignAlpha(color);
+    AddDamage(x, y1, x, y2);
 
-    sort(y1,y2);
-    while (y1 <= y2) {
-      DrawPixel(x, y1, color);
-      y1++;
-    }
+    FillRect(x, y1, x, y2, color);
 }
 
 void cBitmap::DrawRectangle(int x1, int y1, int x2, int y2, uint32_t color, bool filled)
@@ -293,26 +600,22 @@ void cBitmap::DrawRectangle(int x1, int y1, int x2, int y2, uint32_t color, bool
 #ifdef HAVE_DEBUG
     printf("%s:%s(%d) %03d * %03d -> %03d * %03d (color %08x)\n", __FILE__, __FUNCTION__, __LINE__, x1, y1, x2, y2, color);
 #endif
-    int y;
-
     color = cColor::AlignAlpha(color);
 
     sort(x1,x2);
     sort(y1,y2);
+    AddDamage(x1, y1, x2, y2);
 
     if (!filled)
     {
-        DrawHLine(x1, y1, x2, color);
-        DrawVLine(x1, y1, y2, color);
-        DrawHLine(x1, y2, x2, color);
-        DrawVLine(x2, y1, y2, color);
+        FillSpan(x1, x2, y1, color);
+        FillRect(x1, y1, x1, y2, color);
+        FillSpan(x1, x2, y2, color);
+        FillRect(x2, y1, x2, y2, color);
     }
     else
     {
-        for (y = y1; y <= y2; y++)
-        {
-            DrawHLine(x1, y, x2, color);
-        }
+        FillRect(x1, y1, x2, y2, color);
     }
 }
 
@@ -325,6 +628,7 @@ void cBitmap::DrawRoundRectangle(int x1, int y1, int x2, int y2, uint32_t color,
 
     sort(x1,x2);
     sort(y1,y2);
+    AddDamage(x1, y1, x2, y2);
 
     if (type > (x2 - x1) / 2)
         type = (x2 - x1) / 2;
@@ -333,43 +637,42 @@ void cBitmap::DrawRoundRectangle(int x1, int y1, int x2, int y2, uint32_t color,
 
     if (filled)
     {
-        DrawHLine(x1 + type, y1, x2 - type, color);
-        for (int y = y1 + 1; y < y1 + type; y++)
-            DrawHLine(x1 + 1, y, x2 - 1, color);
-        for (int y = y1 + type; y <= y2 - type; y++)
-            DrawHLine(x1, y, x2, color);
-        for (int y = y2 - type + 1; y < y2; y++)
-            DrawHLine(x1 + 1, y, x2 - 1, color);
-        DrawHLine(x1 + type, y2, x2 - type, color);
+        FillSpan(x1 + type, x2 - type, y1, color);
+        if (type > 1)
+            FillRect(x1 + 1, y1 + 1, x2 - 1, y1 + type - 1, color);
+        FillRect(x1, y1 + type, x2, y2 - type, color);
+        if (type > 1)
+            FillRect(x1 + 1, y2 - type + 1, x2 - 1, y2 - 1, color);
+        FillSpan(x1 + type, x2 - type, y2, color);
         if (type == 4)
         {
             // round the ugly fat box...
-//            DrawPixel(x1 + 1, y1 + 1, color == clrWhite ? clrBlack : clrWhite);
-//            DrawPixel(x1 + 1, y2 - 1, color == clrWhite ? clrBlack : clrWhite);
-//            DrawPixel(x2 - 1, y1 + 1, color == clrWhite ? clrBlack : clrWhite);
-//            DrawPixel(x2 - 1, y2 - 1, color == clrWhite ? clrBlack : clrWhite);
-            DrawPixel(x1 + 1, y1 + 1, backgroundColor);
-            DrawPixel(x1 + 1, y2 - 1, backgroundColor);
-            DrawPixel(x2 - 1, y1 + 1, backgroundColor);
-            DrawPixel(x2 - 1, y2 - 1, backgroundColor);
+//            PutPixel(x1 + 1, y1 + 1, color == clrWhite ? clrBlack : clrWhite);
+//            PutPixel(x1 + 1, y2 - 1, color == clrWhite ? clrBlack : clrWhite);
+//            PutPixel(x2 - 1, y1 + 1, color == clrWhite ? clrBlack : clrWhite);
+//            PutPixel(x2 - 1, y2 - 1, color == clrWhite ? clrBlack : clrWhite);
+            PutPixel(x1 + 1, y1 + 1, backgroundColor);
+            PutPixel(x1 + 1, y2 - 1, backgroundColor);
+            PutPixel(x2 - 1, y1 + 1, backgroundColor);
+            PutPixel(x2 - 1, y2 - 1, backgroundColor);
         }
     }
     else
     {
-        DrawHLine(x1 + type, y1, x2 - type, color);
-        DrawVLine(x1, y1 + type, y2 - type, color);
-        DrawVLine(x2, y1 + type, y2 - type, color);
-        DrawHLine(x1 + type, y2, x2 - type, color);
+        FillSpan(x1 + type, x2 - type, y1, color);
+        FillRect(x1, y1 + type, x1, y2 - type, color);
+        FillRect(x2, y1 + type, x2, y2 - type, color);
+        FillSpan(x1 + type, x2 - type, y2, color);
         if (type > 1)
         {
-            DrawHLine(x1 + 1, y1 + 1, x1 + type - 1, color);
-            DrawHLine(x2 - type + 1, y1 + 1, x2 - 1, color);
-            DrawHLine(x1 + 1, y2 - 1, x1 + type - 1, color);
-            DrawHLine(x2 - type + 1, y2 - 1, x2 - 1, color);
-            DrawVLine(x1 + 1, y1 + 1, y1 + type - 1, color);
-            DrawVLine(x1 + 1, y2 - 1, y2 - type + 1, color);
-            DrawVLine(x2 - 1, y1 + 1, y1 + type - 1, color);
-            DrawVLine(x2 - 1, y2 - 1, y2 - type + 1, color);
+            FillSpan(x1 + 1, x1 + type - 1, y1 + 1, color);
+            FillSpan(x2 - type + 1, x2 - 1, y1 + 1, color);
+            FillSpan(x1 + 1, x1 + type - 1, y2 - 1, color);
+            FillSpan(x2 - type + 1, x2 - 1, y2 - 1, color);
+            FillRect(x1 + 1, y1 + 1, x1 + 1, y1 + type - 1, color);
+            FillRect(x1 + 1, y2 - 1, x1 + 1, y2 - type + 1, color);
+            FillRect(x2 - 1, y1 + 1, x2 - 1, y1 + type - 1, color);
+            FillRect(x2 - 1, y2 - 1, x2 - 1, y2 - type + 1, color);
         }
     }
 }
@@ -380,6 +683,7 @@ void cBitmap::DrawEllipse(int x1, int y1, int x2, int y2, uint32_t color, bool f
     printf("%s:%s(%d) %03d * %03d -> %03d * %03d (color %08x)\n", __FILE__, __FUNCTION__, __LINE__, x1, y1, x2, y2, color);
 #endif
     color = cColor::AlignAlpha(color);
+    AddDamage(x1, y1, x2, y2);
 
     // Algorithm based on http://homepage.smc.edu/kennedy_john/BELIPSE.PDF
     int rx = x2 - x1;
@@ -413,38 +717,38 @@ void cBitmap::DrawEllipse(int x1, int y1, int x2, int y2, uint32_t color, bool f
         {
             switch (quadrants)
             {
-                case  5: DrawRectangle(cx,     cy + y, cx + x, cy + y, color, filled); // no break
-                case  1: DrawRectangle(cx,     cy - y, cx + x, cy - y, color, filled); break;
-                case  7: DrawRectangle(cx - x, cy + y, cx,     cy + y, color, filled); // no break
-                case  2: DrawRectangle(cx - x, cy - y, cx,     cy - y, color, filled); break;
-                case  3: DrawRectangle(cx - x, cy + y, cx,     cy + y, color, filled); break;
-                case  4: DrawRectangle(cx,     cy + y, cx + x, cy + y, color, filled); break;
+                case  5: FillSpan(cx,     cx + x, cy + y, color); // no break
+                case  1: FillSpan(cx,     cx + x, cy - y, color); break;
+                case  7: FillSpan(cx - x, cx,     cy + y, color); // no break
+                case  2: FillSpan(cx - x, cx,     cy - y, color); break;
+                case  3: FillSpan(cx - x, cx,     cy + y, color); break;
+                case  4: FillSpan(cx,     cx + x, cy + y, color); break;
                 case  0:
-                case  6: DrawRectangle(cx - x, cy - y, cx + x, cy - y, color, filled); if (quadrants == 6) break;
-                case  8: DrawRectangle(cx - x, cy + y, cx + x, cy + y, color, filled); break;
-                case -1: DrawRectangle(cx + x, cy - y, x2,     cy - y, color, filled); break;
-                case -2: DrawRectangle(x1,     cy - y, cx - x, cy - y, color, filled); break;
-                case -3: DrawRectangle(x1,     cy + y, cx - x, cy + y, color, filled); break;
-                case -4: DrawRectangle(cx + x, cy + y, x2,     cy + y, color, filled); break;
+                case  6: FillSpan(cx - x, cx + x, cy - y, color); if (quadrants == 6) break;
+                case  8: FillSpan(cx - x, cx + x, cy + y, color); break;
+                case -1: FillSpan(cx + x, x2,     cy - y, color); break;
+                case -2: FillSpan(x1,     cx - x, cy - y, color); break;
+                case -3: FillSpan(x1,     cx - x, cy + y, color); break;
+                case -4: FillSpan(cx + x, x2,     cy + y, color); break;
             }
         }
         else
         {
             switch (quadrants)
             {
-                case  5: DrawPixel(cx + x, cy + y, color); // no break
+                case  5: PutPixel(cx + x, cy + y, color); // no break
                 case -1:
-                case  1: DrawPixel(cx + x, cy - y, color); break;
-                case  7: DrawPixel(cx - x, cy + y, color); // no break
+                case  1: PutPixel(cx + x, cy - y, color); break;
+                case  7: PutPixel(cx - x, cy + y, color); // no break
                 case -2:
-                case  2: DrawPixel(cx - x, cy - y, color); break;
+                case  2: PutPixel(cx - x, cy - y, color); break;
                 case -3:
-                case  3: DrawPixel(cx - x, cy + y, color); break;
+                case  3: PutPixel(cx - x, cy + y, color); break;
                 case -4:
-                case  4: DrawPixel(cx + x, cy + y, color); break;
+                case  4: PutPixel(cx + x, cy + y, color); break;
                 case  0:
-                case  6: DrawPixel(cx - x, cy - y, color); DrawPixel(cx + x, cy - y, color); if (quadrants == 6) break;
-                case  8: DrawPixel(cx - x, cy + y, color); DrawPixel(cx + x, cy + y, color); break;
+                case  6: PutPixel(cx - x, cy - y, color); PutPixel(cx + x, cy - y, color); if (quadrants == 6) break;
+                case  8: PutPixel(cx - x, cy + y, color); PutPixel(cx + x, cy + y, color); break;
             }
         }
         y++;
@@ -472,38 +776,38 @@ void cBitmap::DrawEllipse(int x1, int y1, int x2, int y2, uint32_t color, bool f
         {
             switch (quadrants)
             {
-                case  5: DrawRectangle(cx,     cy + y, cx + x, cy + y, color, filled); // no break
-                case  1: DrawRectangle(cx,     cy - y, cx + x, cy - y, color, filled); break;
-                case  7: DrawRectangle(cx - x, cy + y, cx,     cy + y, color, filled); // no break
-                case  2: DrawRectangle(cx - x, cy - y, cx,     cy - y, color, filled); break;
-                case  3: DrawRectangle(cx - x, cy + y, cx,     cy + y, color, filled); break;
-                case  4: DrawRectangle(cx,     cy + y, cx + x, cy + y, color, filled); break;
+                case  5: FillSpan(cx,     cx + x, cy + y, color); // no break
+                case  1: FillSpan(cx,     cx + x, cy - y, color); break;
+                case  7: FillSpan(cx - x, cx,     cy + y, color); // no break
+                case  2: FillSpan(cx - x, cx,     cy - y, color); break;
+                case  3: FillSpan(cx - x, cx,     cy + y, color); break;
+                case  4: FillSpan(cx,     cx + x, cy + y, color); break;
                 case  0:
-                case  6: DrawRectangle(cx - x, cy - y, cx + x, cy - y, color, filled); if (quadrants == 6) break;
-                case  8: DrawRectangle(cx - x, cy + y, cx + x, cy + y, color, filled); break;
-                case -1: DrawRectangle(cx + x, cy - y, x2,     cy - y, color, filled); break;
-                case -2: DrawRectangle(x1,     cy - y, cx - x, cy - y, color, filled); break;
-                case -3: DrawRectangle(x1,     cy + y, cx - x, cy + y, color, filled); break;
-                case -4: DrawRectangle(cx + x, cy + y, x2,     cy + y, color, filled); break;
+                case  6: FillSpan(cx - x, cx + x, cy - y, color); if (quadrants == 6) break;
+                case  8: FillSpan(cx - x, cx + x, cy + y, color); break;
+                case -1: FillSpan(cx + x, x2,     cy - y, color); break;
+                case -2: FillSpan(x1,     cx - x, cy - y, color); break;
+                case -3: FillSpan(x1,     cx - x, cy + y, color); break;
+                case -4: FillSpan(cx + x, x2,     cy + y, color); break;
             }
         }
         else
         {
             switch (quadrants)
             {
-                case  5: DrawPixel(cx + x, cy + y, color); // no break
+                case  5: PutPixel(cx + x, cy + y, color); // no break
                 case -1:
-                case  1: DrawPixel(cx + x, cy - y, color); break;
-                case  7: DrawPixel(cx - x, cy + y, color); // no break
+                case  1: PutPixel(cx + x, cy - y, color); break;
+                case  7: PutPixel(cx - x, cy + y, color); // no break
                 case -2:
-                case  2: DrawPixel(cx - x, cy - y, color); break;
+                case  2: PutPixel(cx - x, cy - y, color); break;
                 case -3:
-                case  3: DrawPixel(cx - x, cy + y, color); break;
+                case  3: PutPixel(cx - x, cy + y, color); break;
                 case -4:
-                case  4: DrawPixel(cx + x, cy + y, color); break;
+                case  4: PutPixel(cx + x, cy + y, color); break;
                 case  0:
-                case  6: DrawPixel(cx - x, cy - y, color); DrawPixel(cx + x, cy - y, color); if (quadrants == 6) break;
-                case  8: DrawPixel(cx - x, cy + y, color); DrawPixel(cx + x, cy + y, color); break;
+                case  6: PutPixel(cx - x, cy - y, color); PutPixel(cx + x, cy - y, color); if (quadrants == 6) break;
+                case  8: PutPixel(cx - x, cy + y, color); PutPixel(cx + x, cy + y, color); break;
             }
         }
         x++;
@@ -526,6 +830,7 @@ void cBitmap::DrawSlope(int x1, int y1, int x2, int y2, uint32_t color, int type
     printf("%s:%s(%d) %03d * %03d -> %03d * %03d\n", __FILE__, __FUNCTION__, __LINE__, x1, y1, x2, y2);
 #endif
     color = cColor::AlignAlpha(color);
+    AddDamage(x1, y1, x2, y2);
 
     bool upper    = type & 0x01;
     bool falling  = type & 0x02;
@@ -539,9 +844,9 @@ void cBitmap::DrawSlope(int x1, int y1, int x2, int y2, uint32_t color, int type
                 c = -c;
             int x = int((x2 - x1 + 1) * c / 2);
             if ((upper && !falling) || (!upper && falling))
-                DrawRectangle(x1, y, (x1 + x2) / 2 + x, y, color, true);
+                FillSpan(x1, (x1 + x2) / 2 + x, y, color);
             else
-                DrawRectangle((x1 + x2) / 2 + x, y, x2, y, color, true);
+                FillSpan((x1 + x2) / 2 + x, x2, y, color);
         }
     }
     else
@@ -553,9 +858,9 @@ void cBitmap::DrawSlope(int x1, int y1, int x2, int y2, uint32_t color, int type
                 c = -c;
             int y = int((y2 - y1 + 1) * c / 2);
             if (upper)
-                DrawRectangle(x, y1, x, (y1 + y2) / 2 + y, color, true);
+                FillRect(x, y1, x, (y1 + y2) / 2 + y, color);
             else
-                DrawRectangle(x, (y1 + y2) / 2 + y, x, y2, color, true);
+                FillRect(x, (y1 + y2) / 2 + y, x, y2, color);
         }
     }
 }
@@ -568,34 +873,90 @@ void cBitmap::DrawBitmap(int x, int y, const cBitmap & bitmap, uint32_t color, u
     color = cColor::AlignAlpha(color);
     bgcolor = cColor::AlignAlpha(bgcolor);
 
-    uint32_t cl = 0;
     const uint32_t * data = bitmap.Data();
     bool ismono = bitmap.IsMonochrome();
 
-    int xt, yt;
-    uint32_t alpha;
+    if ((!data && !bitmap.Pixels()) || (!this->bitmap && !pixels))
+        return;
+
+    AddDamage(x, y, x + bitmap.Width() - 1, y + bitmap.Height() - 1);
 
-    if (data)
+    // clip against the clip area
+    int srcx = 0;
+    int srcy = 0;
+    int w = bitmap.Width();
+    int h = bitmap.Height();
+    if (x < clipArea.x1)
     {
-      for (yt = 0; yt < bitmap.Height(); yt++)
+        srcx = clipArea.x1 - x;
+        w -= srcx;
+        x = clipArea.x1;
+    }
+    if (y < clipArea.y1)
+    {
+        srcy = clipArea.y1 - y;
+        h -= srcy;
+        y = clipArea.y1;
+    }
+    w = std::min(w, clipArea.x2 + 1 - x);
+    h = std::min(h, clipArea.y2 + 1 - y);
+    clip(opacity, 0, 255);
+    if (w <= 0 || h <= 0 || opacity == 0)
+        return;
+
+    // the colours of a monochrome bitmap are mapped a row at a time,
+    // the pixels of the other formats than pfARGB32 are converted into it
+    std::vector<uint32_t> row((ismono || !data) ? w : 0);
+
+    for (int yt = 0; yt < h; yt++)
+    {
+        const uint32_t * src;
+        if (data)
+            src = data + (srcy + yt) * bitmap.Width() + srcx;
+        else
+        {
+            bitmap.GetLine(srcx, srcy + yt, w, &row[0]);
+            src = &row[0];
+        }
+
+        if (ismono)
         {
-          for (xt = 0; xt < bitmap.Width(); xt++)
-          {
-            cl = data[(yt * bitmap.Width())+xt];
-            if (cl != cColor::Transparent) {
-              if (ismono) {
-                cl = (cl == cColor::Black) ? color : bgcolor;
-              }
-              if (opacity != 255) {
-                  alpha = (cl & 0xFF000000) >> 24;
-                  alpha = (alpha * opacity) / 255;
-                  cl = (cl & 0x00FFFFFF) | (alpha << 24);
-              }
-              if (cl & 0xFF000000) // only draw if alpha > 0
-                DrawPixel(xt+x, yt+y, cl);
-           }
-         }
-       }
+            for (int xt = 0; xt < w; xt++)
+            {
+                uint32_t cl = src[xt];
+                if (cl != cColor::Transparent)
+                    cl = (cl == cColor::Black) ? color : bgcolor;
+                row[xt] = cl;
+            }
+            src = &row[0];
+        }
+
+        if (pixels)
+        {
+            BlendLine(format, pixels + (y + yt) * lineSize, x, src, w, opacity, processAlpha);
+            continue;
+        }
+
+        uint32_t * dst = this->bitmap + (y + yt) * width + x;
+        if (processAlpha)
+        {
+            BlendBitmap(dst, src, w, opacity);
+            continue;
+        }
+
+        for (int xt = 0; xt < w; xt++)
+        {
+            uint32_t cl = src[xt];
+            uint32_t alpha = cl >> 24;
+
+            if (opacity != 255)
+            {
+                alpha = Div255(alpha * opacity);
+                cl = (cl & 0x00FFFFFF) | (alpha << 24);
+            }
+            if (alpha) // only draw if alpha > 0
+                dst[xt] = cl;
+        }
     }
 }
 
@@ -707,48 +1068,160 @@ int cBitmap::DrawCharacter(int x, int y, int xmax, uint32_t c, const cFont * fon
 #ifdef HAVE_DEBUG
     printf("%s:%s(%d) %03d * %03d char '%c' color '%08x' bgcolor '%08x'\n", __FILE__, __FUNCTION__, __LINE__, x, y, c, color, bgcolor);
 #endif
-    const cBitmap * charBitmap;
-    cBitmap * drawBitmap;
-
-    //color = cColor::AlignAlpha(color);
-    //bgcolor = cColor::AlignAlpha(bgcolor);
-
-    uint32_t dot = 0;
-    int xt, yt;
+    tGlyph glyph;
 
     clip(x, 0, width - 1);
     clip(y, 0, height - 1);
 
-    charBitmap = font->GetCharacter(c);
-    if (charBitmap)
+    if (font->GetGlyph(c, glyph))
     {
-        int drawWidth = charBitmap->Width() - skipPixels;
+        int drawWidth = glyph.width - skipPixels;
         if ( x + drawWidth-1 > xmax)
             drawWidth = xmax - x + 1;
 
-        drawBitmap = new cBitmap(drawWidth /*charBitmap->Width()-skipPixels*/,charBitmap->Height());
-        if (drawBitmap) {
-          drawBitmap->SetProcessAlpha(false);
-          drawBitmap->Clear(bgcolor);
-
-          for (xt = 0; xt < drawWidth; xt++) {
-            for (yt = 0; yt < charBitmap->Height() ; yt++) {
-              dot = charBitmap->GetPixel(xt+skipPixels,yt);
-              if ((dot | 0xFF000000) == cColor::Black) { // todo: does not work with antialising?
-                drawBitmap->DrawPixel(xt, yt, color);
-              } else {
-                drawBitmap->DrawPixel(xt, yt, bgcolor);
-              }
-            }
-          }
-          DrawBitmap(x, y, *drawBitmap);
-          delete drawBitmap;
-        }
+        // colours as the glyph is composed of: bgcolor keeps its alpha level (aligned like in
+        // DrawPixel()), a transparent foreground shows the background colour, made opaque
+        uint32_t fg;
+        uint32_t bg = cColor::AlignAlpha(bgcolor);
+        if (color == cColor::Transparent)
+            fg = (bgcolor == cColor::Transparent) ? cColor::Transparent : ((bgcolor & 0x00FFFFFF) | 0xFF000000);
+        else
+            fg = cColor::AlignAlpha(color);
+
+        DrawBitmap1BPP(x, y, glyph.data, glyph.pitch, skipPixels,
+                       std::min(drawWidth, glyph.width - skipPixels), glyph.height, fg, bg);
         return drawWidth; //charBitmap->Width() - skipPixels;
     }
     return 0;
 }
 
+// returns n (<= 32) pixels of a 1 bpp row starting at pixel pos, the first one in the most significant bit.
+// only the bytes covering these pixels are read, the result is limited to the bits in mask.
+static inline uint32_t LoadPixels(const unsigned char * row, int pos, int n, uint32_t mask)
+{
+    const unsigned char * p = row + (pos >> 3);
+    int shift = pos & 7;
+    int bytes = (shift + n + 7) >> 3;
+    uint64_t v = 0;
+    for (int i = 0; i < bytes; i++)
+        v |= (uint64_t) p[i] << (56 - 8 * i);
+    v <<= shift;
+    return (uint32_t) (v >> 32) & mask;
+}
+
+// how a colour gets written: not at all, stored directly or blended with the current pixel
+enum ePixelMode
+{
+    pmSkip,
+    pmStore,
+    pmBlend
+};
+
+static inline ePixelMode PixelMode(uint32_t color, bool processAlpha)
+{
+    if (color == cColor::Transparent || !(color & 0xFF000000))
+        return pmSkip;
+    if (!processAlpha || (color & 0xFF000000) == 0xFF000000)
+        return pmStore;
+    return pmBlend;
+}
+
+void cBitmap::DrawBitmap1BPP(int x, int y, const unsigned char * data, int pitch, int srcx, int w, int h,
+                             uint32_t fg, uint32_t bg)
+{
+    if ((!bitmap && !pixels) || !data)
+        return;
+
+    // clip against the source and the clip area
+    if (srcx < 0)
+    {
+        x -= srcx;
+        w += srcx;
+        srcx = 0;
+    }
+    if (x < clipArea.x1)
+    {
+        srcx += clipArea.x1 - x;
+        w -= clipArea.x1 - x;
+        x = clipArea.x1;
+    }
+    int srcy = 0;
+    if (y < clipArea.y1)
+    {
+        srcy = clipArea.y1 - y;
+        h -= srcy;
+        y = clipArea.y1;
+    }
+    w = std::min(w, std::min(pitch * 8 - srcx, clipArea.x2 + 1 - x));
+    h = std::min(h, clipArea.y2 + 1 - y);
+    if (w <= 0 || h <= 0)
+        return;
+
+    AddDamage(x, y, x + w - 1, y + h - 1);
+
+    ePixelMode fgMode = PixelMode(fg, processAlpha);
+    ePixelMode bgMode = PixelMode(bg, processAlpha);
+    if (fgMode == pmSkip && bgMode == pmSkip)
+        return;
+
+    if (pixels)
+    {
+        // expanded into a row of colours, BlendLine() skips the ones with alpha 0 like pmSkip
+        std::vector<uint32_t> row(w);
+        for (int yt = 0; yt < h; yt++)
+        {
+            const unsigned char * src = data + (srcy + yt) * pitch;
+            for (int xt = 0; xt < w; xt++)
+                row[xt] = (src[(srcx + xt) >> 3] & (0x80 >> ((srcx + xt) & 7))) ? fg : bg;
+            BlendLine(format, pixels + (y + yt) * lineSize, x, &row[0], w, 255, processAlpha);
+        }
+        return;
+    }
+
+    for (int yt = 0; yt < h; yt++)
+    {
+        const unsigned char * src = data + (srcy + yt) * pitch;
+        uint32_t * dst = bitmap + (y + yt) * width + x;
+
+        // handle 32 pixels at once, runs of set or cleared pixels are filled in one go
+        for (int xt = 0; xt < w; xt += 32)
+        {
+            int n = std::min(32, w - xt);
+            uint32_t mask = (n == 32) ? 0xFFFFFFFF : ~(0xFFFFFFFF >> n);
+            uint32_t bits = LoadPixels(src, srcx + xt, n, mask);
+
+            if (bits == 0 && bgMode != pmBlend)
+            {
+                if (bgMode == pmStore)
+                    std::fill_n(dst + xt, n, bg);
+                continue;
+            }
+            if (bits == mask && fgMode != pmBlend)
+            {
+                if (fgMode == pmStore)
+                    std::fill_n(dst + xt, n, fg);
+                continue;
+            }
+            if (fgMode == pmStore && bgMode == pmStore)
+            {
+                uint32_t diff = fg ^ bg;
+                for (int i = 0; i < n; i++, bits <<= 1)
+                    dst[xt + i] = bg ^ (diff & (0 - (bits >> 31)));
+                continue;
+            }
+            for (int i = 0; i < n; i++)
+            {
+                bool set = bits & (0x80000000 >> i);
+                ePixelMode mode = set ? fgMode : bgMode;
+                if (mode == pmStore)
+                    dst[xt + i] = set ? fg : bg;
+                else if (mode == pmBlend)
+                    PutPixel(x + xt + i, y + yt, set ? fg : bg);
+            }
+        }
+    }
+}
+
 uint32_t cBitmap::GetPixel(int x, int y) const
 {
     if (x < 0 || x > width - 1)
@@ -756,11 +1229,32 @@ uint32_t cBitmap::GetPixel(int x, int y) const
     if (y < 0 || y > height - 1)
         return cColor::Transparent;
 
+    if (bitmap)
+        return bitmap[y * width + x];
+
     uint32_t value;
-    value = bitmap[y * width + x];
+    GetLine(x, y, 1, &value);
     return value;
 }
 
+void cBitmap::GetLine(int x, int y, int count, uint32_t * dst) const
+{
+    if (bitmap)
+    {
+        memcpy(dst, bitmap + y * width + x, count * sizeof(uint32_t));
+        return;
+    }
+
+    const unsigned char * line = pixels + y * lineSize;
+    switch (format)
+    {
+        case pfMono:   DecodeLine<tFormatMono>(line, x, count, dst); break;
+        case pfGrey4:  DecodeLine<tFormatGrey4>(line, x, count, dst); break;
+        case pfRGB565: DecodeLine<tFormatRGB565>(line, x, count, dst); break;
+        default: break;
+    }
+}
+
 cBitmap * cBitmap::SubBitmap(int x1, int y1, int x2, int y2) const
 {
 #ifdef HAVE_DEBUG
@@ -782,8 +1276,11 @@ cBitmap * cBitmap::SubBitmap(int x1, int y1, int x2, int y2) const
 
     w = x2 - x1 + 1;
     h = y2 - y1 + 1;
-    bmp = new cBitmap(w, h);
-    if (!bmp || !bmp->Data())
+    if (format == pfARGB32)
+        bmp = new cBitmap(w, h);
+    else
+        bmp = new cBitmap(w, h, format);
+    if (!bmp || (!bmp->Data() && !bmp->Pixels()))
         return NULL;
     bmp->Clear();
     bmp->SetMonochrome(this->IsMonochrome());
@@ -793,7 +1290,7 @@ cBitmap * cBitmap::SubBitmap(int x1, int y1, int x2, int y2) const
       for (xt = 0; xt < w; xt++)
       {
         cl = this->GetPixel(xt+x1, yt+y1);
-        bmp->DrawPixel(xt,yt, cl);
+        bmp->PutPixel(xt,yt, cl);
       }
     }
     return bmp;
@@ -848,7 +1345,7 @@ const cBitmap* cBitmap::ConvertFrom1BPP(const unsigned char* monobmp, int w, int
     int cols = (w + 7 ) / 8;
     for (int y = 0; y < h; y++) {
         for (int x = 0; x < w; x++) {
-            bmp->DrawPixel(x, y,  ( monobmp[ y * cols + (x >> 3) ] & ( 1 << (7 - (x % 8)) ) ) ? fg : bg );
+            bmp->PutPixel(x, y,  ( monobmp[ y * cols + (x >> 3) ] & ( 1 << (7 - (x % 8)) ) ) ? fg : bg );
         }
     }
     return bmp;
@@ -18,6 +18,7 @@
 #define _GLCDGRAPHICS_BITMAP_H_
 
 #include <string>
+#include <vector>
 #include <inttypes.h>
 
 // graphlcd-base uses ARGB bitmaps instead of 1bit ones
@@ -83,6 +84,57 @@ public:
 };
 
 
+// rectangular area, all coordinates are inclusive
+struct tRect
+{
+    int x1, y1, x2, y2;
+    tRect(int _x1 = 0, int _y1 = 0, int _x2 = -1, int _y2 = -1) { x1 = _x1; y1 = _y1; x2 = _x2; y2 = _y2; }
+
+    int Width() const { return x2 - x1 + 1; }
+    int Height() const { return y2 - y1 + 1; }
+    bool IsEmpty() const { return x2 < x1 || y2 < y1; }
+    bool Contains(const tRect & r) const { return r.x1 >= x1 && r.x2 <= x2 && r.y1 >= y1 && r.y2 <= y2; }
+    // true if both areas overlap or are directly adjacent
+    bool Touches(const tRect & r) const { return r.x1 <= x2 + 1 && r.x2 + 1 >= x1 && r.y1 <= y2 + 1 && r.y2 + 1 >= y1; }
+    void Unite(const tRect & r);
+    void Intersect(const tRect & r);
+};
+
+inline void tRect::Unite(const tRect & r)
+{
+    if (r.IsEmpty())
+        return;
+    if (IsEmpty())
+    {
+        *this = r;
+        return;
+    }
+    if (r.x1 < x1) x1 = r.x1;
+    if (r.y1 < y1) y1 = r.y1;
+    if (r.x2 > x2) x2 = r.x2;
+    if (r.y2 > y2) y2 = r.y2;
+}
+
+inline void tRect::Intersect(const tRect & r)
+{
+    if (r.x1 > x1) x1 = r.x1;
+    if (r.y1 > y1) y1 = r.y1;
+    if (r.x2 < x2) x2 = r.x2;
+    if (r.y2 < y2) y2 = r.y2;
+}
+
+
+// pixel formats of a cBitmap. the formats other than pfARGB32 have no alpha channel: transparent
+// pixels become black, colours drawn with an alpha level are blended if processAlpha is set.
+enum ePixelFormat
+{
+    pfARGB32,   // 32 bit ARGB (default)
+    pfMono,     // 1 bpp, first pixel in the msb, bit set: white
+    pfGrey4,    // 4 bit grey, 2 pixels per byte, first pixel in the high nibble
+    pfRGB565    // 16 bit 5-6-5 in host byte order
+};
+
+
 class cFont;
 
 class cBitmap
@@ -91,24 +143,49 @@ protected:
     int width;
     int height;
     int lineSize;
-    uint32_t * bitmap;
+    ePixelFormat format;
+    uint32_t * bitmap;          // pfARGB32
+    unsigned char * pixels;     // other formats, lineSize bytes per line
     bool ismonochrome;
     bool processAlpha;
 
     uint32_t backgroundColor;
 
+    std::vector<tRect> damage;
+
+    tRect clipArea;
+    std::vector<tRect> clipStack;
+
+    // adds an area to the damage list without clipping
+    void MergeDamage(tRect rect);
+    // DrawPixel() without damage tracking, for primitives that record their area beforehand
+    void PutPixel(int x, int y, uint32_t color);
+    // fill a horizontal run resp. an area with an aligned colour (see cColor::AlignAlpha()).
+    // clipped once against the clip area, no damage tracking.
+    void FillSpan(int x1, int x2, int y, uint32_t color);
+    void FillRect(int x1, int y1, int x2, int y2, uint32_t color);
+    // ARGB values of count pixels of line y starting at x, no clipping
+    void GetLine(int x, int y, int count, uint32_t * dst) const;
+
 public:
     cBitmap(int width, int height, uint32_t * data = NULL);
     cBitmap(int width, int height, uint32_t initcol);
+    cBitmap(int width, int height, ePixelFormat format, uint32_t initcol = cColor::Black);
     cBitmap(const cBitmap & b);
     ~cBitmap();
 
     int Width() const { return width; }
     int Height() const { return height; }
+    // bytes per line of Data() resp. Pixels()
     int LineSize() const { return lineSize; }
+    ePixelFormat Format() const { return format; }
+    // pixels of a pfARGB32 bitmap, NULL for the other formats
     const uint32_t * Data() const { return bitmap; }
+    // pixels of the formats other than pfARGB32, NULL for pfARGB32
+    const unsigned char * Pixels() const { return pixels; }
 
     void Clear(uint32_t color = cColor::Transparent);
+    void ClearArea(int x1, int y1, int x2, int y2, uint32_t color = cColor::Transparent);
     void Invert();
     void DrawPixel(int x, int y, uint32_t color);
     void DrawLine(int x1, int y1, int x2, int y2, uint32_t color);
@@ -123,6 +200,10 @@ public:
                  uint32_t color = cColor::White, uint32_t bgcolor = cColor::Black, bool proportional = true, int skipPixels = 0);
     int DrawCharacter(int x, int y, int xmax, uint32_t c, const cFont * font,
                       uint32_t color = cColor::White, uint32_t bgcolor = cColor::Black, int skipPixels = 0);
+    // draws w * h pixels of a packed 1 bpp bitmap (msb first, rows of pitch bytes) starting at source column srcx.
+    // set pixels are drawn with fg, cleared ones with bg; transparent colours leave the target unchanged.
+    void DrawBitmap1BPP(int x, int y, const unsigned char * data, int pitch, int srcx, int w, int h,
+                        uint32_t fg, uint32_t bg);
 
     cBitmap * SubBitmap(int x1, int y1, int x2, int y2) const;
     uint32_t GetPixel(int x, int y) const;
@@ -132,6 +213,21 @@ public:
 
     void SetProcessAlpha(bool procAlpha) { processAlpha = procAlpha; }
     bool IsProcessAlpha(void) const { return processAlpha; }
+
+    // drawing operations only change pixels inside the clip area (default: the whole bitmap).
+    // PushClip() narrows it to its intersection with the given area, PopClip() restores the previous one.
+    // Clear() and Invert() always work on the whole bitmap, ClearArea() is Clear() for the given area.
+    void PushClip(int x1, int y1, int x2, int y2);
+    void PopClip(void);
+    const tRect & ClipArea(void) const { return clipArea; }
+
+    // damage tracking: every drawing operation records the area it changed (inside the clip area).
+    // the list holds at most a few non-adjacent rectangles, more are merged into their bounding box.
+    void AddDamage(int x1, int y1, int x2, int y2);
+    const std::vector<tRect> & Damage(void) const { return damage; }
+    void SetDamage(const std::vector<tRect> & Damage) { damage = Damage; }
+    bool IsDamaged(void) const { return !damage.empty(); }
+    void ResetDamage(void) { damage.clear(); }
     
     static const unsigned char* ConvertTo1BPP(const cBitmap & bitmap, int threshold = 127);
     static const cBitmap* ConvertFrom1BPP(const unsigned char* monobmp, int w, int h, uint32_t fg = cColor::White, uint32_t bg = cColor::Black);
@@ -0,0 +1,215 @@
+/*
+ * GraphLCD graphics library
+ *
+ * blend.c  -  alpha blending of pixel spans
+ *
+ * This file is released under the GNU General Public License. Refer
+ * to the COPYING file distributed with this package.
+ */
+
+#include <algorithm>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define BLEND_SSE2
+#elif defined(__aarch64__) && defined(__ARM_NEON) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#include <arm_neon.h>
+#define BLEND_NEON
+#endif
+
+#include "blend.h"
+
+
+namespace GLCD
+{
+
+static const uint32_t kAlphaMask = 0xFF000000;
+
+#ifdef BLEND_SSE2
+
+// the channels of 2 pixels are handled in 16 bit lanes, products of two channels fit into them
+
+static inline __m128i Div255_SSE2(__m128i x)
+{
+    return _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(x, _mm_set1_epi16(1)), _mm_srli_epi16(x, 8)), 8);
+}
+
+// alpha of each pixel copied to all its channels
+static inline __m128i Alpha_SSE2(__m128i v)
+{
+    return _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+}
+
+static inline __m128i Blend_SSE2(__m128i fg, __m128i bg, __m128i alpha)
+{
+    __m128i inv = _mm_sub_epi16(_mm_set1_epi16(255), alpha);
+    return Div255_SSE2(_mm_add_epi16(_mm_mullo_epi16(fg, alpha), _mm_mullo_epi16(bg, inv)));
+}
+
+#endif
+
+#ifdef BLEND_NEON
+
+// pixels are loaded split into their channels: val[0] - val[3] hold b, g, r and alpha
+static inline uint8x8_t Blend_NEON(uint8x8_t fg, uint8x8_t bg, uint8x8_t alpha)
+{
+    uint16x8_t x = vmull_u8(fg, alpha);
+    x = vmlal_u8(x, bg, vmvn_u8(alpha));
+    return vshrn_n_u16(vaddq_u16(vaddq_u16(x, vdupq_n_u16(1)), vshrq_n_u16(x, 8)), 8);
+}
+
+static inline uint8x16_t Blend_NEON(uint8x16_t fg, uint8x16_t bg, uint8x16_t alpha)
+{
+    return vcombine_u8(Blend_NEON(vget_low_u8(fg), vget_low_u8(bg), vget_low_u8(alpha)),
+                       Blend_NEON(vget_high_u8(fg), vget_high_u8(bg), vget_high_u8(alpha)));
+}
+
+#endif
+
+void BlendSpan(uint32_t * dst, uint32_t color, int count)
+{
+    uint32_t alpha = color >> 24;
+    int i = 0;
+
+    if (count <= 0)
+        return;
+    if (alpha == 255)
+    {
+        std::fill_n(dst, count, color);
+        return;
+    }
+
+#ifdef BLEND_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    __m128i fg = _mm_unpacklo_epi8(_mm_set1_epi32(color), zero);
+    __m128i a = Alpha_SSE2(fg);
+    __m128i inv = _mm_sub_epi16(_mm_set1_epi16(255), a);
+    // the part of the colour is the same for all pixels
+    __m128i part = _mm_mullo_epi16(fg, a);
+
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128i d = _mm_loadu_si128((const __m128i *) (dst + i));
+        __m128i lo = Div255_SSE2(_mm_add_epi16(part, _mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), inv)));
+        __m128i hi = Div255_SSE2(_mm_add_epi16(part, _mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), inv)));
+        _mm_storeu_si128((__m128i *) (dst + i), _mm_or_si128(_mm_packus_epi16(lo, hi), _mm_set1_epi32(kAlphaMask)));
+    }
+#endif
+
+#ifdef BLEND_NEON
+    uint8x16_t a = vdupq_n_u8(alpha);
+    uint8x16_t opaque = vdupq_n_u8(0xFF);
+    uint8x16_t c[3] = { vdupq_n_u8(color & 0xFF), vdupq_n_u8((color >> 8) & 0xFF), vdupq_n_u8((color >> 16) & 0xFF) };
+
+    for (; i + 16 <= count; i += 16)
+    {
+        uint8x16x4_t d = vld4q_u8((const uint8_t *) (dst + i));
+
+        for (int ch = 0; ch < 3; ch++)
+            d.val[ch] = Blend_NEON(c[ch], d.val[ch], a);
+        d.val[3] = opaque;
+        vst4q_u8((uint8_t *) (dst + i), d);
+    }
+#endif
+
+    for (; i < count; i++)
+        dst[i] = BlendPixel(dst[i], color, alpha);
+}
+
+void BlendBitmap(uint32_t * dst, const uint32_t * src, int count, int opacity)
+{
+    int i = 0;
+
+    if (count <= 0 || opacity <= 0)
+        return;
+    if (opacity > 255)
+        opacity = 255;
+
+#ifdef BLEND_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i alphaMask = _mm_set1_epi32(kAlphaMask);
+    __m128i op = _mm_set1_epi16(opacity);
+
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128i s = _mm_loadu_si128((const __m128i *) (src + i));
+        __m128i sa = _mm_and_si128(s, alphaMask);
+
+        // runs of transparent or opaque pixels
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(sa, zero)) == 0xFFFF)
+            continue;
+        if (opacity == 255 && _mm_movemask_epi8(_mm_cmpeq_epi32(sa, alphaMask)) == 0xFFFF)
+        {
+            _mm_storeu_si128((__m128i *) (dst + i), s);
+            continue;
+        }
+
+        __m128i d = _mm_loadu_si128((const __m128i *) (dst + i));
+        __m128i slo = _mm_unpacklo_epi8(s, zero);
+        __m128i shi = _mm_unpackhi_epi8(s, zero);
+        __m128i alo = Alpha_SSE2(slo);
+        __m128i ahi = Alpha_SSE2(shi);
+        if (opacity != 255)
+        {
+            alo = Div255_SSE2(_mm_mullo_epi16(alo, op));
+            ahi = Div255_SSE2(_mm_mullo_epi16(ahi, op));
+        }
+
+        __m128i r = _mm_packus_epi16(Blend_SSE2(slo, _mm_unpacklo_epi8(d, zero), alo),
+                                     Blend_SSE2(shi, _mm_unpackhi_epi8(d, zero), ahi));
+        r = _mm_or_si128(r, alphaMask);
+        // pixels with alpha 0 keep the target
+        __m128i keep = _mm_cmpeq_epi32(_mm_packus_epi16(alo, ahi), zero);
+        r = _mm_or_si128(_mm_and_si128(keep, d), _mm_andnot_si128(keep, r));
+        _mm_storeu_si128((__m128i *) (dst + i), r);
+    }
+#endif
+
+#ifdef BLEND_NEON
+    uint8x16_t opaque = vdupq_n_u8(0xFF);
+    uint8x8_t op = vdup_n_u8(opacity);
+
+    for (; i + 16 <= count; i += 16)
+    {
+        uint8x16x4_t s = vld4q_u8((const uint8_t *) (src + i));
+        uint8x16_t a = s.val[3];
+
+        if (opacity != 255)
+            a = vcombine_u8(Blend_NEON(vget_low_u8(a), vdup_n_u8(0), op),
+                            Blend_NEON(vget_high_u8(a), vdup_n_u8(0), op));
+
+        // runs of transparent or opaque pixels
+        if (vmaxvq_u8(a) == 0)
+            continue;
+        if (vminvq_u8(a) == 255)
+        {
+            std::copy(src + i, src + i + 16, dst + i);
+            continue;
+        }
+
+        uint8x16x4_t d = vld4q_u8((const uint8_t *) (dst + i));
+        // pixels with alpha 0 keep the target
+        uint8x16_t keep = vceqq_u8(a, vdupq_n_u8(0));
+
+        for (int ch = 0; ch < 3; ch++)
+            d.val[ch] = vbslq_u8(keep, d.val[ch], Blend_NEON(s.val[ch], d.val[ch], a));
+        d.val[3] = vbslq_u8(keep, d.val[3], opaque);
+        vst4q_u8((uint8_t *) (dst + i), d);
+    }
+#endif
+
+    for (; i < count; i++)
+    {
+        uint32_t s = src[i];
+        uint32_t alpha = s >> 24;
+
+        if (opacity != 255)
+            alpha = Div255(alpha * opacity);
+        if (alpha == 255)
+            dst[i] = s;
+        else if (alpha > 0)
+            dst[i] = BlendPixel(dst[i], s, alpha);
+    }
+}
+
+} // end of namespace
@@ -0,0 +1,44 @@
+/*
+ * GraphLCD graphics library
+ *
+ * blend.h  -  alpha blending of pixel spans
+ *
+ * This file is released under the GNU General Public License. Refer
+ * to the COPYING file distributed with this package.
+ */
+
+#ifndef _GLCDGRAPHICS_BLEND_H_
+#define _GLCDGRAPHICS_BLEND_H_
+
+#include <stdint.h>
+
+
+namespace GLCD
+{
+
+// x / 255 rounded down, exact for 0 <= x <= 255 * 255
+inline uint32_t Div255(uint32_t x)
+{
+    return (x + 1 + (x >> 8)) >> 8;
+}
+
+// colour fg with the given alpha drawn over bg. the result is always opaque.
+inline uint32_t BlendPixel(uint32_t bg, uint32_t fg, uint32_t alpha)
+{
+    uint32_t inv = 255 - alpha;
+    uint32_t r = Div255(((fg >> 16) & 0xFF) * alpha + ((bg >> 16) & 0xFF) * inv);
+    uint32_t g = Div255(((fg >> 8) & 0xFF) * alpha + ((bg >> 8) & 0xFF) * inv);
+    uint32_t b = Div255((fg & 0xFF) * alpha + (bg & 0xFF) * inv);
+
+    return 0xFF000000 | (r << 16) | (g << 8) | b;
+}
+
+// draws color with its alpha over count pixels of dst, like BlendPixel()
+void BlendSpan(uint32_t * dst, uint32_t color, int count);
+// draws count pixels of src over dst, the alpha of each source pixel scaled by opacity (0 - 255).
+// source pixels that end up with alpha 0 leave dst unchanged, opaque ones are copied.
+void BlendBitmap(uint32_t * dst, const uint32_t * src, int count, int opacity = 255);
+
+} // end of namespace
+
+#endif
@@ -15,11 +15,14 @@
 #include <stdint.h>
 #include <syslog.h>
 
+#include <algorithm>
 #include <cstring>
+#include <vector>
 
 #include "bitmap.h"
 #include "extformats.h"
 #include "image.h"
+#include "mapfile.h"
 
 #ifdef HAVE_IMAGEMAGICK_7
   #include <MagickWand/MagickWand.h>
@@ -33,8 +36,167 @@ namespace GLCD
 
 using namespace std;
 
+#ifdef HAVE_IMAGEMAGICK
+
+static void SelectFrame(MagickWand * mw, unsigned long index)
+{
+#ifdef HAVE_IMAGEMAGICK_7
+  MagickSetIteratorIndex(mw, index);
+#else
+  MagickSetImageIndex(mw, index);
+#endif
+}
+
+// converts the current frame of mw, NULL on failure
+static cBitmap * ExportFrame(MagickWand * mw, uint16_t width, uint16_t height, const string & fileName)
+{
+  uint32_t * bmpdata = new uint32_t[height * width];
+
+#ifdef HAVE_IMAGEMAGICK_7
+  unsigned int status = MagickExportImagePixels(mw, 0, 0, width, height, "BGRA", CharPixel, (unsigned char*)bmpdata);
+#else
+  unsigned int status = MagickGetImagePixels(mw, 0, 0, width, height, "BGRA", CharPixel, (unsigned char*)bmpdata);
+#endif
+
+  if (status == MagickFalse) {
+    syslog(LOG_ERR, "glcdgraphics: Couldn't load '%s' (cExtFormatFile::LoadScaled): MagickGetImagePixels", fileName.c_str());
+    delete[] bmpdata;
+    return NULL;
+  }
+
+#ifdef HAVE_IMAGEMAGICK_7
+  bool isMatte = (MagickGetImageAlphaChannel(mw) == MagickTrue);
+#else
+  bool isMatte = (MagickGetImageMatte(mw) == MagickTrue);
+#endif
+
+  // Give all transparent pixels our defined transparent color
+  if (isMatte) {
+    for (int iy = 0; iy < (int)height; ++iy) {
+      for (int ix = 0; ix < (int)width; ++ix) {
+        uint32_t* pixel = &bmpdata[ix+iy*width];
+        uint8_t alpha = *pixel >> 24;
+        if (alpha == 0)
+          *pixel = cColor::Transparent;
+      }
+    }
+  }
+
+  cBitmap * b = new cBitmap(width, height, bmpdata);
+  //b->SetMonochrome(isMonochrome);
+  delete[] bmpdata;
+  return b;
+}
+
+// keeps a copy of the compressed file and decodes a window of frames when one of them is
+// needed. the window is exported at once and handed out frame by frame, so that no
+// MagickWand with the much larger decoded scenes is kept.
+class cExtFormatSource : public cImageSource
+{
+private:
+  string fileName;
+  vector<unsigned char> blob;     // contents of the file
+  vector<unsigned long> scenes;   // scene in the file of each frame
+  unsigned int windowSize;
+  uint16_t width;
+  uint16_t height;
+  bool scale;
+  vector<cBitmap *> window;       // frames windowFirst ... not handed out yet
+  unsigned int windowFirst;
+
+  void DropWindow();
+  bool ReadWindow(unsigned int nr);
+public:
+  cExtFormatSource(const string & FileName, unsigned int WindowSize)
+  : fileName(FileName), windowSize(WindowSize), width(0), height(0), scale(false), windowFirst(0) {}
+  virtual ~cExtFormatSource() { DropWindow(); }
+  bool Open();
+  void AddScene(unsigned long scene) { scenes.push_back(scene); }
+  unsigned int Count() const { return scenes.size(); }
+  void SetSize(uint16_t Width, uint16_t Height, bool Scale) { width = Width; height = Height; scale = Scale; }
+  virtual cBitmap * Decode(unsigned int nr);
+  virtual size_t Memory() const;
+};
+
+bool cExtFormatSource::Open()
+{
+  // copied, the file may be rewritten while the image is in use
+  cMappedFile file;
+  if (!file.Open(fileName))
+    return false;
+  blob.assign(file.Data(), file.Data() + file.Size());
+  return true;
+}
+
+void cExtFormatSource::DropWindow()
+{
+  for (size_t i = 0; i < window.size(); i++)
+    delete window[i];
+  window.clear();
+}
+
+bool cExtFormatSource::ReadWindow(unsigned int nr)
+{
+  unsigned int end = min(nr + windowSize, (unsigned int) scenes.size());
+  char range[32];
+  snprintf(range, sizeof(range), "[%lu-%lu]", scenes[nr], scenes[end - 1]);
+
+  DropWindow();
+  MagickWand * mw = NewMagickWand();
+
+  // the scene range appended to the file name selects the frames read from the blob
+  MagickSetFilename(mw, (fileName + range).c_str());
+  if (MagickReadImageBlob(mw, blob.data(), blob.size()) == MagickFalse) {
+    syslog(LOG_ERR, "glcdgraphics: Couldn't load '%s' (cExtFormatSource::ReadWindow)", fileName.c_str());
+    DestroyMagickWand(mw);
+    return false;
+  }
+
+  // coders that ignore the range return the frames from the first one on
+  unsigned long count = MagickGetNumberImages(mw);
+  unsigned long first = (count > scenes[end - 1]) ? 0 : scenes[end - 1] + 1 - count;
+
+  windowFirst = nr;
+  for (unsigned int i = nr; i < end; i++) {
+    cBitmap * b = NULL;
+    if (scenes[i] >= first && scenes[i] < first + count) {
+      SelectFrame(mw, scenes[i] - first);
+      if (scale && (MagickGetImageWidth(mw) != width || MagickGetImageHeight(mw) != height))
+        MagickSampleImage(mw, width, height);
+      b = ExportFrame(mw, width, height, fileName);
+    }
+    window.push_back(b);
+  }
+  DestroyMagickWand(mw);
+  return true;
+}
+
+cBitmap * cExtFormatSource::Decode(unsigned int nr)
+{
+  if (nr >= scenes.size())
+    return NULL;
+
+  if (nr < windowFirst || nr >= windowFirst + window.size() || !window[nr - windowFirst]) {
+    if (!ReadWindow(nr))
+      return NULL;
+  }
+
+  // handed over to the image
+  cBitmap * b = window[nr - windowFirst];
+  window[nr - windowFirst] = NULL;
+  return b;
+}
+
+size_t cExtFormatSource::Memory() const
+{
+  return blob.capacity() + (size_t) windowSize * (sizeof(cBitmap) + (size_t) width * height * sizeof(uint32_t));
+}
+
+#endif
+
 
 cExtFormatFile::cExtFormatFile()
+: ringSize(0)
 {
 #ifdef HAVE_IMAGEMAGICK_7
   MagickWandGenesis();
@@ -62,8 +224,30 @@ bool cExtFormatFile::LoadScaled(cImage & image, const string & fileName, uint16_
   uint16_t width = 0;
   uint16_t height = 0;
   uint32_t delay;
+  cExtFormatSource * source = NULL;
+
+  // long animations are only pinged here, their frames are decoded on demand
+  if (ringSize > 0) {
+    if (MagickPingImage(mw, fileName.c_str()) == MagickFalse) {
+      syslog(LOG_ERR, "glcdgraphics: Couldn't load '%s' (cExtFormatFile::LoadScaled)", fileName.c_str());
+      DestroyMagickWand(mw);
+      return false;
+    }
+    if (MagickGetNumberImages(mw) > ringSize) {
+      source = new cExtFormatSource(fileName, ringSize);
+      if (!source->Open()) {
+        syslog(LOG_ERR, "glcdgraphics: Couldn't load '%s' (cExtFormatFile::LoadScaled)", fileName.c_str());
+        delete source;
+        DestroyMagickWand(mw);
+        return false;
+      }
+    } else {
+      DestroyMagickWand(mw);
+      mw = NewMagickWand();
+    }
+  }
 
-  if (MagickReadImage(mw, fileName.c_str()) == MagickFalse) {
+  if (!source && MagickReadImage(mw, fileName.c_str()) == MagickFalse) {
     syslog(LOG_ERR, "glcdgraphics: Couldn't load '%s' (cExtFormatFile::LoadScaled)", fileName.c_str());
     DestroyMagickWand(mw);
     return false;
@@ -76,11 +260,7 @@ bool cExtFormatFile::LoadScaled(cImage & image, const string & fileName, uint16_
 
   for (unsigned long imageindex = 0; imageindex < MagickGetNumberImages(mw); imageindex++) {
 
-#ifdef HAVE_IMAGEMAGICK_7
-    MagickSetIteratorIndex(mw, imageindex);
-#else
-    MagickSetImageIndex(mw, imageindex);
-#endif
+    SelectFrame(mw, imageindex);
 
     bool ignoreImage = false;
 
@@ -97,7 +277,8 @@ bool cExtFormatFile::LoadScaled(cImage & image, const string & fileName, uint16_
 
       // scale image
       if (scalew && ! (scalew == width && scaleh == height)) {
-        MagickSampleImage(mw, scalew, scaleh);
+        if (!source)
+          MagickSampleImage(mw, scalew, scaleh);
         width = scalew;
         height = scaleh;
       } else {
@@ -110,54 +291,35 @@ bool cExtFormatFile::LoadScaled(cImage & image, const string & fileName, uint16_
       image.SetHeight(height);
     } else {
       if (scalew && scaleh) {
-        MagickSampleImage(mw, scalew, scaleh);
+        if (!source)
+          MagickSampleImage(mw, scalew, scaleh);
       } else 
       if ( (width != (uint16_t)MagickGetImageWidth(mw)) || (height != (uint16_t)MagickGetImageHeight(mw)) ) {
         ignoreImage = true;
       }
     }
 
-    if (! ignoreImage) {
-      uint32_t * bmpdata = new uint32_t[height * width];
-
-#ifdef HAVE_IMAGEMAGICK_7
-      unsigned int status = MagickExportImagePixels(mw, 0, 0, width, height, "BGRA", CharPixel, (unsigned char*)bmpdata);
-#else
-      unsigned int status = MagickGetImagePixels(mw, 0, 0, width, height, "BGRA", CharPixel, (unsigned char*)bmpdata);
-#endif
-
-      if (status == MagickFalse) {
-        syslog(LOG_ERR, "glcdgraphics: Couldn't load '%s' (cExtFormatFile::LoadScaled): MagickGetImagePixels", fileName.c_str());
-        DestroyMagickWand(mw);
-        return false;
-      }
+    if (ignoreImage)
+      continue;
 
-#ifdef HAVE_IMAGEMAGICK_7
-      bool isMatte = (MagickGetImageAlphaChannel(mw) == MagickTrue);
-#else
-      bool isMatte = (MagickGetImageMatte(mw) == MagickTrue);
-#endif
-
-      // Give all transparent pixels our defined transparent color
-      if (isMatte) {
-        for (int iy = 0; iy < (int)height; ++iy) {
-          for (int ix = 0; ix < (int)width; ++ix) {
-            uint32_t* pixel = &bmpdata[ix+iy*width];
-            uint8_t alpha = *pixel >> 24;
-            if (alpha == 0)
-              *pixel = cColor::Transparent;
-          }
-        }
-      }
+    if (source) {
+      source->AddScene(imageindex);
+      continue;
+    }
 
-      cBitmap * b = new cBitmap(width, height, bmpdata);
-      //b->SetMonochrome(isMonochrome);
-      image.AddBitmap(b);
-      delete[] bmpdata;
-      bmpdata = NULL;
+    cBitmap * b = ExportFrame(mw, width, height, fileName);
+    if (!b) {
+      DestroyMagickWand(mw);
+      return false;
     }
+    image.AddBitmap(b);
   }
   DestroyMagickWand(mw);
+
+  if (source) {
+    source->SetSize(width, height, scalew != 0);
+    image.SetSource(source, source->Count(), ringSize);
+  }
   return true;
 #else
   return false;
@@ -23,6 +23,8 @@ class cImage;
 
 class cExtFormatFile : public cImageFile
 {
+private:
+    unsigned int ringSize;
 public:
     cExtFormatFile();
     virtual ~cExtFormatFile();
@@ -30,6 +32,13 @@ public:
     virtual bool Save(cImage & image, const std::string & fileName);
 
     virtual bool LoadScaled(cImage & image, const std::string & fileName, uint16_t & scalew, uint16_t & scaleh);
+
+    // animations with more frames than this are decoded on demand, keeping
+    // only this many frames decoded (see cImage::SetSource() for the limits
+    // this puts on the bitmaps of the image). 0 (default) decodes all frames
+    // when loading.
+    void SetRingSize(unsigned int size) { ringSize = size; }
+    unsigned int RingSize(void) const { return ringSize; }
 };
 
 } // end of namespace
@@ -21,9 +21,12 @@
 #include <unistd.h>
 
 #include <algorithm>
+#include <deque>
+#include <unordered_map>
 
 #include "common.h"
 #include "font.h"
+#include "mapfile.h"
 
 #ifdef HAVE_FREETYPE2
 #include <ft2build.h>
@@ -59,65 +62,187 @@ static const uint32_t kCharHeaderSize = 4;
 //};
 //#pragma pack()
 
-#ifdef HAVE_FREETYPE2
+// number of code points that are stored in a direct lookup table
+static const uint32_t kDirectCacheSize = 256;
 
-class cBitmapCache
+// glyph store of a font: all glyphs are kept packed with 1 bpp in one contiguous atlas.
+// code points 0 - 255 are found through a direct lookup table, all others through a hash map.
+class cGlyphCache
 {
 private:
-protected:
-    cBitmapCache *next;  // next  bitmap
-    cBitmap      *ptr;
-    uint32_t     charcode;
+    struct tEntry
+    {
+        uint32_t offset;    // first row in the atlas
+        uint16_t width;
+        uint16_t height;
+        bool valid;
+    };
+
+    std::vector<unsigned char> atlas;
+    size_t unused;                               // atlas bytes of dropped or replaced glyphs
+    tEntry direct[kDirectCacheSize];             // code points 0 - 255
+    std::unordered_map<uint32_t, tEntry> others;
+    std::deque<uint32_t> order;                  // insertion order of 'others', for eviction
+    unsigned int limit;
+    uint64_t hits;
+    uint64_t misses;
+
+    static size_t Bytes(const tEntry & entry) { return ((entry.width + 7) / 8) * entry.height; }
+    void MoveEntry(tEntry & entry, std::vector<unsigned char> & target) const;
+    void DropOldest();
+    void Compact();
 public:
-    cBitmapCache();
-    ~cBitmapCache();
+    cGlyphCache(unsigned int limit = 0);
+
+    // reserves a zeroed glyph in the atlas and returns its rows (valid until the next Add())
+    unsigned char * Add(uint32_t ch, int width, int height);
+    bool Get(uint32_t ch, tGlyph & glyph);
 
-    void PushBack(uint32_t ch, cBitmap *bitmap);
-    cBitmap *GetBitmap(uint32_t ch) const;
+    void SetLimit(unsigned int newLimit);
+    size_t Size() const;
+    size_t AtlasBytes() const { return atlas.size() - unused; }
+    uint64_t Hits() const { return hits; }
+    uint64_t Misses() const { return misses; }
 };
 
-cBitmapCache::cBitmapCache()
-:   next(NULL),
-    ptr(NULL),
-    charcode(0)
+cGlyphCache::cGlyphCache(unsigned int limit)
+:   unused(0),
+    limit(limit),
+    hits(0),
+    misses(0)
 {
+    for (uint32_t i = 0; i < kDirectCacheSize; i++)
+        direct[i].valid = false;
 }
 
-cBitmapCache::~cBitmapCache()
+void cGlyphCache::MoveEntry(tEntry & entry, std::vector<unsigned char> & target) const
 {
-    delete ptr;
-    delete next;
+    size_t offset = target.size();
+    target.insert(target.end(), atlas.begin() + entry.offset, atlas.begin() + entry.offset + Bytes(entry));
+    entry.offset = offset;
 }
 
-void cBitmapCache::PushBack(uint32_t ch, cBitmap *bitmap)
+void cGlyphCache::DropOldest()
 {
-    if (!ptr)
+    std::unordered_map<uint32_t, tEntry>::iterator it = others.find(order.front());
+    if (it != others.end())
+    {
+        unused += Bytes(it->second);
+        others.erase(it);
+    }
+    order.pop_front();
+}
+
+void cGlyphCache::Compact()
+{
+    std::vector<unsigned char> packed;
+    packed.reserve(atlas.size() - unused);
+
+    for (uint32_t i = 0; i < kDirectCacheSize; i++)
     {
-        charcode = ch;
-        ptr = bitmap;
+        if (direct[i].valid)
+            MoveEntry(direct[i], packed);
     }
-    else if (!next)
+    std::unordered_map<uint32_t, tEntry>::iterator it;
+    for (it = others.begin(); it != others.end(); it++)
     {
-        next = new cBitmapCache();
-        next->ptr = bitmap;
-        next->charcode = ch;
-    } else
-        next->PushBack(ch, bitmap);
+        if (it->second.valid)
+            MoveEntry(it->second, packed);
+    }
+    atlas.swap(packed);
+    unused = 0;
 }
 
-cBitmap *cBitmapCache::GetBitmap(uint32_t ch) const
+unsigned char * cGlyphCache::Add(uint32_t ch, int width, int height)
 {
-    if (ptr && charcode==ch)
-        return ptr;
-    else if (next)
-        return next->GetBitmap(ch);
+    tEntry * entry;
+
+    if (ch < kDirectCacheSize)
+    {
+        entry = &direct[ch];
+    }
     else
-        return NULL;
+    {
+        std::unordered_map<uint32_t, tEntry>::iterator it = others.find(ch);
+        if (it == others.end())
+        {
+            // drop the oldest glyphs if the cache is bounded and full
+            while (limit > 0 && others.size() >= limit && !order.empty())
+                DropOldest();
+            entry = &others[ch];
+            entry->valid = false;
+            order.push_back(ch);
+        }
+        else
+            entry = &it->second;
+    }
+
+    if (entry->valid)
+    {
+        unused += Bytes(*entry);
+        entry->valid = false;
+    }
+    // reclaim the space of dropped glyphs once it makes up half of the atlas
+    if (unused > 0 && unused >= atlas.size() / 2)
+        Compact();
+
+    entry->offset = atlas.size();
+    entry->width = width;
+    entry->height = height;
+    entry->valid = true;
+    atlas.resize(atlas.size() + Bytes(*entry), 0);
+    return atlas.data() + entry->offset;
 }
 
-#endif
+bool cGlyphCache::Get(uint32_t ch, tGlyph & glyph)
+{
+    const tEntry * entry = NULL;
+
+    if (ch < kDirectCacheSize)
+    {
+        if (direct[ch].valid)
+            entry = &direct[ch];
+    }
+    else
+    {
+        std::unordered_map<uint32_t, tEntry>::const_iterator it = others.find(ch);
+        if (it != others.end())
+            entry = &it->second;
+    }
+
+    if (!entry)
+    {
+        misses++;
+        return false;
+    }
+    hits++;
+    glyph.data = atlas.data() + entry->offset;
+    glyph.width = entry->width;
+    glyph.height = entry->height;
+    glyph.pitch = (entry->width + 7) / 8;
+    return true;
+}
+
+void cGlyphCache::SetLimit(unsigned int newLimit)
+{
+    limit = newLimit;
+    while (limit > 0 && others.size() > limit && !order.empty())
+        DropOldest();
+}
+
+size_t cGlyphCache::Size() const
+{
+    size_t size = others.size();
+    for (uint32_t i = 0; i < kDirectCacheSize; i++)
+    {
+        if (direct[i].valid)
+            size++;
+    }
+    return size;
+}
 
 cFont::cFont()
+:   cacheLimit(0)
 {
     Init();
 }
@@ -134,24 +259,29 @@ bool cFont::LoadFNT(const std::string & fileName, const std::string & encoding)
     fontType = ftFNT; //original fonts
     isutf8 = (encoding == "UTF-8");
 
-    FILE * fontFile;
-    int i;
-    uint8_t buffer[10000];
+    const uint8_t * buffer;
+    size_t pos;
     uint16_t fontHeight;
     uint16_t numChars;
     int maxWidth = 0;
 
-    fontFile = fopen(fileName.c_str(), "rb");
-    if (!fontFile)
+    // the file is only mapped while loading: the glyph rows are copied into the atlas, so
+    // the font does not depend on the file afterwards (it may be rewritten or truncated)
+    cMappedFile file;
+    if (!file.Open(fileName))
+    {
+        Unload();
         return false;
+    }
+    buffer = file.Data();
 
-    fread(buffer, kFontHeaderSize, 1, fontFile);
-    if (buffer[0] != kFontFileSign[0] ||
+    if (file.Size() < kFontHeaderSize ||
+        buffer[0] != kFontFileSign[0] ||
         buffer[1] != kFontFileSign[1] ||
         buffer[2] != kFontFileSign[2] ||
         buffer[3] != kFontFileSign[3])
     {
-        fclose(fontFile);
+        Unload();
         syslog(LOG_ERR, "cFont::LoadFNT(): Cannot open file: %s - not the correct fileheader.\n",fileName.c_str());
         return false;
     }
@@ -161,43 +291,45 @@ bool cFont::LoadFNT(const std::string & fileName, const std::string & encoding)
     lineHeight = buffer[8] | (buffer[9] << 8);
     spaceBetween = buffer[12] | (buffer[13] << 8);
     numChars = buffer[14] | (buffer[15] << 8);
-    for (i = 0; i < numChars; i++)
+    characters_cache = new cGlyphCache(cacheLimit);
+    pos = kFontHeaderSize;
+    for (int i = 0; i < numChars; i++)
     {
-        uint8_t chdr[kCharHeaderSize];
+        const uint8_t * chdr = buffer + pos;
         uint16_t charWidth;
         uint16_t character;
-        fread(chdr, kCharHeaderSize, 1, fontFile);
+        if (pos + kCharHeaderSize > file.Size())
+        {
+            syslog(LOG_ERR, "cFont::LoadFNT(): Cannot read file: %s - unexpected end of file.\n", fileName.c_str());
+            Unload();
+            return false;
+        }
         character = chdr[0] | (chdr[1] << 8);
         charWidth = chdr[2] | (chdr[3] << 8);
-        fread(buffer, fontHeight * ((charWidth + 7) / 8), 1, fontFile);
+        int pitch = (charWidth + 7) / 8;
+        pos += kCharHeaderSize;
 #ifdef HAVE_DEBUG
-        printf ("fontHeight %0d - charWidth %0d - character %0d - bytes %0d\n", fontHeight, charWidth, character,fontHeight * ((charWidth + 7) / 8));
+        printf ("fontHeight %0d - charWidth %0d - character %0d - bytes %0d\n", fontHeight, charWidth, character, fontHeight * pitch);
 #endif
- 
-        int y; int loop; 
-        int num = 0;
-        unsigned int dot; unsigned int b;
-        cBitmap * charBitmap = new cBitmap(charWidth, fontHeight);
-        charBitmap->SetMonochrome(true);
-        charBitmap->Clear();
-        for (num=0; num<fontHeight * ((charWidth + 7) / 8);num++) {
-            y = (charWidth + 7) / 8;
-            for (loop=0;loop<((charWidth + 7) / 8); loop++) {
-                for (b=0;b<charWidth;b++) {
-                    dot=buffer[num+loop] & (0x80 >> b);
-                    if (dot) {
-                        charBitmap->DrawPixel(b+((loop*8)),num/y,cColor::Black);
-                    }
-                }
-            }
-            num=num+y-1;
+        if (pos + pitch * fontHeight > file.Size())
+        {
+            syslog(LOG_ERR, "cFont::LoadFNT(): Cannot read file: %s - unexpected end of file.\n", fileName.c_str());
+            Unload();
+            return false;
+        }
+        // the rows of the file have exactly the format of the atlas, bits behind the last column are cleared
+        unsigned char * rows = characters_cache->Add((unsigned char) character, charWidth, fontHeight);
+        memcpy(rows, buffer + pos, pitch * fontHeight);
+        if (charWidth % 8)
+        {
+            for (int y = 0; y < fontHeight; y++)
+                rows[y * pitch + pitch - 1] &= (0xFF << (8 - charWidth % 8)) & 0xFF;
         }
-        SetCharacter(character, charBitmap);
+        pos += pitch * fontHeight;
 
         if (charWidth > maxWidth)
             maxWidth = charWidth;
     }
-    fclose(fontFile);
 
     totalWidth = maxWidth;
     totalHeight = fontHeight;
@@ -220,10 +352,12 @@ bool cFont::SaveFNT(const std::string & fileName) const
         return false;
     }
 
+    tGlyph glyph;
+
     numChars = 0;
     for (i = 0; i < 256; i++)
     {
-        if (GetCharacter(i))
+        if (GetGlyph(i, glyph))
         {
             numChars++;
         }
@@ -246,20 +380,23 @@ bool cFont::SaveFNT(const std::string & fileName) const
     // write font file header
     fwrite(fhdr, kFontHeaderSize, 1, fontFile);
 
-    const cBitmap* charbmp = NULL;
     for (i = 0; i < 256; i++)
     {
-        charbmp = GetCharacter(i);
-        if (charbmp)
+        if (GetGlyph(i, glyph))
         {
             chdr[0] = (uint8_t) i;
             chdr[1] = (uint8_t) (i >> 8);
-            chdr[2] = (uint8_t) charbmp->Width();
-            chdr[3] = (uint8_t) (charbmp->Width() >> 8);
+            chdr[2] = (uint8_t) glyph.width;
+            chdr[3] = (uint8_t) (glyph.width >> 8);
             fwrite(chdr, kCharHeaderSize, 1, fontFile);
-            const unsigned char* monobmp = cBitmap::ConvertTo1BPP(*charbmp);
-            fwrite(monobmp /*characters[i]->Data()*/, totalHeight * ((charbmp->Width() + 7) / 8), 1, fontFile);
-            delete[] monobmp;
+            // the glyph rows are stored as they are, padded with empty rows up to the font height
+            int rows = std::min(glyph.height, totalHeight);
+            fwrite(glyph.data, rows * glyph.pitch, 1, fontFile);
+            if (rows < totalHeight)
+            {
+                std::vector<unsigned char> empty((totalHeight - rows) * glyph.pitch, 0);
+                fwrite(empty.data(), empty.size(), 1, fontFile);
+            }
         }
     }
 
@@ -362,7 +499,7 @@ bool cFont::LoadFT2(const std::string & fileName, const std::string & encoding,
     ft2_library = library;
     ft2_face = face;
 
-    characters_cache=new cBitmapCache(); 
+    characters_cache = new cGlyphCache(cacheLimit);
     return true;
 #else
     syslog(LOG_ERR, "cFont::LoadFT2: glcdgraphics was compiled without FreeType2 support!!!");
@@ -372,9 +509,9 @@ bool cFont::LoadFT2(const std::string & fileName, const std::string & encoding,
 
 int cFont::Width(uint32_t ch) const
 {
-    const cBitmap *bitmap = GetCharacter(ch);
-    if (bitmap)
-        return bitmap->Width();
+    tGlyph glyph;
+    if (GetGlyph(ch, glyph))
+        return glyph.width;
     else
         return 0;
 }
@@ -406,9 +543,9 @@ int cFont::Width(const std::string & str, unsigned int len) const
 
 int cFont::Height(uint32_t ch) const
 {
-    const cBitmap *bitmap = GetCharacter(ch);
-    if (bitmap)
-        return bitmap->Height();
+    tGlyph glyph;
+    if (GetGlyph(ch, glyph))
+        return glyph.height;
     else
         return 0;
 }
@@ -433,74 +570,114 @@ int cFont::Height(const std::string & str, unsigned int len) const
     return sum;
 }
 
-const cBitmap * cFont::GetCharacter(uint32_t ch) const
+bool cFont::GetGlyph(uint32_t ch, tGlyph & glyph) const
 {
+    if (!characters_cache)
+        return false;
 #ifdef HAVE_FREETYPE2
     if ( fontType == ftFT2 ) {
-        //lookup in cache
-        cBitmap *ptr=characters_cache->GetBitmap(ch);
-        if (ptr)
-            return ptr;
-
-        FT_Face face = (FT_Face) ft2_face;
-        FT_UInt glyph_index;
-        //Get FT char index
-        if (isutf8) {
-            glyph_index = FT_Get_Char_Index(face, ch);
-        } else {
-            glyph_index = FT_Get_Char_Index(face, iconv_lut[(unsigned char)ch]);
-        }
+        if (characters_cache->Get(ch, glyph))
+            return true;
+        return RenderGlyph(ch, glyph);
+    }
+#endif
+    return characters_cache->Get((unsigned char) ch, glyph);
+}
 
-        //Load the char
-        int error = FT_Load_Glyph(face, glyph_index, FT_LOAD_DEFAULT);
-        if (error)
-        {
-            syslog(LOG_ERR, "cFont::LoadFT2: ERROR when calling FT_Load_Glyph: %x", error);
-            return NULL;
-        }
+bool cFont::RenderGlyph(uint32_t ch, tGlyph & glyph) const
+{
+#ifdef HAVE_FREETYPE2
+    FT_Face face = (FT_Face) ft2_face;
+    FT_UInt glyph_index;
+    //Get FT char index
+    if (isutf8) {
+        glyph_index = FT_Get_Char_Index(face, ch);
+    } else {
+        glyph_index = FT_Get_Char_Index(face, iconv_lut[(unsigned char)ch]);
+    }
 
-        FT_Render_Mode  rmode = FT_RENDER_MODE_MONO;
+    //Load the char
+    int error = FT_Load_Glyph(face, glyph_index, FT_LOAD_DEFAULT);
+    if (error)
+    {
+        syslog(LOG_ERR, "cFont::LoadFT2: ERROR when calling FT_Load_Glyph: %x", error);
+        return false;
+    }
+
+    FT_Render_Mode  rmode = FT_RENDER_MODE_MONO;
 #if ( (FREETYPE_MAJOR == 2 && FREETYPE_MINOR == 1 && FREETYPE_PATCH >= 7) || (FREETYPE_MAJOR == 2 && FREETYPE_MINOR == 2 && FREETYPE_PATCH <= 1) )
-        if (ch == 32) rmode = FT_RENDER_MODE_NORMAL;
+    if (ch == 32) rmode = FT_RENDER_MODE_NORMAL;
 #endif
 
-        // convert to a mono bitmap
-        error = FT_Render_Glyph(face->glyph, rmode);
-        if (error)
+    // convert to a mono bitmap
+    error = FT_Render_Glyph(face->glyph, rmode);
+    if (error)
+    {
+        syslog(LOG_ERR, "cFont::LoadFT2: ERROR when calling FT_Render_Glyph: %x", error);
+        return false;
+    }
+
+    // now, fill our pixel data
+    int width = face->glyph->advance.x >> 6;
+    int height = TotalHeight();
+    if (width < 0)
+        width = 0;
+    if (height < 0)
+        height = 0;
+    int pitch = (width + 7) / 8;
+    unsigned char * rows = characters_cache->Add(ch, width, height);
+
+    int xoffset = face->glyph->metrics.horiBearingX >> 6;
+    int yoffset = (face->size->metrics.ascender >> 6) - (face->glyph->metrics.horiBearingY >> 6);
+    unsigned char * bufPtr = face->glyph->bitmap.buffer;
+    for (unsigned int y = 0; y < face->glyph->bitmap.rows; y++)
+    {
+        int ty = yoffset + (int) y;
+        if (ty >= 0 && ty < height)
         {
-            syslog(LOG_ERR, "cFont::LoadFT2: ERROR when calling FT_Render_Glyph: %x", error);
-            return NULL;
-        } else {
-            // now, fill our pixel data
-            cBitmap *charBitmap = new cBitmap(face->glyph->advance.x >> 6, TotalHeight());
-            charBitmap->Clear(cColor::White);
-            charBitmap->SetMonochrome(true);
-            unsigned char * bufPtr = face->glyph->bitmap.buffer;
-            unsigned char pixel;
-            for (unsigned int y = 0; y < face->glyph->bitmap.rows; y++)
+            for (unsigned int x = 0; x < face->glyph->bitmap.width; x++)
             {
-                for (unsigned int x = 0; x < face->glyph->bitmap.width; x++)
-                {
-                    pixel = (bufPtr[x / 8] >> (7 - x % 8)) & 1;
-                    if (pixel)
-                        charBitmap->DrawPixel((face->glyph->metrics.horiBearingX >> 6) + x,
-                                              (face->size->metrics.ascender >> 6) - (face->glyph->metrics.horiBearingY >> 6) + y,
-                                              /*GLCD::clrBlack*/ cColor::Black);
-                }
-                bufPtr += face->glyph->bitmap.pitch;
+                int tx = xoffset + (int) x;
+                if (tx >= 0 && tx < width && ((bufPtr[x / 8] >> (7 - x % 8)) & 1))
+                    rows[ty * pitch + tx / 8] |= 0x80 >> (tx % 8);
             }
-
-            // adjust maxwidth if necessary
-            //if (totalWidth < charBitmap->Width())
-            //    totalWidth = charBitmap->Width();
-
-            characters_cache->PushBack(ch, charBitmap);
-            return charBitmap;
         }
-        return NULL; // if any
-    } // else
+        bufPtr += face->glyph->bitmap.pitch;
+    }
+
+    glyph.data = rows;
+    glyph.width = width;
+    glyph.height = height;
+    glyph.pitch = pitch;
+    return true;
+#else
+    return false;
 #endif
-    return characters[(unsigned char) ch];
+}
+
+const cBitmap * cFont::GetCharacter(uint32_t ch) const
+{
+    if (fontType != ftFT2)
+        ch = (unsigned char) ch;
+
+    std::map<uint32_t, cBitmap *>::const_iterator it = characters.find(ch);
+    if (it != characters.end())
+        return it->second;
+
+    tGlyph glyph;
+    if (!GetGlyph(ch, glyph))
+        return NULL;
+
+    cBitmap * charBitmap = new cBitmap(glyph.width, glyph.height);
+    if (fontType == ftFT2)
+        charBitmap->Clear(cColor::White);
+    else
+        charBitmap->Clear();
+    charBitmap->SetMonochrome(true);
+    charBitmap->DrawBitmap1BPP(0, 0, glyph.data, glyph.pitch, 0, glyph.width, glyph.height, cColor::Black, cColor::Transparent);
+    charBitmap->ResetDamage();
+    characters[ch] = charBitmap;
+    return charBitmap;
 }
 
 void cFont::SetCharacter(char ch, cBitmap * bitmapChar)
@@ -515,12 +692,67 @@ void cFont::SetCharacter(char ch, cBitmap * bitmapChar)
     if (totalWidth < bitmapChar->Width())
         totalWidth = bitmapChar->Width();
 
-    // delete if already allocated
-    if (characters[(unsigned char) ch])
-        delete characters[(unsigned char) ch];
+    if (!characters_cache)
+        characters_cache = new cGlyphCache(cacheLimit);
 
-    // store new character
-    characters[(unsigned char) ch] = bitmapChar;
+    // store new character in the glyph atlas
+    int width = bitmapChar->Width();
+    int height = bitmapChar->Height();
+    int pitch = (width + 7) / 8;
+    unsigned char * rows = characters_cache->Add((unsigned char) ch, width, height);
+    const uint32_t * data = bitmapChar->Data();
+    for (int y = 0; y < height; y++)
+    {
+        for (int x = 0; x < width; x++)
+        {
+            if ((data[y * width + x] | 0xFF000000) == cColor::Black)
+                rows[y * pitch + x / 8] |= 0x80 >> (x % 8);
+        }
+    }
+    delete bitmapChar;
+
+    // drop an outdated ARGB copy
+    std::map<uint32_t, cBitmap *>::iterator it = characters.find((unsigned char) ch);
+    if (it != characters.end())
+    {
+        delete it->second;
+        characters.erase(it);
+    }
+}
+
+void cFont::SetCacheLimit(unsigned int limit)
+{
+    cacheLimit = limit;
+    if (characters_cache)
+        characters_cache->SetLimit(limit);
+}
+
+unsigned int cFont::CacheSize() const
+{
+    if (characters_cache)
+        return characters_cache->Size();
+    return 0;
+}
+
+unsigned int cFont::CacheBytes() const
+{
+    if (characters_cache)
+        return characters_cache->AtlasBytes();
+    return 0;
+}
+
+uint64_t cFont::CacheHits() const
+{
+    if (characters_cache)
+        return characters_cache->Hits();
+    return 0;
+}
+
+uint64_t cFont::CacheMisses() const
+{
+    if (characters_cache)
+        return characters_cache->Misses();
+    return 0;
 }
 
 void cFont::Init()
@@ -530,14 +762,10 @@ void cFont::Init()
     totalAscent = 0;
     spaceBetween = 0;
     lineHeight = 0;
-    for (int i = 0; i < 256; i++)
-    {
-        characters[i] = NULL;
-    }
+    characters_cache = NULL;
 #ifdef HAVE_FREETYPE2
     ft2_library = NULL;
     ft2_face = NULL;
-    characters_cache = NULL;
 #endif
     fontType = ftFNT;
 }
@@ -545,15 +773,12 @@ void cFont::Init()
 void cFont::Unload()
 {
     // cleanup
-    for (int i = 0; i < 256; i++)
-    {
-        if (characters[i])
-        {
-            delete characters[i];
-        }
-    }
-#ifdef HAVE_FREETYPE2
+    std::map<uint32_t, cBitmap *>::iterator it;
+    for (it = characters.begin(); it != characters.end(); it++)
+        delete it->second;
+    characters.clear();
     delete characters_cache;
+#ifdef HAVE_FREETYPE2
     if (ft2_face)
         FT_Done_Face((FT_Face)ft2_face);
     if (ft2_library)
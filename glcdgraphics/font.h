@@ -19,13 +19,24 @@
 
 #include <string>
 #include <vector>
+#include <map>
 
 #include "bitmap.h"
 
 namespace GLCD
 {
 
-class cBitmapCache;
+class cGlyphCache;
+
+// glyph as stored in the packed 1 bpp glyph atlas of a font.
+// every row starts at a byte boundary, the most significant bit is the leftmost pixel.
+struct tGlyph
+{
+    const unsigned char * data;
+    int width;
+    int height;
+    int pitch;  // bytes per row
+};
 
 class cFont
 {
@@ -44,15 +55,17 @@ private:
     int spaceBetween;
     int lineHeight;
 
-    cBitmap * characters[256];
     eFontType fontType;
 
     bool isutf8;
     wchar_t iconv_lut[256]; // lookup table needed if encoding != UTF-8
 
-    cBitmapCache *characters_cache; 
+    cGlyphCache *characters_cache; 
+    unsigned int cacheLimit;
+    mutable std::map<uint32_t, cBitmap *> characters; // ARGB copies created by GetCharacter()
     void *ft2_library; //FT_Library
     void *ft2_face; //FT_Face
+    bool RenderGlyph(uint32_t ch, tGlyph & glyph) const;
 protected:
     void Init();
     void Unload();
@@ -83,12 +96,25 @@ public:
     int Height(const std::string & str) const;
     int Height(const std::string & str, unsigned int len) const;
 
+    // the returned glyph data is valid until the next glyph gets rendered or set
+    bool GetGlyph(uint32_t ch, tGlyph & glyph) const;
+    // ARGB bitmap of a glyph, created from the glyph atlas on first use and kept until the font is unloaded
     const cBitmap * GetCharacter(uint32_t ch) const;
+    // converts the bitmap into the glyph atlas and takes ownership of it
     void SetCharacter(char ch, cBitmap * bitmapChar);
 
     void WrapText(int Width, int Height, std::string & Text,
                   std::vector <std::string> & Lines, int * TextWidth = NULL) const;
     bool IsUTF8(void) const { return isutf8; }
+
+    // glyph cache (packed 1 bpp glyph atlas).
+    // the limit applies to glyphs outside of the range 0 - 255 (0 == unlimited)
+    void SetCacheLimit(unsigned int limit);
+    unsigned int CacheLimit(void) const { return cacheLimit; }
+    unsigned int CacheSize(void) const;
+    unsigned int CacheBytes(void) const;
+    uint64_t CacheHits(void) const;
+    uint64_t CacheMisses(void) const;
 };
 
 } // end of namespace
@@ -23,6 +23,7 @@
 #include "bitmap.h"
 #include "glcd.h"
 #include "image.h"
+#include "mapfile.h"
 
 
 namespace GLCD
@@ -55,109 +56,117 @@ cGLCDFile::~cGLCDFile()
 {
 }
 
-bool cGLCDFile::Load(cImage & image, const string & fileName)
+// packed 1 bpp frames of a GLCD file, expanded to ARGB when they are needed.
+// the frames are a copy, the file may be rewritten while the image is in use.
+class cGLCDSource : public cImageSource
 {
-    FILE * fp;
-    long fileSize;
-    char sign[4];
-    uint8_t buf[6];
+private:
+    std::vector<unsigned char> frames;
     uint16_t width;
     uint16_t height;
-    uint16_t count;
-    uint32_t delay;
+public:
+    cGLCDSource(const unsigned char * Frames, size_t Size, uint16_t Width, uint16_t Height)
+    :   frames(Frames, Frames + Size), width(Width), height(Height) {}
+    virtual cBitmap * Decode(unsigned int nr);
+    virtual size_t Memory() const { return frames.capacity(); }
+};
 
-    fp = fopen(fileName.c_str(), "rb");
-    if (!fp)
-    {
-        syslog(LOG_ERR, "glcdgraphics: opening of '%s' failed (cGLCDFile::Load).", fileName.c_str());
-        return false;
-    }
+cBitmap * cGLCDSource::Decode(unsigned int nr)
+{
+    int colsize = (width + 7) / 8;
+    const unsigned char * bmpdata_raw = frames.data() + (size_t) nr * height * colsize;
+    cBitmap * b = new cBitmap(width, height);
+    uint32_t * bmpdata = (uint32_t *) b->Data();
 
-    // get len of file
-    if (fseek(fp, 0, SEEK_END) != 0)
-    {
-        fclose(fp);
-        return false;
+    for (int j = 0; j < height; j++) {
+        for (int i = 0; i < width; i++) {
+            if (  bmpdata_raw[j*colsize + (i>>3)] & (1 << (7-(i%8))) ) {
+                bmpdata[j*width+i] = cColor::Black;
+            } else {
+                bmpdata[j*width+i] = cColor::White;
+            }
+        }
     }
-    fileSize = ftell(fp);
+#ifdef HAVE_DEBUG
+    printf("%s:%s(%d) - frame %d\n", __FILE__, __FUNCTION__, __LINE__, nr);
+#endif
+    b->SetMonochrome(true);
+    return b;
+}
 
-    // rewind and get Header
-    if (fseek(fp, 0, SEEK_SET) != 0)
-    {
-        fclose(fp);
-        return false;
-    }
+bool cGLCDFile::Load(cImage & image, const string & fileName)
+{
+    cMappedFile file;
+    size_t fileSize;
+    size_t offset;
+    const uint8_t * buf;
+    uint16_t width;
+    uint16_t height;
+    uint16_t count;
+    uint32_t delay;
 
-    // read header sign
-    if (fread(sign, 4, 1, fp) != 1)
+    // the file is only mapped while loading, the packed frames are copied and expanded on their first use
+    if (!file.Open(fileName))
     {
-        fclose(fp);
+        syslog(LOG_ERR, "glcdgraphics: opening of '%s' failed (cGLCDFile::Load).", fileName.c_str());
         return false;
     }
+    fileSize = file.Size();
+    buf = file.Data();
 
     // check header sign
-    if (strncmp(sign, kGLCDFileSign, 3) != 0)
+    if (fileSize < 8 || strncmp((const char *) buf, kGLCDFileSign, 3) != 0)
     {
         syslog(LOG_ERR, "glcdgraphics: loading of '%s' failed, wrong header (cGLCDFile::Load).", fileName.c_str());
-        fclose(fp);
         return false;
     }
 
     // read width and height
-    if (fread(buf, 4, 1, fp) != 1)
-    {
-        fclose(fp);
-        return false;
-    }
-
-    width = (buf[1] << 8) | buf[0];
-    height = (buf[3] << 8) | buf[2];
+    width = (buf[5] << 8) | buf[4];
+    height = (buf[7] << 8) | buf[6];
     if (width == 0 || height == 0)
     {
         syslog(LOG_ERR, "glcdgraphics: loading of '%s' failed, wrong header (cGLCDFile::Load).", fileName.c_str());
-        fclose(fp);
         return false;
     }
 
-    if (sign[3] == 'D')
+    if (buf[3] == 'D')
     {
         count = 1;
         delay = 10;
         // check file length
-        if (fileSize != (long) (height * ((width + 7) / 8) + 8))
+        if (fileSize != (size_t) (height * ((width + 7) / 8) + 8))
         {
             syslog(LOG_ERR, "glcdgraphics: loading of '%s' failed, wrong size (cGLCDFile::Load).", fileName.c_str());
-            fclose(fp);
             return false;
         }
+        offset = 8;
     }
-    else if (sign[3] == 'A')
+    else if (buf[3] == 'A')
     {
         // read count and delay
-        if (fread(buf, 6, 1, fp) != 1)
+        if (fileSize < 14)
         {
             syslog(LOG_ERR, "glcdgraphics: loading of '%s' failed, wrong header (cGLCDFile::Load).", fileName.c_str());
-            fclose(fp);
             return false;
         }
-        count = (buf[1] << 8) | buf[0];
-        delay = (buf[5] << 24) | (buf[4] << 16) | (buf[3] << 8) | buf[2];
+        count = (buf[9] << 8) | buf[8];
+        delay = (buf[13] << 24) | (buf[12] << 16) | (buf[11] << 8) | buf[10];
         // check file length
         if (count == 0 ||
-            fileSize != (long) (count * (height * ((width + 7) / 8)) + 14))
+            fileSize != (size_t) (count * (height * ((width + 7) / 8)) + 14))
         {
             syslog(LOG_ERR, "glcdgraphics: loading of '%s' failed, wrong size (cGLCDFile::Load).", fileName.c_str());
-            fclose(fp);
             return false;
         }
         // Set minimal limit for next image
         if (delay < 10)
             delay = 10;
+        offset = 14;
     }
     else
     {
         syslog(LOG_ERR, "glcdgraphics: loading of '%s' failed, wrong header (cGLCDFile::Load).", fileName.c_str());
-        fclose(fp);
         return false;
     }
 
@@ -165,53 +174,7 @@ bool cGLCDFile::Load(cImage & image, const string & fileName)
     image.SetWidth(width);
     image.SetHeight(height);
     image.SetDelay(delay);
-    unsigned char * bmpdata_raw = new unsigned char[height * ((width + 7) / 8)];
-    uint32_t * bmpdata = new uint32_t[height * width];
-    if (bmpdata && bmpdata_raw)
-    {
-        for (unsigned int n = 0; n < count; n++)
-        {
-            if (fread(bmpdata_raw, height * ((width + 7) / 8), 1, fp) != 1)
-            {
-                delete[] bmpdata;
-                fclose(fp);
-                image.Clear();
-                return false;
-            }
-            int colsize = (width+7)/8;
-            for (int j = 0; j < height; j++) {
-                for (int i = 0; i < width; i++) {
-                    if (  bmpdata_raw[j*colsize + (i>>3)] & (1 << (7-(i%8))) ) {
-                        bmpdata[j*width+i] = cColor::Black;
-                    } else {
-                        bmpdata[j*width+i] = cColor::White;
-                    }
-                }
-            }
-#ifdef HAVE_DEBUG
-    printf("%s:%s(%d) - filename: '%s', count %d\n", __FILE__, __FUNCTION__, __LINE__, fileName.c_str(), n);
-#endif
-            cBitmap * b = new cBitmap(width, height, bmpdata);
-            b->SetMonochrome(true);
-            //image.AddBitmap(new cBitmap(width, height, bmpdata));
-            image.AddBitmap(b);
-        }
-        delete[] bmpdata;
-    }
-    else
-    {
-        syslog(LOG_ERR, "glcdgraphics: malloc failed (cGLCDFile::Load).");
-        if (bmpdata)
-            delete[] bmpdata;
-        if (bmpdata_raw)
-            delete[] bmpdata_raw;
-        fclose(fp);
-        image.Clear();
-        return false;
-    }
-    fclose(fp);
-    if (bmpdata_raw)
-        delete[] bmpdata_raw;
+    image.SetSource(new cGLCDSource(buf + offset, fileSize - offset, width, height), count);
 
     syslog(LOG_DEBUG, "glcdgraphics: image '%s' loaded.", fileName.c_str());
     return true;
@@ -230,6 +193,12 @@ bool cGLCDFile::Save(cImage & image, const string & fileName)
 
     if (image.Count() == 0)
         return false;
+    bitmap = image.GetBitmap(0);
+    if (!bitmap)
+    {
+        syslog(LOG_ERR, "glcdgraphics: decoding of the first frame failed (cGLCDFile::Save).");
+        return false;
+    }
 
     fp = fopen(fileName.c_str(), "wb");
     if (!fp)
@@ -249,7 +218,6 @@ bool cGLCDFile::Save(cImage & image, const string & fileName)
     {
         buf[3] = 'A';
     }
-    bitmap = image.GetBitmap(0);
     width = bitmap->Width();
     height = bitmap->Height();
     buf[4] = (uint8_t) width;
@@ -281,7 +249,13 @@ bool cGLCDFile::Save(cImage & image, const string & fileName)
     for (i = 0; i < count; i++)
     {
         bitmap = image.GetBitmap(i);
-        if (bitmap)
+        if (!bitmap)
+        {
+            syslog(LOG_ERR, "glcdgraphics: decoding of frame %d failed (cGLCDFile::Save).", i);
+            fclose(fp);
+            return false;
+        }
+        else
         {
             if (bitmap->Width() == width && bitmap->Height() == height)
             {
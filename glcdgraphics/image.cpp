@@ -32,7 +32,9 @@ cImage::cImage()
     height(0),
     delay(0),
     curBitmap(0),
-    lastChange(0)
+    lastChange(0),
+    source(NULL),
+    keepFrames(0)
 {
 }
 
@@ -43,16 +45,41 @@ cImage::~cImage()
 
 cBitmap * cImage::GetBitmap() const
 {
-    if (curBitmap < bitmaps.size())
-        return bitmaps[curBitmap];
-    return NULL;
+    return GetBitmap(curBitmap);
 }
 
 cBitmap * cImage::GetBitmap(unsigned int nr) const
 {
-    if (nr < bitmaps.size())
-        return bitmaps[nr];
-    return NULL;
+    if (nr >= bitmaps.size())
+        return NULL;
+    if (!bitmaps[nr] && source)
+    {
+        bitmaps[nr] = source->Decode(nr);
+        if (bitmaps[nr] && keepFrames > 0)
+        {
+            decoded.push_back(nr);
+            if (decoded.size() > keepFrames)
+            {
+                delete bitmaps[decoded.front()];
+                bitmaps[decoded.front()] = NULL;
+                decoded.pop_front();
+            }
+        }
+    }
+    return bitmaps[nr];
+}
+
+void cImage::SetSource(cImageSource * Source, unsigned int count, unsigned int Keep)
+{
+    // replaces all frames, so that the frame numbers of the image are the ones of the source
+    vector <cBitmap *>::iterator it;
+    for (it = bitmaps.begin(); it != bitmaps.end(); it++)
+        delete *it;
+    bitmaps.assign(count, NULL);
+    decoded.clear();
+    delete source;
+    source = Source;
+    keepFrames = Keep;
 }
 
 void cImage::Clear()
@@ -63,6 +90,10 @@ void cImage::Clear()
         delete *it;
     }
     bitmaps.clear();
+    decoded.clear();
+    delete source;
+    source = NULL;
+    keepFrames = 0;
     width = 0;
     height = 0;
     delay = 0;
@@ -71,7 +102,7 @@ void cImage::Clear()
 }
 
 
-uint32_t cImage::Blend(uint32_t FgColour, uint32_t BgColour, uint8_t Level, double antiAliasGranularity) const
+uint32_t cImage::Blend(uint32_t FgColour, uint32_t BgColour, uint8_t Level, double antiAliasGranularity)
 {
     if (antiAliasGranularity > 0.0)
        Level = uint8_t(int(Level / antiAliasGranularity + 0.5) * antiAliasGranularity);
@@ -90,24 +121,36 @@ uint32_t cImage::Blend(uint32_t FgColour, uint32_t BgColour, uint8_t Level, doub
     return (A << 24) | (R << 16) | (G << 8) | B;
 }
 
-bool cImage::Scale(uint16_t scalew, uint16_t scaleh, bool AntiAlias)
+// decodes the frames of another source and scales them
+class cScaledSource : public cImageSource
 {
-    if (! (scalew || scaleh) )
-        return false;
-
-    unsigned int orig_w = Width();
-    unsigned int orig_h = Height();
-
-    // one out of scalew/h == 0 ? -> auto aspect ratio
-    if (scalew && ! scaleh) {
-       scaleh = (uint16_t)( ((uint32_t)scalew * (uint32_t)orig_h) / (uint32_t)orig_w );
-    } else if (!scalew && scaleh) {
-       scalew = (uint16_t)( ((uint32_t)scaleh * (uint32_t)orig_w) / (uint32_t)orig_h );
-    }
+private:
+    cImageSource * source;
+    uint16_t scalew;
+    uint16_t scaleh;
+    bool antiAlias;
+public:
+    cScaledSource(cImageSource * Source, uint16_t w, uint16_t h, bool AntiAlias)
+    :   source(Source), scalew(w), scaleh(h), antiAlias(AntiAlias) {}
+    virtual ~cScaledSource() { delete source; }
+    virtual cBitmap * Decode(unsigned int nr);
+    virtual size_t Memory() const { return source->Memory(); }
+};
+
+cBitmap * cScaledSource::Decode(unsigned int nr)
+{
+    cBitmap * frame = source->Decode(nr);
+    if (!frame)
+        return NULL;
+    cBitmap * b = cImage::ScaleBitmap(*frame, scalew, scaleh, antiAlias);
+    delete frame;
+    return b;
+}
 
-    cImage tempImg = cImage();
-    tempImg.SetWidth(scalew);
-    tempImg.SetHeight(scaleh);
+cBitmap * cImage::ScaleBitmap(const cBitmap & frame, uint16_t scalew, uint16_t scaleh, bool AntiAlias)
+{
+    unsigned int orig_w = frame.Width();
+    unsigned int orig_h = frame.Height();
 
     // Scaling/Blending based on VDR / osd.c
     // Fixed point scaling code based on www.inversereality.org/files/bitmapscaling.pdf
@@ -132,66 +175,76 @@ bool cImage::Scale(uint16_t scalew, uint16_t scaleh, bool AntiAlias)
 
     bool downscale = (!AntiAlias || (FactorX <= 1.0 && FactorY <= 1.0));
 
-    for (unsigned int frame = 0; frame < Count() ; frame ++ ) {
-        cBitmap *b = new cBitmap(scalew, scaleh, GRAPHLCD_Transparent);
-
-        cBitmap *currFrame = GetBitmap(frame);
-
-        b->SetMonochrome(currFrame->IsMonochrome());
-
-        if (downscale) {
-            // Downscaling - no anti-aliasing:
-            const uint32_t *DestRow = b->Data();
-            int SourceY = 0;
-            for (int y = 0; y < scaleh; y++) {
-                int SourceX = 0;
-                const uint32_t *SourceRow = currFrame->Data() + (SourceY >> 16) * orig_w;
-                uint32_t *Dest = (uint32_t*) DestRow;
-                for (int x = 0; x < scalew; x++) {
-                    *Dest++ = SourceRow[SourceX >> 16];
-                    SourceX += RatioX;
-                }
-                SourceY += RatioY;
-                DestRow += scalew;
+    cBitmap *b = new cBitmap(scalew, scaleh, GRAPHLCD_Transparent);
+
+    b->SetMonochrome(frame.IsMonochrome());
+
+    if (downscale) {
+        // Downscaling - no anti-aliasing:
+        const uint32_t *DestRow = b->Data();
+        int SourceY = 0;
+        for (int y = 0; y < scaleh; y++) {
+            int SourceX = 0;
+            const uint32_t *SourceRow = frame.Data() + (SourceY >> 16) * orig_w;
+            uint32_t *Dest = (uint32_t*) DestRow;
+            for (int x = 0; x < scalew; x++) {
+                *Dest++ = SourceRow[SourceX >> 16];
+                SourceX += RatioX;
             }
-        } else {
-            // Upscaling - anti-aliasing:
-            int SourceY = 0;
-            for (int y = 0; y < scaleh /*- 1*/; y++) {
-                int SourceX = 0;
-                int sy = SourceY >> 16;
-                uint8_t BlendY = 0xFF - ((SourceY >> 8) & 0xFF);
-                for (int x = 0; x < scalew /*- 1*/; x++) {
-                    int sx = SourceX >> 16;
-                    uint8_t BlendX = 0xFF - ((SourceX >> 8) & 0xFF);
-                    // TODO: antiAliasGranularity
-                    uint32_t c1 = Blend(currFrame->GetPixel(sx, sy),     currFrame->GetPixel(sx + 1, sy),     BlendX);
-                    uint32_t c2 = Blend(currFrame->GetPixel(sx, sy + 1), currFrame->GetPixel(sx + 1, sy + 1), BlendX);
-                    uint32_t c3 = Blend(c1, c2, BlendY);
-                    b->DrawPixel(x, y, c3);
-                    SourceX += RatioX;
-                }
-                SourceY += RatioY;
+            SourceY += RatioY;
+            DestRow += scalew;
+        }
+    } else {
+        // Upscaling - anti-aliasing:
+        int SourceY = 0;
+        for (int y = 0; y < scaleh /*- 1*/; y++) {
+            int SourceX = 0;
+            int sy = SourceY >> 16;
+            uint8_t BlendY = 0xFF - ((SourceY >> 8) & 0xFF);
+            for (int x = 0; x < scalew /*- 1*/; x++) {
+                int sx = SourceX >> 16;
+                uint8_t BlendX = 0xFF - ((SourceX >> 8) & 0xFF);
+                // TODO: antiAliasGranularity
+                uint32_t c1 = Blend(frame.GetPixel(sx, sy),     frame.GetPixel(sx + 1, sy),     BlendX);
+                uint32_t c2 = Blend(frame.GetPixel(sx, sy + 1), frame.GetPixel(sx + 1, sy + 1), BlendX);
+                uint32_t c3 = Blend(c1, c2, BlendY);
+                b->DrawPixel(x, y, c3);
+                SourceX += RatioX;
             }
+            SourceY += RatioY;
         }
-        tempImg.AddBitmap(b);
     }
-    // clear all bitmaps from this image
-    unsigned int temp_delay = Delay();
-    Clear();
-    // set new resolution
+    return b;
+}
+
+bool cImage::Scale(uint16_t scalew, uint16_t scaleh, bool AntiAlias)
+{
+    if (! (scalew || scaleh) )
+        return false;
+
+    unsigned int orig_w = Width();
+    unsigned int orig_h = Height();
+
+    // one out of scalew/h == 0 ? -> auto aspect ratio
+    if (scalew && ! scaleh) {
+       scaleh = (uint16_t)( ((uint32_t)scalew * (uint32_t)orig_h) / (uint32_t)orig_w );
+    } else if (!scalew && scaleh) {
+       scalew = (uint16_t)( ((uint32_t)scaleh * (uint32_t)orig_w) / (uint32_t)orig_h );
+    }
+
+    // frames that are not decoded yet are scaled when they are decoded
+    if (source)
+        source = new cScaledSource(source, scalew, scaleh, AntiAlias);
+
+    for (unsigned int frame = 0; frame < Count() ; frame ++ ) {
+        if (!bitmaps[frame])
+            continue;
+        cBitmap * b = ScaleBitmap(*bitmaps[frame], scalew, scaleh, AntiAlias);
+        delete bitmaps[frame];
+        bitmaps[frame] = b;
+    }
     SetWidth(scalew);
     SetHeight(scaleh);
-    SetDelay(temp_delay);
-    // re-add bitmaps from scaled image container
-    cBitmap * b;
-    cBitmap * tempb;
-    for (unsigned int frame = 0; frame < tempImg.Count(); frame ++) {
-      tempb = tempImg.GetBitmap(frame);
-      b = new cBitmap(scalew, scaleh, (uint32_t*)tempb->Data());
-      b->SetMonochrome(tempb->IsMonochrome());
-      AddBitmap(b);
-    }
     return true;
 }
 
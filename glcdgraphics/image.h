@@ -18,6 +18,7 @@
 
 #include <stdint.h>
 
+#include <deque>
 #include <vector>
 #include <string>
 
@@ -26,6 +27,17 @@ namespace GLCD
 
 class cBitmap;
 
+// decodes the frames of an image when they are first needed (see cImage::SetSource())
+class cImageSource
+{
+public:
+    virtual ~cImageSource() {}
+    // a new bitmap with frame nr, NULL on failure
+    virtual cBitmap * Decode(unsigned int nr) = 0;
+    // bytes the source holds besides the frames it has decoded (e.g. the compressed file)
+    virtual size_t Memory() const { return 0; }
+};
+
 class cImage
 {
 private:
@@ -34,9 +46,14 @@ private:
     unsigned int delay;
     unsigned int curBitmap;
     uint64_t lastChange;
-    std::vector <cBitmap *> bitmaps;
+    mutable std::vector <cBitmap *> bitmaps;    // NULL: not decoded yet
+    cImageSource * source;
+    unsigned int keepFrames;                    // decoded frames kept, 0: all
+    mutable std::deque <unsigned int> decoded;  // kept frames, oldest first
 
-    uint32_t Blend(uint32_t fgcol, uint32_t bgcol, uint8_t level, double antiAliasGranularity = 0.0) const;
+    static uint32_t Blend(uint32_t fgcol, uint32_t bgcol, uint8_t level, double antiAliasGranularity = 0.0);
+    static cBitmap * ScaleBitmap(const cBitmap & frame, uint16_t scalew, uint16_t scaleh, bool AntiAlias);
+    friend class cScaledSource;
 public:
     cImage();
     ~cImage();
@@ -54,6 +71,15 @@ public:
     cBitmap * GetBitmap(unsigned int nr) const;
     cBitmap * GetBitmap() const;
     void AddBitmap(cBitmap * Bitmap) { bitmaps.push_back(Bitmap); }
+    // replaces the frames of the image by count frames that are decoded by Source on their
+    // first GetBitmap(), takes over Source. bitmaps added afterwards follow these frames.
+    // with Keep > 0 only the Keep most recently decoded frames are kept, older ones are
+    // deleted and decoded again when needed: a bitmap returned by GetBitmap() is then only
+    // valid until the next GetBitmap() and changes to it may get lost. for read-only users
+    // like the image cache of glcdskin.
+    void SetSource(cImageSource * Source, unsigned int count, unsigned int Keep = 0);
+    unsigned int KeepFrames() const { return keepFrames; }
+    size_t SourceMemory() const { return source ? source->Memory() : 0; }
     void Clear();
 
     bool Scale(uint16_t scalew, uint16_t scaleh, bool AntiAlias = false);
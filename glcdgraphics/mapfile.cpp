@@ -0,0 +1,82 @@
+/*
+ * GraphLCD graphics library
+ *
+ * mapfile.c  -  read-only file mapped into memory
+ *
+ * This file is released under the GNU General Public License. Refer
+ * to the COPYING file distributed with this package.
+ */
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "mapfile.h"
+
+namespace GLCD
+{
+
+cMappedFile::cMappedFile()
+:   map(NULL),
+    size(0)
+{
+}
+
+cMappedFile::~cMappedFile()
+{
+    Close();
+}
+
+bool cMappedFile::Open(const std::string & fileName)
+{
+    Close();
+
+    int fd = open(fileName.c_str(), O_RDONLY);
+    if (fd == -1)
+        return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        close(fd);
+        return false;
+    }
+
+    if (S_ISREG(st.st_mode) && st.st_size > 0)
+    {
+        void * p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p != MAP_FAILED)
+        {
+            map = p;
+            size = st.st_size;
+            close(fd);
+            return true;
+        }
+    }
+
+    // not mappable (e.g. a pipe or an empty file): read it
+    unsigned char chunk[4096];
+    ssize_t n;
+    while ((n = read(fd, chunk, sizeof(chunk))) > 0)
+        buffer.insert(buffer.end(), chunk, chunk + n);
+    close(fd);
+    if (n < 0)
+    {
+        buffer.clear();
+        return false;
+    }
+    size = buffer.size();
+    return true;
+}
+
+void cMappedFile::Close()
+{
+    if (map)
+        munmap(map, size);
+    map = NULL;
+    size = 0;
+    std::vector<unsigned char>().swap(buffer);
+}
+
+} // end of namespace
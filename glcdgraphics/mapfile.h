@@ -0,0 +1,45 @@
+/*
+ * GraphLCD graphics library
+ *
+ * mapfile.h  -  read-only file mapped into memory
+ *
+ * This file is released under the GNU General Public License. Refer
+ * to the COPYING file distributed with this package.
+ */
+
+#ifndef _GLCDGRAPHICS_MAPFILE_H_
+#define _GLCDGRAPHICS_MAPFILE_H_
+
+#include <stddef.h>
+
+#include <string>
+#include <vector>
+
+namespace GLCD
+{
+
+// the contents of a file, mapped with mmap() or read into memory if the file cannot be mapped.
+// pointers into Data() stay valid until Close() or the destruction.
+class cMappedFile
+{
+private:
+    void * map;
+    size_t size;
+    std::vector<unsigned char> buffer;  // used if mapping failed
+
+    cMappedFile(const cMappedFile &);
+    cMappedFile & operator=(const cMappedFile &);
+public:
+    cMappedFile();
+    ~cMappedFile();
+
+    bool Open(const std::string & fileName);
+    void Close();
+
+    const unsigned char * Data() const { return map ? (const unsigned char *) map : buffer.data(); }
+    size_t Size() const { return size; }
+};
+
+} // end of namespace
+
+#endif
@@ -165,13 +165,19 @@ bool cPBMFile::Save(cImage & image, const std::string & fileName)
     unsigned char* rawdata = NULL;
     int rawdata_size = 0;
     const uint32_t * bmpdata = NULL;
+    bool result = true;
 
     if (image.Count() == 1)
     {
-        fp = fopen(fileName.c_str(), "wb");
+        bitmap = image.GetBitmap(0);
+        if (!bitmap)
+        {
+            syslog(LOG_ERR, "glcdgraphics: decoding of the image failed (cPBMFile::Save).");
+            result = false;
+        }
+        fp = bitmap ? fopen(fileName.c_str(), "wb") : NULL;
         if (fp)
         {
-            bitmap = image.GetBitmap(0);
             rawdata_size = ((bitmap->Width() + 7) / 8) * bitmap->Height();
             rawdata = new unsigned char[ rawdata_size ];
             bmpdata = bitmap->Data();
@@ -211,10 +217,15 @@ bool cPBMFile::Save(cImage & image, const std::string & fileName)
         for (i = 0; i < image.Count(); i++)
         {
             sprintf(tmpStr, "%.244s-%05d%s", fileBase.c_str(), i, fileExt.c_str());
-            fp = fopen(tmpStr, "wb");
+            bitmap = image.GetBitmap(i);
+            if (!bitmap)
+            {
+                syslog(LOG_ERR, "glcdgraphics: decoding of frame %d failed (cPBMFile::Save).", i);
+                result = false;
+            }
+            fp = bitmap ? fopen(tmpStr, "wb") : NULL;
             if (fp)
             {
-                bitmap = image.GetBitmap(i);
                 rawdata_size = ((bitmap->Width() + 7) / 8) * bitmap->Height();
                 rawdata = new unsigned char[ rawdata_size ];
                 bmpdata = bitmap->Data();
@@ -240,7 +251,7 @@ bool cPBMFile::Save(cImage & image, const std::string & fileName)
             }
         }
     }
-    return true;
+    return result;
 }
 
 } // end of namespace
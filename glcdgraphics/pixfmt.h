@@ -0,0 +1,114 @@
+/*
+ * GraphLCD graphics library
+ *
+ * pixfmt.h  -  pixel access of the native cBitmap formats
+ *
+ * This file is released under the GNU General Public License. Refer
+ * to the COPYING file distributed with this package.
+ */
+
+#ifndef _GLCDGRAPHICS_PIXFMT_H_
+#define _GLCDGRAPHICS_PIXFMT_H_
+
+#include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+
+
+namespace GLCD
+{
+
+// luminance 0 - 255 of an ARGB colour, same weights as the conversion of the driver library
+inline uint32_t Luminance(uint32_t color)
+{
+    return (((color >> 16) & 0xFF) * 77 + ((color >> 8) & 0xFF) * 150 + (color & 0xFF) * 29) >> 8;
+}
+
+// fills the pixels x1 - x2 of a line with bpp (1, 2 or 4) bits per pixel, first pixel in the msb.
+// pattern is a byte completely filled with the value of a pixel.
+inline void FillPacked(unsigned char * line, int bpp, int x1, int x2, unsigned char pattern)
+{
+    int first = x1 * bpp;
+    int last = x2 * bpp + bpp - 1;
+    unsigned char * p = line + (first >> 3);
+    unsigned char * end = line + (last >> 3);
+    unsigned char m1 = 0xFF >> (first & 7);
+    unsigned char m2 = 0xFF << (7 - (last & 7));
+
+    if (p == end)
+    {
+        m1 &= m2;
+        *p = (*p & ~m1) | (pattern & m1);
+        return;
+    }
+    *p = (*p & ~m1) | (pattern & m1);
+    memset(p + 1, pattern, end - p - 1);
+    *end = (*end & ~m2) | (pattern & m2);
+}
+
+// the formats describe how the pixels of a line are stored. Encode() and Decode() convert between
+// an ARGB colour (alpha is dropped) and the value of a pixel, Get() and Set() access a single pixel,
+// Fill() the pixels x1 - x2. formats with Levels > 0 have no more than that many pixel values.
+
+// 1 bpp, first pixel in the msb, bit set: white
+struct tFormatMono
+{
+    enum { Levels = 2 };
+
+    static uint32_t Encode(uint32_t color) { return Luminance(color) >= 128; }
+    static uint32_t Decode(uint32_t value) { return value ? 0xFFFFFFFF : 0xFF000000; }
+    static uint32_t Get(const unsigned char * line, int x) { return (line[x >> 3] >> (7 - (x & 7))) & 1; }
+    static void Set(unsigned char * line, int x, uint32_t value)
+    {
+        unsigned char bit = 0x80 >> (x & 7);
+        if (value)
+            line[x >> 3] |= bit;
+        else
+            line[x >> 3] &= ~bit;
+    }
+    static void Fill(unsigned char * line, int x1, int x2, uint32_t value) { FillPacked(line, 1, x1, x2, value ? 0xFF : 0x00); }
+};
+
+// 4 bit grey, first pixel in the high nibble
+struct tFormatGrey4
+{
+    enum { Levels = 16 };
+
+    static uint32_t Encode(uint32_t color) { return Luminance(color) >> 4; }
+    static uint32_t Decode(uint32_t value) { return 0xFF000000 | (value * 0x111111); }
+    static uint32_t Get(const unsigned char * line, int x) { return (line[x >> 1] >> ((x & 1) ? 0 : 4)) & 0x0F; }
+    static void Set(unsigned char * line, int x, uint32_t value)
+    {
+        if (x & 1)
+            line[x >> 1] = (line[x >> 1] & 0xF0) | value;
+        else
+            line[x >> 1] = (line[x >> 1] & 0x0F) | (value << 4);
+    }
+    static void Fill(unsigned char * line, int x1, int x2, uint32_t value) { FillPacked(line, 4, x1, x2, value * 0x11); }
+};
+
+// 16 bit 5-6-5 in host byte order
+struct tFormatRGB565
+{
+    enum { Levels = 0 };
+
+    static uint32_t Encode(uint32_t color)
+    {
+        return ((color >> 8) & 0xF800) | ((color >> 5) & 0x07E0) | ((color >> 3) & 0x001F);
+    }
+    static uint32_t Decode(uint32_t value)
+    {
+        uint32_t r = (value >> 11) & 0x1F;
+        uint32_t g = (value >> 5) & 0x3F;
+        uint32_t b = value & 0x1F;
+        return 0xFF000000 | (((r << 3) | (r >> 2)) << 16) | (((g << 2) | (g >> 4)) << 8) | ((b << 3) | (b >> 2));
+    }
+    static uint32_t Get(const unsigned char * line, int x) { return ((const uint16_t *) line)[x]; }
+    static void Set(unsigned char * line, int x, uint32_t value) { ((uint16_t *) line)[x] = value; }
+    static void Fill(unsigned char * line, int x1, int x2, uint32_t value) { std::fill_n((uint16_t *) line + x1, x2 - x1 + 1, (uint16_t) value); }
+};
+
+} // end of namespace
+
+#endif
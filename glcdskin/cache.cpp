@@ -25,13 +25,26 @@
 namespace GLCD
 {
 
+// long animations in other formats are decoded on demand, keeping this many frames.
+// the cache only draws the frames, so they may be dropped and decoded again.
+static const unsigned int kImageRingSize = 8;
+
 cImageItem::cImageItem(const std::string & path, cImage * image, uint16_t scalew, uint16_t scaleh)
 :   path(path),
-    counter(0),
     image(image),
     scale_width(scalew),
-    scale_height(scaleh)
+    scale_height(scaleh),
+    memory(sizeof(cImageItem) + sizeof(cImage) + path.capacity()),
+    prev(NULL),
+    next(NULL)
 {
+    // counted as if all frames (or all the image keeps) were decoded, without decoding them,
+    // plus what the source of lazily decoded frames holds (compressed file, decoded window)
+    size_t frames = image->Count();
+    if (image->KeepFrames() > 0 && image->KeepFrames() < frames)
+        frames = image->KeepFrames();
+    memory += frames * (sizeof(cBitmap) + (size_t) image->Width() * image->Height() * sizeof(uint32_t));
+    memory += image->SourceMemory();
 }
 
 cImageItem::~cImageItem()
@@ -40,9 +53,16 @@ cImageItem::~cImageItem()
 }
 
 
-cImageCache::cImageCache(cSkin * Parent, int Size)
+cImageCache::cImageCache(cSkin * Parent, size_t Budget)
 :   skin(Parent),
-    size(Size)
+    budget(Budget),
+    memory(0),
+    first(NULL),
+    last(NULL),
+    count(0),
+    hits(0),
+    misses(0),
+    evictions(0)
 {
 }
 
@@ -53,66 +73,117 @@ cImageCache::~cImageCache()
 
 void cImageCache::Clear(void)
 {
-    for (unsigned int i = 0; i < images.size(); i++)
+    cImageItem * item = first;
+    while (item)
     {
-        delete images[i];
+        cImageItem * next = item->next;
+        delete item;
+        item = next;
     }
+    first = last = NULL;
     images.clear();
     failedpaths.clear();
+    memory = 0;
+    count = 0;
 }
 
-cImage * cImageCache::Get(const std::string & path, uint16_t & scalew, uint16_t & scaleh)
+void cImageCache::SetBudget(size_t Budget)
 {
-    std::vector <cImageItem *>::iterator it;
-    cImageItem * item;
-    uint64_t maxCounter;
-    std::vector <cImageItem *>::iterator oldest;
+    budget = Budget;
+    Evict(first);
+}
+
+void cImageCache::Unlink(cImageItem * item)
+{
+    if (item->prev)
+        item->prev->next = item->next;
+    else
+        first = item->next;
+    if (item->next)
+        item->next->prev = item->prev;
+    else
+        last = item->prev;
+    item->prev = item->next = NULL;
+}
 
+void cImageCache::LinkFirst(cImageItem * item)
+{
+    item->prev = NULL;
+    item->next = first;
+    if (first)
+        first->prev = item;
+    else
+        last = item;
+    first = item;
+}
+
+void cImageCache::Evict(const cImageItem * keep)
+{
+    while (budget > 0 && memory > budget && last && last != keep)
+    {
+        cImageItem * item = last;
+        Unlink(item);
+
+        std::vector<cImageItem *> & scaled = images[item->path];
+        for (size_t i = 0; i < scaled.size(); i++)
+        {
+            if (scaled[i] == item)
+            {
+                scaled.erase(scaled.begin() + i);
+                break;
+            }
+        }
+        if (scaled.empty())
+            images.erase(item->path);
+
+        memory -= item->memory;
+        count--;
+        evictions++;
+        delete item;
+    }
+}
+
+cImage * cImageCache::Get(const std::string & path, uint16_t & scalew, uint16_t & scaleh)
+{
     // test if this path has already been stored as invalid path / invalid/non-existent image
-    for (size_t i = 0; i < failedpaths.size(); i++) {
-      if (failedpaths[i] == path) {
+    if (failedpaths.find(path) != failedpaths.end())
+    {
+        hits++;
         return NULL;
-      }
     }
 
-    maxCounter = 0;
-    item = NULL;
-    for (it = images.begin(); it != images.end(); it++)
+    std::unordered_map<std::string, std::vector<cImageItem *> >::iterator it = images.find(path);
+    if (it != images.end())
     {
-        uint16_t scw = 0, sch = 0;
-        (*it)->ScalingGeometry(scw, sch);
-        if (item == NULL && path == (*it)->Path() && ( (scw == 0 && sch == 0 && ! (scalew || scaleh)) || (scw == scalew && sch == scaleh)))
+        const std::vector<cImageItem *> & scaled = it->second;
+        for (size_t i = 0; i < scaled.size(); i++)
         {
-            (*it)->ResetCounter();
-            item = (*it);
-        }
-        else
-        {
-            (*it)->IncCounter();
-            if ((*it)->Counter() > maxCounter)
+            if (scaled[i]->scale_width == scalew && scaled[i]->scale_height == scaleh)
             {
-                maxCounter = (*it)->Counter();
-                oldest = it;
+                hits++;
+                if (scaled[i] != first)
+                {
+                    Unlink(scaled[i]);
+                    LinkFirst(scaled[i]);
+                }
+                return scaled[i]->Image();
             }
         }
     }
-    if (item)
-    {
-        return item->Image();
-    }
 
-    item = LoadImage(path, scalew, scaleh);
+    misses++;
+    cImageItem * item = LoadImage(path, scalew, scaleh);
     if (item)
     {
         syslog(LOG_INFO, "INFO: graphlcd: successfully loaded image '%s'\n", path.c_str());
-        if (images.size() == size)
-        {
-            images.erase(oldest);
-        }
-        images.push_back(item);
+        images[path].push_back(item);
+        LinkFirst(item);
+        memory += item->memory;
+        count++;
+        Evict(item);
         return item->Image();
     } else {
-      failedpaths.push_back(path);
+      failedpaths.insert(path);
     }
     return NULL;
 }
@@ -170,7 +241,9 @@ cImageItem * cImageCache::LoadImage(const std::string & path, uint16_t scalew, u
     } else if (strcmp(str, "GLCD") == 0) {
         imgFile = new cGLCDFile();
     } else {
-        imgFile = new cExtFormatFile();
+        cExtFormatFile * extFile = new cExtFormatFile();
+        extFile->SetRingSize(kImageRingSize);
+        imgFile = extFile;
     }
 
     uint16_t scale_width = scalew;
@@ -15,6 +15,8 @@
 
 #include <string>
 #include <vector>
+#include <unordered_map>
+#include <unordered_set>
 
 #include <glcdgraphics/image.h>
 
@@ -25,34 +27,49 @@ class cSkin;
 
 class cImageItem
 {
+    friend class cImageCache;
 private:
     std::string path;
-    uint64_t counter;
     cImage * image;
     uint16_t scale_width, scale_height;
+    size_t memory;                  // bytes used by all frames of the image
+    cImageItem * prev;              // neighbours in the LRU list of the cache
+    cImageItem * next;
 public:
     cImageItem(const std::string & path, cImage * image, uint16_t scalew, uint16_t scaleh);
     ~cImageItem();
 
     const std::string & Path() const { return path; }
     void ScalingGeometry(uint16_t & scalew, uint16_t & scaleh) { scalew = scale_width; scaleh = scale_height; }
-    uint64_t Counter() const { return counter; }
+    size_t Memory() const { return memory; }
     cImage * Image() { return image; }
-    void ResetCounter() { counter = 0; }
-    void IncCounter() { counter += 1; }
 };
 
+// images by path and scaling geometry. when the images use more memory than the budget,
+// the least recently used ones are dropped. an image returned by Get() stays valid until
+// the next call of Get() or Clear().
 class cImageCache
 {
 private:
     cSkin * skin;
-    size_t size;
-    std::vector <cImageItem *> images;
-    std::vector <std::string> failedpaths;
+    size_t budget;                  // max. memory of the cached images in bytes (0 == unlimited)
+    size_t memory;
+    // all scaled versions of a path
+    std::unordered_map<std::string, std::vector<cImageItem *> > images;
+    std::unordered_set<std::string> failedpaths;
+    cImageItem * first;             // LRU list: most recently used image first
+    cImageItem * last;
+    size_t count;
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
 
     cImageItem * LoadImage(const std::string & path, uint16_t scalew, uint16_t scaleh);
+    void Unlink(cImageItem * item);
+    void LinkFirst(cImageItem * item);
+    void Evict(const cImageItem * keep);
 public:
-    cImageCache(cSkin * Parent, int Size);
+    cImageCache(cSkin * Parent, size_t Budget);
     ~cImageCache();
 
     cImage * Get(const std::string & path, uint16_t & scalew, uint16_t & scaleh);
@@ -63,6 +80,17 @@ public:
     }
     
     void Clear(void);
+
+    // the most recently used image is kept even if it alone exceeds the budget
+    void SetBudget(size_t Budget);
+    size_t Budget(void) const { return budget; }
+    size_t Memory(void) const { return memory; }
+    size_t Size(void) const { return count; }
+    uint64_t Hits(void) const { return hits; }
+    uint64_t Misses(void) const { return misses; }
+    uint64_t Evictions(void) const { return evictions; }
+    // hit rate in percent
+    int HitRate(void) const { return (hits + misses) ? (int) (hits * 100 / (hits + misses)) : 0; }
 };
 
 } // end of namespace
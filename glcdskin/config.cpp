@@ -1,11 +1,19 @@
 #include "config.h"
 #include "type.h"
+#include "string.h"
 
 #include <sys/time.h>
 
 namespace GLCD
 {
 
+cSkinConfig::cSkinConfig(void)
+:   mTokenTracking(false),
+    mChangeCount(1),
+    mAllChanged(1)
+{
+}
+
 std::string cSkinConfig::SkinPath(void)
 {
     return ".";
@@ -49,5 +57,32 @@ uint64_t cSkinConfig::Now(void)
     return (uint64_t)(tv.tv_sec * 1000 + tv.tv_usec / 1000);
 }
 
+void cSkinConfig::TokenChanged(int Id)
+{
+    mTokenChanges[Id] = ++mChangeCount;
+}
+
+void cSkinConfig::AllTokensChanged(void)
+{
+    mAllChanged = ++mChangeCount;
+    mTokenChanges.clear();
+}
+
+bool cSkinConfig::ChangedSince(const tSkinDependencies & Dependencies, uint64_t Count) const
+{
+    if (mAllChanged > Count || Dependencies.Volatile)
+        return true;
+    if (mChangeCount <= Count || Dependencies.Tokens.empty())
+        return false;
+
+    std::set<int>::const_iterator it = Dependencies.Tokens.begin();
+    for (; it != Dependencies.Tokens.end(); ++it)
+    {
+        std::map<int, uint64_t>::const_iterator change = mTokenChanges.find(*it);
+        if (change != mTokenChanges.end() && change->second > Count)
+            return true;
+    }
+    return false;
+}
 
 } // end of namespace
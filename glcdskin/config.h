@@ -14,6 +14,7 @@
 #define _GLCDSKIN_CONFIG_H_
 
 #include <string>
+#include <map>
 
 #include <stdint.h>
 
@@ -25,11 +26,19 @@ namespace GLCD
 class cType;
 class cFont;
 struct tSkinToken;
+struct tSkinDependencies;
 class cDriver;
 
 class cSkinConfig
 {
+private:
+    bool     mTokenTracking;
+    uint64_t mChangeCount;                  // incremented for every reported change
+    uint64_t mAllChanged;                   // change count of the last AllTokensChanged()
+    std::map<int, uint64_t> mTokenChanges;  // token id -> change count of its last change
+
 public:
+    cSkinConfig(void);
     virtual ~cSkinConfig() {};
 
     virtual std::string SkinPath(void);
@@ -41,6 +50,19 @@ public:
     virtual int GetTabPosition(int Index, int MaxWidth, const cFont & Font);
     virtual uint64_t Now(void);
     virtual cDriver * GetDriver(void) const { return NULL; }
+
+    // token change tracking: when enabled, the application has to report every token
+    // that changed its value by TokenChanged(). skin objects then only evaluate their
+    // texts and conditions again when a token they depend on has changed.
+    void SetTokenTracking(bool Enable) { mTokenTracking = Enable; }
+    bool TokenTracking(void) const { return mTokenTracking; }
+    void TokenChanged(int Id);
+    void TokenChanged(const std::string & Name) { TokenChanged(GetTokenId(Name)); }
+    void AllTokensChanged(void);
+
+    uint64_t ChangeCount(void) const { return mChangeCount; }
+    // true if one of the tokens in Dependencies changed after change count Count
+    bool ChangedSince(const tSkinDependencies & Dependencies, uint64_t Count) const;
 };
 
 } // end of namespace
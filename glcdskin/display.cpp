@@ -11,6 +11,8 @@
  */
 
 #include "display.h"
+#include "skin.h"
+#include "config.h"
 
 namespace GLCD
 {
@@ -23,8 +25,88 @@ cSkinDisplay::cSkinDisplay(cSkin * parent)
 
 void cSkinDisplay::Render(cBitmap * screen)
 {
+    bool tracking = mSkin->Config().TokenTracking();
+
     for (uint32_t i = 0; i < NumObjects(); ++i)
-        GetObject(i)->Render(screen);
+    {
+        if (tracking)
+            GetObject(i)->RenderTracked(screen);
+        else
+            GetObject(i)->Render(screen);
+    }
+}
+
+static bool Overlap(tRect a, const tRect & b)
+{
+    a.Intersect(b);
+    return !a.IsEmpty();
+}
+
+bool cSkinDisplay::RenderChanges(cBitmap * screen, uint64_t CurrentTime, uint32_t Background)
+{
+    if (!mSkin->Config().TokenTracking())
+    {
+        screen->Clear(Background);
+        Render(screen);
+        return true;
+    }
+
+    // areas to draw again: the old and the new place of each changed object,
+    // overlapping areas are merged so that no object is drawn twice
+    std::vector<bool> changed(NumObjects(), false);
+    std::vector<tRect> objectAreas(NumObjects());
+    std::vector<tRect> areas;
+    for (uint32_t i = 0; i < NumObjects(); ++i)
+    {
+        cSkinObject * object = GetObject(i);
+        if (!object->NeedsRedraw(CurrentTime))
+            continue;
+
+        changed[i] = true;
+        tRect area = object->RenderArea();
+        tPoint pos = object->Pos();
+        tSize size = object->Size();
+        area.Unite(tRect(pos.x, pos.y, pos.x + size.w - 1, pos.y + size.h - 1));
+        area.Intersect(tRect(0, 0, screen->Width() - 1, screen->Height() - 1));
+        if (area.IsEmpty())
+        {
+            // nothing of it is visible, only its dependencies are updated
+            object->RenderTracked(screen);
+            changed[i] = false;
+            continue;
+        }
+        objectAreas[i] = area;
+
+        for (size_t j = 0; j < areas.size(); )
+        {
+            if (Overlap(areas[j], area))
+            {
+                area.Unite(areas[j]);
+                areas.erase(areas.begin() + j);
+                j = 0;
+            }
+            else
+                j++;
+        }
+        areas.push_back(area);
+    }
+
+    for (size_t j = 0; j < areas.size(); j++)
+    {
+        const tRect & area = areas[j];
+        screen->PushClip(area.x1, area.y1, area.x2, area.y2);
+        screen->ClearArea(area.x1, area.y1, area.x2, area.y2, Background);
+        for (uint32_t i = 0; i < NumObjects(); ++i)
+        {
+            cSkinObject * object = GetObject(i);
+            if (changed[i] && area.Contains(objectAreas[i]))
+                object->RenderTracked(screen);
+            else if (!changed[i] && Overlap(area, object->RenderArea()))
+                object->Render(screen);
+        }
+        screen->PopClip();
+    }
+    return !areas.empty();
 }
 
 
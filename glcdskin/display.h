@@ -43,6 +43,11 @@ public:
     cSkinObject * GetObject(uint32_t n) const { return mObjects[n]; }
 
     void Render(cBitmap * screen);
+    // with token tracking: draws only the objects that changed since the last Render() or
+    // RenderChanges(). their areas are cleared to Background and all objects overlapping
+    // them are drawn again, clipped to the areas. without token tracking the whole screen is
+    // cleared and drawn. returns false if nothing had to be drawn.
+    bool RenderChanges(cBitmap * screen, uint64_t CurrentTime, uint32_t Background = cColor::Transparent);
 
     bool NeedsUpdate(uint64_t CurrentTime);
 
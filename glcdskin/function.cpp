@@ -14,6 +14,8 @@
 
 #include <string.h>
 
+#include <new>
+
 #include "skin.h"
 #include "function.h"
 
@@ -37,51 +39,132 @@ static const char * Internals[] =
     NULL
 };
 
+// code size up to which evaluation works on the stack only
+static const int kLocalCodeSize = 16;
+
+// typed stack slot of the evaluation: numbers and booleans are stored directly,
+// strings as a cType in the value storage of the evaluation.
+// the conversions are the same as done by cType (the number of a boolean is 0)
+struct cSkinFunction::tSlot
+{
+    cType::eType  Type;
+    int           Number;
+    cType       * Value;
+
+    int ToNumber(void) const
+    {
+        switch (Type)
+        {
+            case cType::string:
+                return Value->Number();
+            case cType::number:
+                return Number;
+            default:
+                return 0;
+        }
+    }
+
+    bool ToBool(void) const { return (Type == cType::string) ? (bool) *Value : Number != 0; }
+
+    cType ToType(void) const
+    {
+        switch (Type)
+        {
+            case cType::string:
+                return *Value;
+            case cType::number:
+                return cType(Number);
+            default:
+                return cType(Number != 0);
+        }
+    }
+
+    std::string ToString(void) const { return (Type == cType::string) ? (std::string) *Value : ToType().String(); }
+
+    // strings are moved into Storage
+    void Set(cType && Src, cType *& Storage)
+    {
+        if (Src.IsNumber())
+        {
+            Type = cType::number;
+            Number = Src.Number();
+        }
+        else if (Src.IsBoolean())
+        {
+            Type = cType::boolean;
+            Number = (bool) Src;
+        }
+        else
+        {
+            Type = cType::string;
+            Value = new (Storage++) cType(std::move(Src));
+        }
+    }
+};
+
 cSkinFunction::cSkinFunction(cSkinObject *Parent)
 :   mObject(Parent),
-    mSkin(Parent->Skin()),
-    mType(string),
-    mString(mObject, false),
-    mNumber(0),
-    mNumParams(0)
+    mSkin(Parent->Skin())
 {
+    // an unparsed function evaluates to an empty string
+    Emit(opString, -1);
 }
 
 cSkinFunction::cSkinFunction(const cSkinString & String)
 :   mObject(String.Object()),
-    mSkin(String.Skin()),
-    mType(string),
-    mString(String),
-    mNumber(0),
-    mNumParams(0)
+    mSkin(String.Skin())
 {
+    mStrings.push_back(String);
+    Emit(opString, 0);
 }
 
 cSkinFunction::cSkinFunction(const cSkinFunction & Src)
 :   mObject(Src.mObject),
     mSkin(Src.mSkin),
-    mType(Src.mType),
-    mString(Src.mString),
-    mNumber(Src.mNumber),
-    mNumParams(Src.mNumParams)
+    mCode(Src.mCode),
+    mStrings(Src.mStrings),
+    mVariables(Src.mVariables)
 {
-    for (uint32_t i = 0; i < mNumParams; ++i)
-        mParams[i] = new cSkinFunction(*Src.mParams[i]);
 }
 
 cSkinFunction::~cSkinFunction()
 {
-    for (uint32_t i = 0; i < mNumParams; ++i)
-        delete mParams[i];
+}
+
+size_t cSkinFunction::Emit(eOpCode Op, int Arg, int Count)
+{
+    tInstruction instruction;
+    instruction.Op = Op;
+    instruction.Count = Count;
+    instruction.Arg = Arg;
+    mCode.push_back(instruction);
+    return mCode.size() - 1;
 }
 
 bool cSkinFunction::Parse(const std::string & Text, bool reparse)
+{
+    mCode.clear();
+    mStrings.clear();
+    mVariables.clear();
+    if (Compile(Text, reparse))
+        return true;
+
+    // incomplete code must not be run, fall back to an empty string
+    mCode.clear();
+    Emit(opString, -1);
+    return false;
+}
+
+bool cSkinFunction::Compile(const std::string & Text, bool reparse)
 {
     const char *text = Text.c_str();
     const char *ptr = text, *last = text;
     eType type = undefined_function;
+    eType function = undefined_function;   // function the compiled parameters belong to
+    uint32_t numParams = 0;
+    std::vector<size_t> jumps;               // short circuit jumps of and() / or()
+    int stringIndex = -1;
     int inExpr = 0;
-    cSkinFunction *expr;
 
     if (*ptr == '\'' || *ptr == '{')
     {
@@ -105,10 +188,12 @@ bool cSkinFunction::Parse(const std::string & Text, bool reparse)
         while ((pos = temp.find("\\'", pos + 1)) != -1)
             temp.replace(pos, 2, "'");
 
-        if (!mString.Parse(temp))
+        cSkinString string(mObject, false);
+        if (!string.Parse(temp))
             return false;
 
-        mType = string;
+        stringIndex = mStrings.size();
+        mStrings.push_back(string);
     }
     if (*ptr == '#')
     {
@@ -120,8 +205,9 @@ bool cSkinFunction::Parse(const std::string & Text, bool reparse)
             return false;
         }
 
-        mVariableId.assign(ptr + 1);
-        mType = variable;
+        Emit(opVariable, mVariables.size());
+        mVariables.push_back(tSkinVariableRef(mSkin, ptr + 1));
+        return true;
     }
     else if ((*ptr >= '0' && *ptr <= '9') || *ptr == '-' || *ptr == '+')
     {
@@ -135,8 +221,8 @@ bool cSkinFunction::Parse(const std::string & Text, bool reparse)
             return false;
         }
 
-        mNumber = num;
-        mType = number;
+        Emit(opNumber, num);
+        return true;
     }
     else
     {
@@ -186,14 +272,10 @@ bool cSkinFunction::Parse(const std::string & Text, bool reparse)
 
                 if (inExpr == 1)
                 {
-                    expr = new cSkinFunction(mObject);
-                    if (!expr->Parse(std::string(last, ptr - last)))
-                    {
-                        delete expr;
+                    if (!Compile(std::string(last, ptr - last), false))
                         return false;
-                    }
 
-                    if (mNumParams == MAXPARAMETERS)
+                    if (numParams == MAXPARAMETERS)
                     {
                         if (!reparse) // only log this error when not reparsing
                             syslog(LOG_ERR, "ERROR: graphlcd/skin/function: Too many parameters to function, maximum is %d",
@@ -201,8 +283,13 @@ bool cSkinFunction::Parse(const std::string & Text, bool reparse)
                         return false;
                     }
 
-                    mType = type;
-                    mParams[mNumParams++] = expr;
+                    function = type;
+                    numParams++;
+                    // and() / or() stop at the first parameter that decides the result
+                    if (function == fun_and)
+                        jumps.push_back(Emit(opJumpIfFalse));
+                    else if (function == fun_or)
+                        jumps.push_back(Emit(opJumpIfTrue));
                     last = ptr + 1;
                 }
 
@@ -212,7 +299,7 @@ bool cSkinFunction::Parse(const std::string & Text, bool reparse)
                     {
                         int params = 0;
 
-                        switch (mType)
+                        switch (function)
                         {
                             case fun_and:
                             case fun_or:
@@ -271,10 +358,10 @@ bool cSkinFunction::Parse(const std::string & Text, bool reparse)
                                 break;
                         }
 
-                        if (params != -1 && mNumParams != (uint32_t) params)
+                        if (params != -1 && numParams != (uint32_t) params)
                         {
                             syslog(LOG_ERR, "ERROR: graphlcd/skin/function: Wrong number of parameters to %s, "
-                                    "expecting %d", Internals[mType - INTERNAL], params);
+                                    "expecting %d", Internals[function - INTERNAL], params);
                             return false;
                         }
                     }
@@ -293,6 +380,22 @@ bool cSkinFunction::Parse(const std::string & Text, bool reparse)
         }
     }
 
+    if (function == fun_and || function == fun_or)
+    {
+        // all parameters passed: and() is true, or() is false
+        bool passed = (function == fun_and);
+        Emit(opBool, passed);
+        size_t end = Emit(opJump);
+        for (size_t i = 0; i < jumps.size(); i++)
+            mCode[jumps[i]].Arg = mCode.size();
+        Emit(opBool, !passed);
+        mCode[end].Arg = mCode.size();
+    }
+    else if (function != undefined_function)
+        Emit(opCall, function, numParams);
+    else
+        Emit(opString, stringIndex);
+
     return true;
 }
 
@@ -354,30 +457,89 @@ cType cSkinFunction::FunImage(eType Function, const cType &Param) const
     return false;
 }
 
-cType cSkinFunction::Evaluate(void) const
+cType cSkinFunction::Call(eType Function, const tSlot * Params, int Count) const
 {
-    switch (mType)
+    // functions that are not evaluated by Run() directly
+    switch (Function)
     {
-        case string:
-            return mString.Evaluate();
+        case fun_equal:
+        case fun_eq:
+        case fun_ne:
+        {
+            bool equal;
+            if (Params[0].Type == cType::number && Params[1].Type == cType::number)
+                equal = Params[0].Number == Params[1].Number;
+            else
+                equal = Params[0].ToString() == Params[1].ToString();
+            return (Function == fun_ne) ? !equal : equal;
+        }
+
+        case fun_file:
+            mSkin->RecordVolatile();
+            return FunFile(Params[0].ToType());
+
+        case fun_trans:
+            return mSkin->Config().Translate(Params[0].ToString());
+
+        case funFontTotalWidth:
+        case funFontTotalHeight:
+        case funFontTotalAscent:
+        case funFontSpaceBetween:
+        case funFontLineHeight:
+            return FunFont(Function, Params[0].ToType(), "");
 
-        case number:
-            return mNumber;
+        case funFontTextWidth:
+        case funFontTextHeight:
+            return FunFont(Function, Params[0].ToType(), Params[1].ToType());
+
+        case funImageWidth:
+        case funImageHeight:
+            mSkin->RecordVolatile();
+            return FunImage(Function, Params[0].ToType());
+
+        case funQueryFeature: {
+            int value;
+            mSkin->RecordVolatile();
+            if (mSkin->Config().GetDriver()->GetFeature(Params[0].ToString(), value)) {
+                return (bool) value;
+            } else {
+                return false;
+            }
+        }
 
-        case variable:
+        default:
+            //Dprintf("unknown function code\n");
+            syslog(LOG_ERR, "ERROR: graphlcd/skin/function: Unknown function code called (this shouldn't happen)");
+            break;
+    }
+    return false;
+}
+
+cType cSkinFunction::Operand(const tInstruction & Instruction) const
+{
+    switch (Instruction.Op)
+    {
+        case opString:
+            if (Instruction.Arg < 0)
+                return "";
+            return mStrings[Instruction.Arg].Evaluate();
+
+        case opNumber:
+            return (int) Instruction.Arg;
+
+        case opVariable:
         {
-            cSkinVariable * variable = mSkin->GetVariable(mVariableId);
+            cSkinVariable * variable = mSkin->GetVariable(mVariables[Instruction.Arg]);
             if (variable) {
                 cType rv = variable->Value();
                 if (rv.IsString()) {
                     std::string val = rv;
                     if (val.find("{") != std::string::npos || val.find("#") != std::string::npos) {
-                        cSkinString *result = new cSkinString(mObject, false);
-                        if (result->Parse(val)) {
-                            val = (std::string) result->Evaluate();
+                        cType result;
+                        if (mSkin->FunctionCache()->EvaluateString(mObject, val, result)) {
+                            val = (std::string) result;
                             rv = cType(val);
                         }
-                        delete result;
                     }
                 }
                 return rv;
@@ -385,115 +547,255 @@ cType cSkinFunction::Evaluate(void) const
             return false;
         }
 
-        case fun_not:
-            return !mParams[0]->Evaluate();
+        default:
+            return Instruction.Arg != 0;
+    }
+}
 
-        case fun_and:
-            for (uint32_t i = 0; i < mNumParams; ++i)
-            {
-                if (!mParams[i]->Evaluate())
-                    return false;
-            }
-            return true;
+cType cSkinFunction::Evaluate(void) const
+{
+    // most functions are a single operand, these don't need the stack machine
+    if (mCode.size() == 1 && mCode[0].Op != opCall)
+        return Operand(mCode[0]);
 
-        case fun_or:
-            for (uint32_t i = 0; i < mNumParams; ++i)
-            {
-                if (mParams[i]->Evaluate())
-                    return true;
-            }
-            return false;
+    return Run();
+}
 
-        case fun_equal:
-        case fun_eq:
-            return (std::string) mParams[0]->Evaluate() == (std::string) mParams[1]->Evaluate();
+cType cSkinFunction::Run(void) const
+{
+    // every instruction pushes at most one value and there are no backward jumps,
+    // so the code size limits both the stack and the value storage
+    if (mCode.size() <= (size_t) kLocalCodeSize)
+    {
+        tSlot slots[kLocalCodeSize];
+        alignas(cType) unsigned char values[kLocalCodeSize * sizeof(cType)];
+        return Run(slots, reinterpret_cast<cType *>(values));
+    }
+    std::vector<tSlot> slots(mCode.size());
+    cType * values = static_cast<cType *>(::operator new(mCode.size() * sizeof(cType)));
+    cType result = Run(slots.data(), values);
+    ::operator delete(values);
+    return result;
+}
 
-        case fun_ne:
-            return (std::string) mParams[0]->Evaluate() != (std::string) mParams[1]->Evaluate();
+cType cSkinFunction::Run(tSlot * Slots, cType * Values) const
+{
+    tSlot * sp = Slots;         // next free slot
+    cType * vp = Values;        // next free value
+    size_t pc = 0;
 
-        case fun_gt:
-            return (int) mParams[0]->Evaluate() >  (int) mParams[1]->Evaluate();
+    while (pc < mCode.size())
+    {
+        const tInstruction & instruction = mCode[pc++];
 
-        case fun_lt:
-            return (int) mParams[0]->Evaluate() <  (int) mParams[1]->Evaluate();
+        switch (instruction.Op)
+        {
+            case opString:
+            case opVariable:
+                (sp++)->Set(Operand(instruction), vp);
+                continue;
+
+            case opNumber:
+                sp->Type = cType::number;
+                sp->Number = instruction.Arg;
+                sp++;
+                continue;
+
+            case opBool:
+                sp->Type = cType::boolean;
+                sp->Number = instruction.Arg != 0;
+                sp++;
+                continue;
+
+            case opJump:
+                pc = instruction.Arg;
+                continue;
+
+            case opJumpIfFalse:
+            case opJumpIfTrue:
+                if ((--sp)->ToBool() == (instruction.Op == opJumpIfTrue))
+                    pc = instruction.Arg;
+                continue;
+
+            case opCall:
+            {
+                // the parameters are replaced by the result
+                sp -= instruction.Count;
+                const tSlot * params = sp;
+                int result;
 
-        case fun_ge:
-            return (int) mParams[0]->Evaluate() >= (int) mParams[1]->Evaluate();
+                switch (instruction.Arg)
+                {
+                    case fun_not:
+                        sp->Type = cType::boolean;
+                        sp->Number = !params[0].ToBool();
+                        sp++;
+                        continue;
+
+                    case fun_gt:
+                    case fun_lt:
+                    case fun_ge:
+                    case fun_le:
+                    {
+                        int a = params[0].ToNumber();
+                        int b = params[1].ToNumber();
+                        sp->Type = cType::boolean;
+                        sp->Number = (instruction.Arg == fun_gt) ? a >  b
+                                   : (instruction.Arg == fun_lt) ? a <  b
+                                   : (instruction.Arg == fun_ge) ? a >= b : a <= b;
+                        sp++;
+                        continue;
+                    }
 
-        case fun_le:
-            return (int) mParams[0]->Evaluate() <= (int) mParams[1]->Evaluate();
+                    case funAdd:
+                        result = 0;
+                        for (int i = 0; i < instruction.Count; ++i)
+                            result += params[i].ToNumber();
+                        break;
 
-        case fun_file:
-            return FunFile(mParams[0]->Evaluate());
+                    case funSub:
+                        result = 0;
+                        if (instruction.Count > 0)
+                        {
+                            result = params[0].ToNumber();
+                            for (int i = 1; i < instruction.Count; ++i)
+                                result -= params[i].ToNumber();
+                        }
+                        break;
 
-        case fun_trans:
-            return mSkin->Config().Translate(mParams[0]->Evaluate());
+                    case funMul:
+                        result = 1;
+                        for (int i = 0; i < instruction.Count; ++i)
+                            result *= params[i].ToNumber();
+                        break;
 
-        case funAdd:
-        {
-            int result = 0;
-            for (uint32_t i = 0; i < mNumParams; ++i)
-            {
-                result += (int) mParams[i]->Evaluate();
-            }
-            return result;
-        }
+                    case funDiv:
+                        result = params[0].ToNumber() / params[1].ToNumber();
+                        break;
 
-        case funSub:
-            if (mNumParams > 0)
-            {
-                int result = (int) mParams[0]->Evaluate();
-                for (uint32_t i = 1; i < mNumParams; ++i)
-                {
-                    result -= (int) mParams[i]->Evaluate();
+                    default:
+                        (sp++)->Set(Call((eType) instruction.Arg, params, instruction.Count), vp);
+                        continue;
                 }
-                return result;
+                sp->Type = cType::number;
+                sp->Number = result;
+                sp++;
+                continue;
             }
-            return 0;
-
-        case funMul:
-        {
-            int result = 1;
-            for (uint32_t i = 0; i < mNumParams; ++i)
-            {
-                result *= (int) mParams[i]->Evaluate();
-            }
-            return result;
         }
+    }
 
-        case funDiv:
-            return ((int) mParams[0]->Evaluate() / (int) mParams[1]->Evaluate());
+    cType result = (sp == Slots) ? cType(false)
+                 : (sp[-1].Type == cType::string) ? cType(std::move(*sp[-1].Value)) : sp[-1].ToType();
+    while (vp > Values)
+        (--vp)->~cType();
+    return result;
+}
 
-        case funFontTotalWidth:
-        case funFontTotalHeight:
-        case funFontTotalAscent:
-        case funFontSpaceBetween:
-        case funFontLineHeight:
-            return FunFont(mType, mParams[0]->Evaluate(), "");
+cSkinFunctionCache::cSkinFunctionCache(size_t Limit)
+:   mLimit(Limit),
+    mDepth(0),
+    mHits(0),
+    mMisses(0)
+{
+}
 
-        case funFontTextWidth:
-        case funFontTextHeight:
-            return FunFont(mType, mParams[0]->Evaluate(), mParams[1]->Evaluate());
+cSkinFunctionCache::~cSkinFunctionCache()
+{
+    Clear();
+}
 
-        case funImageWidth:
-        case funImageHeight:
-            return FunImage(mType, mParams[0]->Evaluate());
+void cSkinFunctionCache::Clear(void)
+{
+    std::unordered_map<std::string, tEntry>::iterator it;
+    for (it = mEntries.begin(); it != mEntries.end(); it++)
+    {
+        delete it->second.Function;
+        delete it->second.String;
+    }
+    mEntries.clear();
+    mOrder.clear();
+}
 
-        case funQueryFeature: {
-            int value;
-            if (mSkin->Config().GetDriver()->GetFeature((const std::string)(mParams[0]->Evaluate()), value)) {
-                return (value) ? true : false;
-            } else {
-                return false;
-            }
+void cSkinFunctionCache::Trim(void)
+{
+    // entries must not be dropped while they may still be evaluated further up the stack
+    if (mDepth > 0)
+        return;
+
+    while (mLimit > 0 && mEntries.size() >= mLimit && !mOrder.empty())
+    {
+        std::unordered_map<std::string, tEntry>::iterator it = mEntries.find(mOrder.front());
+        if (it != mEntries.end())
+        {
+            delete it->second.Function;
+            delete it->second.String;
+            mEntries.erase(it);
         }
+        mOrder.pop_front();
+    }
+}
 
-        default:
-            //Dprintf("unknown function code\n");
-            syslog(LOG_ERR, "ERROR: graphlcd/skin/function: Unknown function code called (this shouldn't happen)");
-            break;
+const cSkinFunctionCache::tEntry & cSkinFunctionCache::Lookup(cSkinObject * Object, const std::string & Key,
+                                                              const std::string & Text, bool Function)
+{
+    std::unordered_map<std::string, tEntry>::iterator it = mEntries.find(Key);
+    if (it != mEntries.end())
+    {
+        mHits++;
+        return it->second;
     }
-    return false;
+
+    mMisses++;
+    Trim();
+
+    tEntry entry;
+    entry.Function = NULL;
+    entry.String = NULL;
+    if (Function)
+    {
+        entry.Function = new cSkinFunction(Object);
+        if (!entry.Function->Parse(Text, true))
+        {
+            delete entry.Function;
+            entry.Function = NULL;
+        }
+    }
+    else
+    {
+        entry.String = new cSkinString(Object, false);
+        if (!entry.String->Parse(Text))
+        {
+            delete entry.String;
+            entry.String = NULL;
+        }
+    }
+    mOrder.push_back(Key);
+    return mEntries[Key] = entry;
+}
+
+bool cSkinFunctionCache::EvaluateFunction(cSkinObject * Object, const std::string & Text, cType & Result)
+{
+    const tEntry & entry = Lookup(Object, "f" + Text, Text, true);
+    if (!entry.Function)
+        return false;
+
+    mDepth++;
+    Result = entry.Function->Evaluate();
+    mDepth--;
+    return true;
+}
+
+bool cSkinFunctionCache::EvaluateString(cSkinObject * Object, const std::string & Text, cType & Result)
+{
+    const tEntry & entry = Lookup(Object, "s" + Text, Text, false);
+    if (!entry.String)
+        return false;
+
+    mDepth++;
+    Result = entry.String->Evaluate();
+    mDepth--;
+    return true;
 }
 
 } // end of namespace
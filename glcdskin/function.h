@@ -16,6 +16,9 @@
 #include <stdint.h>
 
 #include <string>
+#include <vector>
+#include <deque>
+#include <unordered_map>
 
 #include "type.h"
 #include "string.h"
@@ -77,14 +80,43 @@ public:
     };
 
 private:
+    // the function is compiled into code for a small stack machine: operands are pushed,
+    // a function call replaces its parameters on the stack by its result.
+    // numbers and booleans are stored directly in the stack slots, only strings need a cType
+    enum eOpCode
+    {
+        opString,       // push mStrings[Arg] (Arg < 0: empty string)
+        opNumber,       // push Arg
+        opVariable,     // push value of variable mVariables[Arg]
+        opBool,         // push Arg != 0
+        opJump,         // continue at Arg
+        opJumpIfFalse,  // pop, continue at Arg if false
+        opJumpIfTrue,   // pop, continue at Arg if true
+        opCall          // call function Arg with Count parameters
+    };
+
+    struct tInstruction
+    {
+        uint16_t Op;
+        uint16_t Count;
+        int32_t  Arg;
+    };
+
     cSkinObject   * mObject;
     cSkin         * mSkin;
-    eType           mType;
-    cSkinString     mString;
-    int             mNumber;
-    std::string     mVariableId;
-    cSkinFunction * mParams[MAXPARAMETERS];
-    uint32_t        mNumParams;
+    std::vector<tInstruction> mCode;
+    std::vector<cSkinString>  mStrings;
+    std::vector<tSkinVariableRef> mVariables;
+
+    // typed stack slot of a running evaluation
+    struct tSlot;
+
+    bool Compile(const std::string &Text, bool reparse);
+    size_t Emit(eOpCode Op, int Arg = 0, int Count = 0);
+    cType Operand(const tInstruction &Instruction) const;
+    cType Run(void) const;
+    cType Run(tSlot *Slots, cType *Values) const;
+    cType Call(eType Function, const tSlot *Params, int Count) const;
 
 protected:
     cType FunFile  (const cType &Param) const;
@@ -103,11 +135,51 @@ public:
     void SetListIndex(int MaxItems, int Index);
 };
 
+// cache for the parsed forms of texts that are only known at evaluation time
+// (strings after token substitution, variable values, alternative texts, ...)
+class cSkinFunctionCache
+{
+private:
+    struct tEntry
+    {
+        cSkinFunction * Function;   // NULL if the text is no valid function
+        cSkinString   * String;     // NULL if the text is no valid string
+    };
+
+    std::unordered_map<std::string, tEntry> mEntries;
+    std::deque<std::string> mOrder;  // insertion order, for eviction
+    size_t   mLimit;
+    int      mDepth;                 // nesting level of running evaluations
+    uint64_t mHits;
+    uint64_t mMisses;
+
+    const tEntry & Lookup(cSkinObject * Object, const std::string & Key, const std::string & Text, bool Function);
+    void Trim(void);
+
+public:
+    // Limit: max. number of cached texts (0 == unlimited)
+    cSkinFunctionCache(size_t Limit);
+    ~cSkinFunctionCache();
+
+    // parse Text as function / string (or reuse an earlier parse) and evaluate it.
+    // false if Text could not be parsed.
+    bool EvaluateFunction(cSkinObject * Object, const std::string & Text, cType & Result);
+    bool EvaluateString(cSkinObject * Object, const std::string & Text, cType & Result);
+
+    void Clear(void);
+
+    size_t Size(void) const { return mEntries.size(); }
+    size_t Limit(void) const { return mLimit; }
+    uint64_t Hits(void) const { return mHits; }
+    uint64_t Misses(void) const { return mMisses; }
+    // hit rate in percent
+    int HitRate(void) const { return (mHits + mMisses) ? (int) (mHits * 100 / (mHits + mMisses)) : 0; }
+};
+
 inline void cSkinFunction::SetListIndex(int MaxItems, int Index)
 {
-    mString.SetListIndex(MaxItems, Index);
-    for (uint32_t i = 0; i < mNumParams; i++)
-        mParams[i]->SetListIndex(MaxItems, Index);
+    for (uint32_t i = 0; i < mStrings.size(); i++)
+        mStrings[i].SetListIndex(MaxItems, Index);
 }
 
 } // end of namespace
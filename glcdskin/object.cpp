@@ -77,7 +77,11 @@ cSkinObject::cSkinObject(cSkinDisplay * Parent)
     mAction(""),                    // action (e.g. touchscreen action)
     mMultilineScrollPosition(0),
     mMultilineRelScroll(this, false),
-    mObjects(NULL)
+    mObjects(NULL),
+    mEvalCount(0),
+    mVisible(false),
+    mNextText(""),
+    mRenderCount(0)
 {
     mColor.SetColor(Parent->Skin()->Config().GetDriver()->GetForegroundColor());
     mBackgroundColor.SetColor(Parent->Skin()->Config().GetDriver()->GetBackgroundColor());
@@ -132,7 +136,11 @@ cSkinObject::cSkinObject(const cSkinObject & Src)
     mAction(Src.mAction),
     mMultilineScrollPosition(Src.mMultilineScrollPosition),
     mMultilineRelScroll(Src.mMultilineRelScroll),
-    mObjects(NULL)
+    mObjects(NULL),
+    mEvalCount(0),
+    mVisible(false),
+    mNextText(""),
+    mRenderCount(0)
 {
     if (Src.mObjects)
         mObjects = new cSkinObjects(*Src.mObjects);
@@ -449,6 +457,9 @@ void cSkinObject::Render(GLCD::cBitmap * screen)
                 mChangeDelay = -1;
             }
 
+            // evaluated before the image is fetched: evaluations may use the image cache too
+            tPoint pos = Pos();
+            tSize size = Size();
             uint16_t scalew = 0;
             uint16_t scaleh = 0;
             
@@ -462,27 +473,27 @@ void cSkinObject::Render(GLCD::cBitmap * screen)
                         if (image) {
                             w_temp = image->Width();
                             h_temp = image->Height();
-                            if (w_temp != Size().w || h_temp != Size().h) {
-                                double fw = (double)Size().w / (double)w_temp;
-                                double fh = (double)Size().h / (double)h_temp;
+                            if (w_temp != size.w || h_temp != size.h) {
+                                double fw = (double)size.w / (double)w_temp;
+                                double fh = (double)size.h / (double)h_temp;
                                 if (fw < fh) {
-                                    scalew = Size().w;
+                                    scalew = size.w;
                                 } else {
-                                    scaleh = Size().h;
+                                    scaleh = size.h;
                                 }
                             }
                         }
                     }
                     break;
                 case tscAutoX:
-                    scalew = Size().w;
+                    scalew = size.w;
                     break;
                 case tscAutoY:
-                    scaleh = Size().h;
+                    scaleh = size.h;
                     break;
                 case tscFill:
-                    scalew = Size().w;
-                    scaleh = Size().h;
+                    scalew = size.w;
+                    scaleh = size.h;
                     break;
                 default:
                     scalew = 0;
@@ -501,17 +512,17 @@ void cSkinObject::Render(GLCD::cBitmap * screen)
                     uint16_t xoff = 0;
                     uint16_t yoff = 0;
                     if (scalew || scaleh) {
-                        if (image->Width() < (uint16_t)Size().w) {
-                            xoff = (Size().w - image->Width() ) / 2;
-                        } else if (image->Height() < (uint16_t)Size().h) {
-                            yoff = (Size().h - image->Height() ) / 2;
+                        if (image->Width() < (uint16_t)size.w) {
+                            xoff = (size.w - image->Width() ) / 2;
+                        } else if (image->Height() < (uint16_t)size.h) {
+                            yoff = (size.h - image->Height() ) / 2;
                         }
                     }
 
                     if (mColor == cColor::ERRCOL)
-                        screen->DrawBitmap(Pos().x + xoff, Pos().y + yoff, *bitmap);
+                        screen->DrawBitmap(pos.x + xoff, pos.y + yoff, *bitmap);
                     else
-                        screen->DrawBitmap(Pos().x + xoff, Pos().y + yoff, *bitmap, mColor, mBackgroundColor, mOpacity);
+                        screen->DrawBitmap(pos.x + xoff, pos.y + yoff, *bitmap, mColor, mBackgroundColor, mOpacity);
                 }
 
                 if (mScrollLoopMode != -1)  // if == -1: currScrollLoopMode already contains correct value
@@ -722,19 +733,19 @@ void cSkinObject::Render(GLCD::cBitmap * screen)
             tokenid = mSkin->Config().GetTokenId("ScrollMode");
             if (tokenid >= 0) {
                 token = tSkinToken(tokenid, "ScrollMode", 0, "");
-                cType t = mSkin->Config().GetToken(token);
+                cType t = mSkin->GetToken(token);
                 currScrollLoopMode = (int)(t);
             }
             tokenid = mSkin->Config().GetTokenId("ScrollSpeed");
             if (tokenid >= 0) {
                 token = tSkinToken(tokenid, "ScrollSpeed", 0, "");
-                cType t = mSkin->Config().GetToken(token);
+                cType t = mSkin->GetToken(token);
                 currScrollSpeed = (int)(t);
             }
             tokenid = mSkin->Config().GetTokenId("ScrollTime");
             if (tokenid >= 0) {
                 token = tSkinToken(tokenid, "ScrollTime", 0, "");
-                cType t = mSkin->Config().GetToken(token);
+                cType t = mSkin->GetToken(token);
                 currScrollTime = (int)(t);
             }
 
@@ -785,12 +796,10 @@ void cSkinObject::Render(GLCD::cBitmap * screen)
 
                 // is an alternative text defined + alternative condition defined and true?
                 if (mAltCondition != NULL && mAltCondition->Evaluate() && (mAltText.size() != 0)) {
-                    cSkinString *result = new cSkinString(this, false);
-
-                    if (result->Parse(mAltText)) {
-                        text = (std::string) result->Evaluate();
+                    cType result;
+                    if (mSkin->FunctionCache()->EvaluateString(this, mAltText, result)) {
+                        text = (std::string) result;
                     }
-                    delete result;
                 } else { // nope: use the original text
                     text = (std::string) mText.Evaluate();
                 }
@@ -1103,7 +1112,42 @@ void cSkinObject::Render(GLCD::cBitmap * screen)
 
 bool cSkinObject::NeedsUpdate(uint64_t CurrentTime)
 {
-    if (mCondition != NULL && !mCondition->Evaluate())
+    cSkinConfig & config = mSkin->Config();
+
+    // with token tracking the condition and the text only have to be evaluated again
+    // if one of the tokens they were read from has changed
+    bool evaluate = !config.TokenTracking() || config.ChangedSince(mDependencies, mEvalCount);
+    tSkinDependencies * recorder = NULL;
+    if (evaluate && config.TokenTracking())
+    {
+        mDependencies.Clear();
+        recorder = mSkin->SetRecorder(&mDependencies);
+    }
+
+    if (evaluate)
+        mVisible = (mCondition == NULL || mCondition->Evaluate());
+
+    if (evaluate && mVisible && (Type() == cSkinObject::text || Type() == cSkinObject::scrolltext))
+    {
+        // is an alternative text defined + alternative condition defined and true?
+        if (mAltCondition != NULL && mAltCondition->Evaluate() && (mAltText.size() != 0)) {
+            cType result;
+            mNextText = "";
+            if (mSkin->FunctionCache()->EvaluateString(this, mAltText, result)) {
+                mNextText = (std::string) result;
+            }
+        } else { // nope: use the original text
+            mNextText = (std::string) mText.Evaluate();
+        }
+    }
+
+    if (evaluate && config.TokenTracking())
+    {
+        mSkin->SetRecorder(recorder);
+        mEvalCount = config.ChangeCount();
+    }
+
+    if (!mVisible)
         return false;
 
     switch (Type())
@@ -1131,33 +1175,19 @@ bool cSkinObject::NeedsUpdate(uint64_t CurrentTime)
             int currScrollLoopMode = 1; // default values if no setup default values available
             int currScrollTime = 500;
 
-            std::string text = "";
-
-            // is an alternative text defined + alternative condition defined and true?
-            if (mAltCondition != NULL && mAltCondition->Evaluate() && (mAltText.size() != 0)) {
-                cSkinString *result = new cSkinString(this, false);
-
-                if (result->Parse(mAltText)) {
-                    text = (std::string) result->Evaluate();
-                }
-                delete result;
-            } else { // nope: use the original text
-                text = (std::string) mText.Evaluate();
-            }
-
             // get default values from derived config-class if available
             int tokenid;
             tSkinToken token;
             tokenid = mSkin->Config().GetTokenId("ScrollMode");
             if (tokenid >= 0) {
                 token = tSkinToken(tokenid, "ScrollMode", 0, "");
-                cType t = mSkin->Config().GetToken(token);
+                cType t = mSkin->GetToken(token);
                 currScrollLoopMode = (int)(t);
             }
             tokenid = mSkin->Config().GetTokenId("ScrollTime");
             if (tokenid >= 0) {
                 token = tSkinToken(tokenid, "ScrollTime", 0, "");
-                cType t = mSkin->Config().GetToken(token);
+                cType t = mSkin->GetToken(token);
                 currScrollTime = (int)(t);
             }
 
@@ -1167,7 +1197,7 @@ bool cSkinObject::NeedsUpdate(uint64_t CurrentTime)
             if (mScrollTime > 0)
                 currScrollTime = mScrollTime;
 
-            if ( (text != mCurrText) || 
+            if ( (mNextText != mCurrText) || 
                  ( (currScrollLoopMode > 0) && (!mScrollLoopReached || mScrollOffset) && 
                    ((uint32_t)(CurrentTime-mLastChange) >= (uint32_t)currScrollTime)
                  )
@@ -1197,6 +1227,35 @@ bool cSkinObject::NeedsUpdate(uint64_t CurrentTime)
     return false;
 }
 
+void cSkinObject::RenderTracked(cBitmap * screen)
+{
+    // the damage of the screen tells the area the object changed
+    std::vector<tRect> damage = screen->Damage();
+    screen->ResetDamage();
+
+    mRenderDependencies.Clear();
+    tSkinDependencies * recorder = mSkin->SetRecorder(&mRenderDependencies);
+    Render(screen);
+    mSkin->SetRecorder(recorder);
+    mRenderCount = mSkin->Config().ChangeCount();
+
+    std::vector<tRect> drawn = screen->Damage();
+    mRenderArea = tRect();
+    screen->SetDamage(damage);
+    for (size_t i = 0; i < drawn.size(); i++)
+    {
+        mRenderArea.Unite(drawn[i]);
+        screen->AddDamage(drawn[i].x1, drawn[i].y1, drawn[i].x2, drawn[i].y2);
+    }
+}
+
+bool cSkinObject::NeedsRedraw(uint64_t CurrentTime)
+{
+    // NeedsUpdate() also evaluates a changed condition and text again
+    bool update = NeedsUpdate(CurrentTime);
+    return update || mRenderCount == 0 || mSkin->Config().ChangedSince(mRenderDependencies, mRenderCount);
+}
+
 
 std::string cSkinObject::CheckAction(cGLCDEvent * ev)
 {
@@ -193,6 +193,17 @@ private:
 
     cSkinObjects * mObjects;        // used for block objects such as <list>
 
+    // state of the last evaluation in NeedsUpdate() (only used with token tracking)
+    tSkinDependencies mDependencies;// tokens read by the condition and text
+    uint64_t mEvalCount;            // change count of the config at the evaluation
+    bool mVisible;                  // result of the condition
+    std::string mNextText;          // evaluated text
+
+    // state of the last drawing by RenderTracked() (only used with token tracking)
+    tSkinDependencies mRenderDependencies;  // tokens read while drawing
+    uint64_t mRenderCount;          // change count of the config at the drawing, 0: not drawn
+    tRect mRenderArea;              // area changed by the drawing
+
 public:
     cSkinObject(cSkinDisplay * parent);
     cSkinObject(const cSkinObject & Src);
@@ -237,6 +248,12 @@ public:
     // false: no update required, true: update required
     bool NeedsUpdate(uint64_t CurrentTime);
 
+    // with token tracking: Render() recording the tokens the drawing depends on and the area it changed.
+    // NeedsRedraw() is true if one of these tokens changed or NeedsUpdate() is
+    void RenderTracked(cBitmap * screen);
+    bool NeedsRedraw(uint64_t CurrentTime);
+    const tRect & RenderArea(void) const { return mRenderArea; }
+
     std::string CheckAction(cGLCDEvent * ev);
 };
 
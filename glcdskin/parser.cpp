@@ -444,16 +444,16 @@ bool EndElem(const std::string & name)
     {
         if (name == "font")
         {
-            skin->fonts.push_back(font);
+            skin->AddFont(font);
             font = NULL;
         }
         else if (name == "variable")
         {
-            skin->mVariables.push_back(variable);
+            skin->AddVariable(variable);
 //fprintf(stderr, "  variable         '%s', value: %s\n", variable->mId.c_str(), ((std::string)variable->Value()).c_str());
             variable = NULL;
             if (variable_default != NULL) {
-              skin->mVariables.push_back(variable_default);
+              skin->AddVariable(variable_default);
 //fprintf(stderr, "  variable default '%s', value: %s\n", variable_default->mId.c_str(), ((std::string)variable_default->Value()).c_str());
               variable_default = NULL;
             }
@@ -461,7 +461,7 @@ bool EndElem(const std::string & name)
         else if (name == "display")
         {
             //display->mNumMarquees = mindex;
-            skin->displays.push_back(display);
+            skin->AddDisplay(display);
             display = NULL;
             oindex = 0;
         }
@@ -16,17 +16,23 @@
 namespace GLCD
 {
 
+// default memory budget of the image cache
+static const size_t kImageCacheBudget = 8 * 1024 * 1024;
+
 cSkin::cSkin(cSkinConfig & Config, const std::string & Name)
 :   config(Config),
     name(Name)
 {
-    mImageCache = new cImageCache(this, 100);
+    mImageCache = new cImageCache(this, kImageCacheBudget);
+    mFunctionCache = new cSkinFunctionCache(256);
     tsEvalTick = 0;
     tsEvalSwitch = 0;
+    mRecorder = NULL;
 }
 
 cSkin::~cSkin(void)
 {
+    delete mFunctionCache;
     delete mImageCache;
 }
 
@@ -36,50 +42,81 @@ void cSkin::SetBaseSize(int width, int height)
     baseSize.h = height;
 }
 
+void cSkin::AddFont(cSkinFont * Font)
+{
+    fonts.push_back(Font);
+    mFontIndex[Font->Id()].push_back(Font);
+}
+
+void cSkin::AddDisplay(cSkinDisplay * Display)
+{
+    displays.push_back(Display);
+    // the first display with an id is used
+    mDisplayIndex.insert(std::make_pair(Display->Id(), Display));
+}
+
+void cSkin::AddVariable(cSkinVariable * Variable)
+{
+    mVariables.push_back(Variable);
+    mVariableIndex[Variable->Id()].push_back(Variable);
+}
+
 cSkinFont * cSkin::GetFont(const std::string & Id)
 {
-    cSkinFonts::iterator it = fonts.begin();
-    while (it != fonts.end())
+    std::unordered_map<std::string, std::vector<cSkinFont *> >::const_iterator it = mFontIndex.find(Id);
+    if (it == mFontIndex.end())
+        return NULL;
+
+    const std::vector<cSkinFont *> & candidates = it->second;
+    for (size_t i = 0; i < candidates.size(); i++)
     {
-        if ((*it)->Id() == Id)
-        {
-            if ((*it)->Condition() == NULL || (*it)->Condition()->Evaluate())
-                return (*it);
-        }
-        it++;
+        if (candidates[i]->Condition() == NULL || candidates[i]->Condition()->Evaluate())
+            return candidates[i];
     }
     return NULL;
 }
 
 cSkinDisplay * cSkin::GetDisplay(const std::string & Id)
 {
-    cSkinDisplays::iterator it = displays.begin();
-    while (it != displays.end())
-    {
-        if ((*it)->Id() == Id)
-        {
-            return (*it);
-        }
-        it++;
-    }
-    return NULL;
+    std::unordered_map<std::string, cSkinDisplay *>::const_iterator it = mDisplayIndex.find(Id);
+    return (it != mDisplayIndex.end()) ? it->second : NULL;
 }
 
 cSkinVariable * cSkin::GetVariable(const std::string & Id)
 {
-    cSkinVariables::iterator it = mVariables.begin();
-    while (it != mVariables.end())
+    const std::vector<cSkinVariable *> * candidates = GetVariables(Id);
+    return candidates ? GetVariable(*candidates) : NULL;
+}
+
+const std::vector<cSkinVariable *> * cSkin::GetVariables(const std::string & Id) const
+{
+    std::unordered_map<std::string, std::vector<cSkinVariable *> >::const_iterator it = mVariableIndex.find(Id);
+    return (it != mVariableIndex.end()) ? &it->second : NULL;
+}
+
+cSkinVariable * cSkin::GetVariable(const std::vector<cSkinVariable *> & Candidates)
+{
+    for (size_t i = 0; i < Candidates.size(); i++)
     {
-        if ((*it)->Id() == Id)
-        {
-            if ((*it)->Condition() == NULL || (*it)->Condition()->Evaluate())
-                return (*it);
-        }
-        it++;
+        if (Candidates[i]->Condition() == NULL || Candidates[i]->Condition()->Evaluate())
+            return Candidates[i];
     }
     return NULL;
 }
 
+cType cSkin::GetToken(const tSkinToken & Token)
+{
+    if (mRecorder)
+        mRecorder->Add(Token.Id);
+    return config.GetToken(Token);
+}
+
+tSkinDependencies * cSkin::SetRecorder(tSkinDependencies * Recorder)
+{
+    tSkinDependencies * previous = mRecorder;
+    mRecorder = Recorder;
+    return previous;
+}
 
 bool cSkin::ParseEnable(const std::string & Text)
 {
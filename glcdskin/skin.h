@@ -14,6 +14,8 @@
 #define _GLCDSKIN_SKIN_H_
 
 #include <string>
+#include <vector>
+#include <unordered_map>
 
 #include "display.h"
 #include "font.h"
@@ -43,8 +45,15 @@ private:
     cSkinDisplays displays;
     cSkinVariables mVariables;
     cImageCache * mImageCache;
+    cSkinFunctionCache * mFunctionCache;
     uint64_t  tsEvalTick;
     uint64_t  tsEvalSwitch;
+    tSkinDependencies * mRecorder;  // collects the tokens read by the running evaluation
+
+    // entries by id in declaration order (conditional fonts and variables may share an id)
+    std::unordered_map<std::string, std::vector<cSkinFont *> > mFontIndex;
+    std::unordered_map<std::string, cSkinDisplay *> mDisplayIndex;
+    std::unordered_map<std::string, std::vector<cSkinVariable *> > mVariableIndex;
 
 public:
     cSkin(cSkinConfig & Config, const std::string & Name);
@@ -52,10 +61,23 @@ public:
 
     void SetBaseSize(int width, int height);
 
+    // add entries to the skin (ownership is taken over)
+    void AddFont(cSkinFont * Font);
+    void AddDisplay(cSkinDisplay * Display);
+    void AddVariable(cSkinVariable * Variable);
+
     cSkinFont * GetFont(const std::string & Id);
     cSkinDisplay * GetDisplay(const std::string & Id);
     cSkinVariable * GetVariable(const std::string & Id);
 
+    // candidates for a variable id in declaration order, NULL if there is no variable with this id (yet).
+    // the list stays valid for the lifetime of the skin and includes variables added later on.
+    const std::vector<cSkinVariable *> * GetVariables(const std::string & Id) const;
+    // first candidate whose condition is met
+    cSkinVariable * GetVariable(const std::vector<cSkinVariable *> & Candidates);
+    cSkinVariable * GetVariable(const tSkinVariableRef & Ref)
+    { return Ref.Candidates ? GetVariable(*Ref.Candidates) : GetVariable(Ref.Id); }
+
     cSkinConfig & Config(void) { return config; }
     const std::string & Name(void) const { return name; }
     const std::string & Title(void) const { return title; }
@@ -63,9 +85,20 @@ public:
     const tSize & BaseSize(void) const { return baseSize; }
 
     cImageCache * ImageCache(void) { return mImageCache; }
+    cSkinFunctionCache * FunctionCache(void) { return mFunctionCache; }
 
     bool ParseEnable(const std::string &Text);
 
+    // read a token and record it as dependency of the running evaluation
+    cType GetToken(const tSkinToken & Token);
+
+    // let Recorder collect the dependencies of the following evaluations (NULL: stop recording),
+    // returns the previous recorder
+    tSkinDependencies * SetRecorder(tSkinDependencies * Recorder);
+    void Record(const tSkinDependencies & Dependencies) { if (mRecorder) mRecorder->Add(Dependencies); }
+    // the running evaluation read state that is not a token
+    void RecordVolatile(void) { if (mRecorder) mRecorder->Volatile = true; }
+
     cColor GetBackgroundColor(void) { return config.GetDriver()->GetBackgroundColor(); }
     cColor GetForegroundColor(void) { return config.GetDriver()->GetForegroundColor(); }
     
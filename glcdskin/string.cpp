@@ -34,6 +34,13 @@ tSkinToken::tSkinToken(int id, std::string n, uint32_t o, const std::string & a)
 {
 }
 
+tSkinVariableRef::tSkinVariableRef(cSkin * Skin, const std::string & id, uint32_t o)
+:   Id(id),
+    Candidates(Skin ? Skin->GetVariables(id) : NULL),
+    Offset(o)
+{
+}
+
 bool operator< (const tSkinToken & A, const tSkinToken & B)
 {
     return A.Id == B.Id
@@ -112,6 +119,7 @@ bool cSkinString::Parse(const std::string & Text, bool Translate)
     mOriginal = Text;
     mText = "";
     mTokens.clear();
+    mVariables.clear();
 
     ptr = trans.c_str();
     last = trans.c_str();
@@ -135,12 +143,14 @@ bool cSkinString::Parse(const std::string & Text, bool Translate)
 
           bool isStartChar = true;
           const char * varNameStart = ptr;
+          int varOffset = offset;
           ptr++;
           while (*ptr && IsTokenChar(isStartChar, *ptr)) {
             isStartChar = false;
             ptr++;
             offset++;
           }
+          mVariables.push_back(tSkinVariableRef(mSkin, std::string(varNameStart + 1, ptr - varNameStart - 1), varOffset));
           // add #VARNAME#
           mText.append(varNameStart, (ptr - varNameStart));
           mText.append("#");
@@ -245,68 +255,56 @@ bool cSkinString::Parse(const std::string & Text, bool Translate)
 cType cSkinString::Evaluate(void) const
 {
     if (mText.length() == 0 && mTokens.size() == 1)
-        return mSkin->Config().GetToken(mTokens[0]);
+        return mSkin->GetToken(mTokens[0]);
 
-    std::string result_raw = "";
-    int offset = 0;
-    for (uint32_t i = 0; i < mTokens.size(); i++) {
-        result_raw.append(mText.substr(offset, mTokens[i].Offset - offset) );
-        result_raw.append(mSkin->Config().GetToken(mTokens[i]));
-        offset = mTokens[i].Offset;
-    }
-    result_raw.append(mText.c_str() + offset);
-
-    // replace variable placeholders (#VARNAME#) with corresponding values
+    // substitute tokens and variable placeholders (#VARNAME#) in the order of their positions
     std::string result_trans = "";
-    size_t idxstart = 0, idxend = 0;
-    size_t pos = 0;
-    while ( (idxstart=result_raw.find("#", idxstart)) != std::string::npos ) {
-      result_trans.append(result_raw.substr(pos, idxstart-pos));
-      idxend = result_raw.find("#", idxstart+1);
-      if (idxend != std::string::npos) {
-        cSkinVariable * variable = mSkin->GetVariable(result_raw.substr(idxstart+1, idxend-idxstart-1));
+    uint32_t offset = 0;
+    size_t token = 0, var = 0;
+    while (token < mTokens.size() || var < mVariables.size()) {
+      if (var == mVariables.size() || (token < mTokens.size() && mTokens[token].Offset <= mVariables[var].Offset)) {
+        result_trans.append(mText, offset, mTokens[token].Offset - offset);
+        result_trans.append(mSkin->GetToken(mTokens[token]));
+        offset = mTokens[token].Offset;
+        token++;
+      } else {
+        const tSkinVariableRef & ref = mVariables[var++];
+        result_trans.append(mText, offset, ref.Offset - offset);
+        offset = ref.Offset + ref.Id.length() + 2;
+        cSkinVariable * variable = mSkin->GetVariable(ref);
         if (variable) {
           std::string val = (std::string) variable->Value();
 
           // if value of variable contains token definions: reparse value
           if (val.find("{") != std::string::npos) {
-            cSkinString *result = new cSkinString(Object(), false);
-            if (result->Parse(val)) {
-              val = (std::string) result->Evaluate();
+            cType result;
+            if (mSkin->FunctionCache()->EvaluateString(Object(), val, result)) {
+              val = (std::string) result;
             }
-            delete result;
           }
           result_trans.append (val);
-          //   syslog(LOG_ERR, "string variable %s", trans.c_str());
         } else {
-          result_trans.append (result_raw.substr(idxstart, idxend-idxstart)); // no variable found: print as raw text
+          result_trans.append ("#" + ref.Id); // no variable found: print as raw text
         }
-        idxstart = idxend+1;
-        pos = idxstart;
-      } else {
-        result_trans.append ("#");  // no closing '#' -> print # as raw text
-        idxstart ++;
-        pos = idxstart;
       }
     }
-    result_trans.append(result_raw.substr(pos));
+    result_trans.append(mText, offset, std::string::npos);
 
     // re-evaluate resulting string
     if ((mText.size() > 0) && mText[0] != '#' && mObject != NULL ) {
-        cSkinFunction *result = new cSkinFunction(mObject);
-        if (result->Parse(result_trans, true))  {
-            std::string result_rescan = (std::string)result->Evaluate();
+        cType result;
+        if (mSkin->FunctionCache()->EvaluateFunction(mObject, result_trans, result))  {
+            std::string result_rescan = (std::string)result;
             if (result_rescan != "")
                 result_trans = result_rescan;            
         }
-        delete result;
     }
 
     // look for $(..)$-expressions
-    result_raw = result_trans;
+    std::string result_raw = result_trans;
     result_trans = "";
-    idxstart = 0;
-    pos = 0;
+    size_t idxstart = 0, idxend = 0;
+    size_t pos = 0;
     bool err = false;
     while ( !err && ((idxstart = result_raw.find("$(", idxstart)) != std::string::npos) ) {
       result_trans.append (result_raw.substr(pos, idxstart - pos) );
@@ -316,13 +314,12 @@ cType cSkinString::Evaluate(void) const
         err = true;
       } else {
         std::string func = result_raw.substr( idxstart + 2, idxend - idxstart - 2 );
-        cSkinFunction *result = new cSkinFunction(mObject);
-        if (result->Parse(func, true))  {
-            std::string result_rescan = (std::string)result->Evaluate();
+        cType result;
+        if (mSkin->FunctionCache()->EvaluateFunction(mObject, func, result))  {
+            std::string result_rescan = (std::string)result;
             if (result_rescan != "")
                 result_trans.append( result_rescan );
         }
-        delete result;
         
         idxstart = idxend + 2;
         pos = idxstart;
@@ -15,6 +15,7 @@
 
 #include <string>
 #include <vector>
+#include <set>
 
 #include "type.h"
 
@@ -80,8 +81,33 @@ struct tSkinToken
     static std::string Token(const tSkinToken & Token);
 };
 
+// ids of the tokens an evaluation has read, including the tokens read by the
+// variables it used. Volatile is set if it also read state that is not a token
+// (driver features, files, timed variables), it has to be evaluated every time then.
+struct tSkinDependencies
+{
+    std::set<int> Tokens;
+    bool Volatile;
+
+    tSkinDependencies(void) : Volatile(false) {}
+    void Add(int Id) { Tokens.insert(Id); }
+    void Add(const tSkinDependencies & Src) { Tokens.insert(Src.Tokens.begin(), Src.Tokens.end()); Volatile |= Src.Volatile; }
+    void Clear(void) { Tokens.clear(); Volatile = false; }
+};
+
 class cSkinObject;
 class cSkin;
+class cSkinVariable;
+
+// reference to a skin variable, resolved when parsing if the variable is already declared
+struct tSkinVariableRef
+{
+    std::string Id;
+    const std::vector<cSkinVariable *> * Candidates;  // NULL: look up by id
+    uint32_t    Offset;                               // position of #Id# in the text of a cSkinString
+
+    tSkinVariableRef(cSkin * Skin, const std::string & id, uint32_t o = 0);
+};
 
 class cSkinString
 {
@@ -96,6 +122,7 @@ private:
     std::string             mText;
     std::string             mOriginal;
     std::vector<tSkinToken> mTokens;
+    std::vector<tSkinVariableRef> mVariables;
     bool                    mTranslate;
 
 public:
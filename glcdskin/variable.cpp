@@ -107,11 +107,25 @@ const cType & cSkinVariable::Value(void)
          )
        )
     {
+        mSkin->Record(mDependencies);
         return mValue;
     }
 
     if (mFunction != NULL) {
-        mValue = mFunction->Evaluate();
+        if (mSkin->Config().TokenTracking()) {
+            // the stored value is used by evaluations until the next update,
+            // so the dependencies are kept for them
+            tSkinDependencies * recorder = mSkin->SetRecorder(&mDependencies);
+            mDependencies.Clear();
+            mValue = mFunction->Evaluate();
+            mSkin->SetRecorder(recorder);
+            // a value kept for an interval can change without a token changing
+            if (mEvalMode == tevmInterval)
+                mDependencies.Volatile = true;
+            mSkin->Record(mDependencies);
+        } else {
+            mValue = mFunction->Evaluate();
+        }
         // should've been solved in ParseValue already, just to be sure ...
         if (mEvalMode == tevmOnce) {
             delete mFunction;
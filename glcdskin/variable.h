@@ -51,6 +51,7 @@ private:
     eEvalMode mEvalMode;
     int mEvalInterval;
     uint64_t mTimestamp;
+    tSkinDependencies mDependencies;    // tokens read by the last evaluation of mFunction
 
 public:
     cSkinVariable(cSkin * Parent);
@@ -0,0 +1,194 @@
+/*
+ * GraphLCD tool convbench
+ *
+ * convbench.c  -  micro benchmark of the colour conversion functions
+ *                 of the driver library
+ *
+ * This file is released under the GNU General Public License. Refer
+ * to the COPYING file distributed with this package.
+ */
+
+//-----------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <time.h>
+
+#include <algorithm>
+#include <vector>
+
+#include <glcddrivers/colorconv.h>
+
+//-----------------------------------------------------------------------------
+static const char *prgname = "convbench";
+static const char *version = "0.1.0";
+
+static const int kDefaultWidth = 320;
+static const int kDefaultHeight = 240;
+static const int kDefaultFrames = 500;
+
+static const char * kInstructionSets[] = { "c", "sse2", "avx2", "neon" };
+
+enum eFormat
+{
+    fmtRGB565,
+    fmtRGB888,
+    fmtMono,
+    fmtGrey4,
+    fmtCount
+};
+
+static const char * kFormatNames[fmtCount] = { "rgb565", "rgb888", "mono", "grey4" };
+
+//-----------------------------------------------------------------------------
+void usage()
+{
+    fprintf(stdout, "\n");
+    fprintf(stdout, "%s v%s\n", prgname, version);
+    fprintf(stdout, "%s measures the colour conversion of the driver library.\n", prgname);
+    fprintf(stdout, "\n");
+    fprintf(stdout, "  Usage: %s [-x WIDTH] [-y HEIGHT] [-n FRAMES] [-ui]\n\n", prgname);
+    fprintf(stdout, "  -x  --width       width of a frame (default: %d)\n", kDefaultWidth);
+    fprintf(stdout, "  -y  --height      height of a frame (default: %d)\n", kDefaultHeight);
+    fprintf(stdout, "  -n  --frames      number of frames converted per run (default: %d)\n", kDefaultFrames);
+    fprintf(stdout, "  -u  --upsidedown  rotate the frames by 180 degrees\n");
+    fprintf(stdout, "  -i  --invert      invert the colours\n");
+    fprintf(stdout, "\n" );
+    fprintf(stdout, "  example: %s -x 256 -y 64 -n 10000\n", prgname);
+    fprintf(stdout, "\n" );
+} // usage()
+
+//-----------------------------------------------------------------------------
+static double Now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+} // Now()
+
+//-----------------------------------------------------------------------------
+// converts a frame line by line like a driver does, bottom up if rotated
+static void ConvertFrame(int format, const uint32_t * src, std::vector<uint8_t> & dst, int width, int height, int flags)
+{
+    int lineSize = 0;
+
+    switch (format)
+    {
+        case fmtRGB565: lineSize = width * 2; break;
+        case fmtRGB888: lineSize = width * 3; break;
+        case fmtMono:   lineSize = (width + 7) / 8; break;
+        case fmtGrey4:  lineSize = (width + 1) / 2; break;
+    } // switch
+
+    for (int y = 0; y < height; y++)
+    {
+        const uint32_t * line = src + y * width;
+        uint8_t * out = &dst[((flags & GLCD::kConvReverse) ? height - 1 - y : y) * lineSize];
+
+        switch (format)
+        {
+            case fmtRGB565: GLCD::ConvertRGB565(line, (uint16_t *) out, width, flags); break;
+            case fmtRGB888: GLCD::ConvertRGB888(line, out, width, flags); break;
+            case fmtMono:   GLCD::ConvertMono(line, out, width, 128, flags); break;
+            case fmtGrey4:  GLCD::ConvertGrey4(line, out, width, flags); break;
+        } // switch
+    } // for
+} // ConvertFrame()
+
+//-----------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+    static struct option long_options[] =
+    {
+        {"width",      required_argument, NULL, 'x'},
+        {"height",     required_argument, NULL, 'y'},
+        {"frames",     required_argument, NULL, 'n'},
+        {"upsidedown",       no_argument, NULL, 'u'},
+        {"invert",           no_argument, NULL, 'i'},
+        {NULL}
+    };
+
+    int width = kDefaultWidth;
+    int height = kDefaultHeight;
+    int frames = kDefaultFrames;
+    int flags = 0;
+
+    int c, option_index = 0;
+    while ((c = getopt_long(argc, argv, "x:y:n:ui", long_options, &option_index)) != -1)
+    {
+        switch (c)
+        {
+            case 'x':
+                width = atoi(optarg);
+                break;
+
+            case 'y':
+                height = atoi(optarg);
+                break;
+
+            case 'n':
+                frames = atoi(optarg);
+                break;
+
+            case 'u':
+                flags |= GLCD::kConvReverse;
+                break;
+
+            case 'i':
+                flags |= GLCD::kConvInvert;
+                break;
+
+            default:
+                usage();
+                return 1;
+        } // switch
+    } // while
+
+    if (width <= 0 || height <= 0 || frames <= 0)
+    {
+        usage();
+        return 1;
+    } // if
+
+    // some colourful noise
+    std::vector<uint32_t> src(width * height);
+    unsigned int seed = 1;
+    for (size_t i = 0; i < src.size(); i++)
+        src[i] = 0xFF000000 | (rand_r(&seed) & 0x00FFFFFF);
+
+    std::vector<uint8_t> dst(width * height * 3);
+    std::vector<uint8_t> reference[fmtCount];
+    const char * defaultSet = GLCD::GetConvertInstructionSet();
+
+    fprintf(stdout, "%dx%d, %d frames, default instruction set: %s\n\n", width, height, frames, defaultSet);
+    fprintf(stdout, "%-6s %-8s %10s %10s\n", "set", "format", "Mpixel/s", "ns/frame");
+
+    for (size_t s = 0; s < sizeof(kInstructionSets) / sizeof(kInstructionSets[0]); s++)
+    {
+        if (!GLCD::SetConvertInstructionSet(kInstructionSets[s]))
+            continue;
+
+        for (int format = 0; format < fmtCount; format++)
+        {
+            // warm up, and check the result against the first instruction set
+            std::fill(dst.begin(), dst.end(), 0);
+            ConvertFrame(format, &src[0], dst, width, height, flags);
+            if (reference[format].empty())
+                reference[format] = dst;
+            else if (reference[format] != dst)
+                fprintf(stdout, "%-6s %-8s results differ from %s!\n", kInstructionSets[s], kFormatNames[format], kInstructionSets[0]);
+
+            double start = Now();
+            for (int n = 0; n < frames; n++)
+                ConvertFrame(format, &src[0], dst, width, height, flags);
+            double elapsed = Now() - start;
+
+            fprintf(stdout, "%-6s %-8s %10.1f %10.0f\n", kInstructionSets[s], kFormatNames[format],
+                    (double) width * height * frames / elapsed / 1e6, elapsed / frames * 1e9);
+        } // for
+    } // for
+
+    GLCD::SetConvertInstructionSet(defaultSet);
+    return 0;
+} // main()
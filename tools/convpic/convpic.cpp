@@ -173,11 +173,17 @@ int main(int argc, char *argv[]) {
     }
 
     /* if more than one input image: following images must match width and height of first image */
-    image_w = image.GetBitmap(0)->Width();
-    image_h = image.GetBitmap(0)->Height();
+    if (!bError) {
+      if (!image.GetBitmap(0)) {
+        fprintf(stderr, "ERROR: Failed decoding file %s\n", inFile.c_str());
+        bError = true;
+      } else {
+        image_w = image.GetBitmap(0)->Width();
+        image_h = image.GetBitmap(0)->Height();
+      }
+    }
 
     if (!bError) {
-        GLCD::cImageFile * outImage = NULL;
         // Load more in files
         while (optind < argc && !bError) {
             inFile = argv[optind++];
@@ -185,6 +191,8 @@ int main(int argc, char *argv[]) {
             fprintf(stdout, "loading %s\n", inFile.c_str());
             if (GLCD::cImage::LoadImage(nextImage, inFile) == false) {
               fprintf(stderr, "ERROR: Failed loading file '%s', ignoring it ...\n", inFile.c_str());
+            } else if (!nextImage.GetBitmap(0)) {
+              fprintf(stderr, "ERROR: Failed decoding file '%s', ignoring it ...\n", inFile.c_str());
             } else {
               unsigned int nim_w = nextImage.GetBitmap(0)->Width();
               unsigned int nim_h = nextImage.GetBitmap(0)->Height();
@@ -193,7 +201,13 @@ int main(int argc, char *argv[]) {
               } else {
                 uint16_t i;
                 for (i = 0; i < nextImage.Count(); i++) {
-                    image.AddBitmap(new GLCD::cBitmap(*nextImage.GetBitmap(i)));
+                    const GLCD::cBitmap * frame = nextImage.GetBitmap(i);
+                    if (!frame) {
+                        fprintf(stderr, "ERROR: Failed decoding frame %d of '%s'\n", i, inFile.c_str());
+                        bError = true;
+                        break;
+                    }
+                    image.AddBitmap(new GLCD::cBitmap(*frame));
                 }
               }
             }
@@ -202,10 +216,19 @@ int main(int argc, char *argv[]) {
             image.SetDelay(delay);
         if (bInvert) {
             uint16_t i;
-            for (i = 0; i < image.Count(); i++) {
-                image.GetBitmap(i)->Invert();
+            for (i = 0; i < image.Count() && !bError; i++) {
+                GLCD::cBitmap * frame = image.GetBitmap(i);
+                if (frame) {
+                    frame->Invert();
+                } else {
+                    fprintf(stderr, "ERROR: Failed decoding frame %d\n", i);
+                    bError = true;
+                }
             }
         }
+    }
+    if (!bError) {
+        GLCD::cImageFile * outImage = NULL;
         if (outExtension == "PBM") {
           outImage = new GLCD::cPBMFile();
         } else {
@@ -213,6 +236,7 @@ int main(int argc, char *argv[]) {
         }
         fprintf(stdout, "saving %s\n", outFile.c_str());
         bError = !outImage->Save(image, outFile);
+        delete outImage;
     }
     if (bError) {
         return 4;
@@ -0,0 +1,569 @@
+/*
+ * GraphLCD tool glcdbench
+ *
+ * glcdbench.c  -  render benchmark of skins, fonts and drawing primitives
+ *
+ * This file is released under the GNU General Public License. Refer
+ * to the COPYING file distributed with this package.
+ */
+
+//-----------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <time.h>
+
+#include <map>
+#include <new>
+#include <string>
+#include <vector>
+
+#include <glcdgraphics/bitmap.h>
+#include <glcdgraphics/font.h>
+#include <glcddrivers/config.h>
+#include <glcddrivers/driver.h>
+#include <glcddrivers/loopback.h>
+#include <glcdskin/config.h>
+#include <glcdskin/display.h>
+#include <glcdskin/object.h>
+#include <glcdskin/parser.h>
+#include <glcdskin/skin.h>
+#include <glcdskin/type.h>
+
+//-----------------------------------------------------------------------------
+static const char *prgname = "glcdbench";
+static const char *version = "0.1.0";
+
+static const int kDefaultWidth = 256;
+static const int kDefaultHeight = 64;
+static const int kDefaultFrames = 1000;
+static const int kDefaultFontSize = 12;
+
+static const char * kWorkloads[] = { "fill", "lines", "text", "image", "alpha" };
+static const int kNumWorkloads = sizeof(kWorkloads) / sizeof(kWorkloads[0]);
+
+static const char * kFormatNames[] = { "argb", "mono", "grey4", "rgb565" };
+static const GLCD::ePixelFormat kFormats[] = { GLCD::pfARGB32, GLCD::pfMono, GLCD::pfGrey4, GLCD::pfRGB565 };
+
+//-----------------------------------------------------------------------------
+// allocations done by operator new, counted for the whole program
+
+static uint64_t allocCount = 0;
+static uint64_t allocBytes = 0;
+
+void * operator new(size_t size)
+{
+    allocCount++;
+    allocBytes += size;
+    void * p = malloc(size ? size : 1);
+    if (!p)
+        throw std::bad_alloc();
+    return p;
+}
+
+void * operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+// not inlined: gcc would warn about free() called for memory from operator new
+__attribute__((noinline)) void operator delete(void * p) noexcept { free(p); }
+__attribute__((noinline)) void operator delete[](void * p) noexcept { free(p); }
+__attribute__((noinline)) void operator delete(void * p, size_t) noexcept { free(p); }
+__attribute__((noinline)) void operator delete[](void * p, size_t) noexcept { free(p); }
+
+//-----------------------------------------------------------------------------
+class cBenchSkinConfig : public GLCD::cSkinConfig
+{
+private:
+    GLCD::cDriver * mDriver;
+    std::string mSkinPath;
+public:
+    cBenchSkinConfig(GLCD::cDriver * Driver, const std::string & SkinPath) : mDriver(Driver), mSkinPath(SkinPath) {}
+    virtual std::string SkinPath(void) { return mSkinPath; }
+    virtual std::string CharSet(void) { return "iso8859-15"; }
+    virtual std::string Translate(const std::string & Text) { return Text; }
+    virtual GLCD::cType GetToken(const GLCD::tSkinToken & Token) { return 10; }
+    virtual GLCD::cDriver * GetDriver(void) const { return mDriver; }
+};
+
+//-----------------------------------------------------------------------------
+// time and allocations of a workload or a part of it
+struct tResult
+{
+    uint64_t ns;
+    uint64_t allocs;
+    uint64_t bytes;
+
+    tResult() : ns(0), allocs(0), bytes(0) {}
+};
+
+class cMeasure
+{
+private:
+    struct timespec start;
+    uint64_t allocs;
+    uint64_t bytes;
+public:
+    cMeasure() { allocs = allocCount; bytes = allocBytes; clock_gettime(CLOCK_MONOTONIC, &start); }
+    void AddTo(tResult & result) const
+    {
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        result.ns += (now.tv_sec - start.tv_sec) * 1000000000ULL + now.tv_nsec - start.tv_nsec;
+        result.allocs += allocCount - allocs;
+        result.bytes += allocBytes - bytes;
+    }
+};
+
+//-----------------------------------------------------------------------------
+void usage()
+{
+    fprintf(stdout, "\n");
+    fprintf(stdout, "%s v%s\n", prgname, version);
+    fprintf(stdout, "%s measures the rendering of skins and drawing primitives.\n", prgname);
+    fprintf(stdout, "\n");
+    fprintf(stdout, "  Usage: %s [-s SKIN [-D DISPLAY]] [-w WORKLOADS] [-f FONT [-z SIZE]]\n", prgname);
+    fprintf(stdout, "         [-x WIDTH] [-y HEIGHT] [-n FRAMES] [-p FORMAT] [-e DRIVER] [-m]\n\n");
+    fprintf(stdout, "  -s  --skin        skin file to render\n");
+    fprintf(stdout, "  -D  --display     display of the skin (default: normal)\n");
+    fprintf(stdout, "  -w  --workload    comma separated list of synthetic workloads (default: all\n");
+    fprintf(stdout, "                    if no skin is given): fill, lines, text, image, alpha\n");
+    fprintf(stdout, "  -f  --font        font of the text workload (*.fnt or a TrueType font)\n");
+    fprintf(stdout, "  -z  --size        size of a TrueType font (default: %d)\n", kDefaultFontSize);
+    fprintf(stdout, "  -x  --width       width of the screen (default: %d)\n", kDefaultWidth);
+    fprintf(stdout, "  -y  --height      height of the screen (default: %d)\n", kDefaultHeight);
+    fprintf(stdout, "  -n  --frames      number of rendered frames (default: %d)\n", kDefaultFrames);
+    fprintf(stdout, "  -p  --format      pixel format of the screen: argb, mono, grey4, rgb565 (default: argb)\n");
+    fprintf(stdout, "  -e  --emulate     driver run on recorded ports, adds the simulated bus time of\n");
+    fprintf(stdout, "                    the transfers as part 'bus' (eg. t6963c, sed1330)\n");
+    fprintf(stdout, "  -m  --machine     print the results as CSV\n");
+    fprintf(stdout, "\n" );
+    fprintf(stdout, "  example: %s -s test.skin -n 500 -m\n", prgname);
+    fprintf(stdout, "\n" );
+} // usage()
+
+//-----------------------------------------------------------------------------
+// the synthetic workloads draw a frame depending on its number
+
+static void DrawFill(GLCD::cBitmap * screen, int frame)
+{
+    int w = screen->Width();
+    int h = screen->Height();
+
+    for (int i = 0; i < 8; i++)
+    {
+        int x = (frame * 3 + i * w / 8) % w;
+        int y = (frame + i * 5) % h;
+        screen->DrawRectangle(x, y, x + w / 4, y + h / 4, (i & 1) ? GLCD::cColor::White : GLCD::cColor::Red, true);
+        screen->DrawRoundRectangle(w - 1 - x, y, w - 1 - x - w / 6, y + h / 3, GLCD::cColor::Cyan, true, 3);
+    }
+    screen->DrawEllipse(w / 4, h / 4, w * 3 / 4, h * 3 / 4, GLCD::cColor::Yellow, true, 0);
+} // DrawFill()
+
+static void DrawLines(GLCD::cBitmap * screen, int frame)
+{
+    int w = screen->Width();
+    int h = screen->Height();
+
+    for (int i = 0; i < 32; i++)
+    {
+        int x = (frame + i * 7) % w;
+        screen->DrawLine(x, 0, w - 1 - x, h - 1, GLCD::cColor::White);
+        screen->DrawHLine(0, (frame + i) % h, w - 1, GLCD::cColor::Green);
+        screen->DrawVLine(x, 0, h - 1, GLCD::cColor::Blue);
+    }
+    screen->DrawRectangle(1, 1, w - 2, h - 2, GLCD::cColor::White, false);
+    screen->DrawEllipse(2, 2, w - 3, h - 3, GLCD::cColor::Magenta, false, 0);
+} // DrawLines()
+
+static void DrawText(GLCD::cBitmap * screen, int frame, const GLCD::cFont * font)
+{
+    static const char * kText = "The quick brown fox jumps over the lazy dog 0123456789";
+    int lineHeight = std::max(font->LineHeight(), 1);
+
+    for (int y = 0; y < screen->Height(); y += lineHeight)
+    {
+        int skip = (frame + y) % 64;
+        screen->DrawText(0, y, screen->Width() - 1, kText, font, GLCD::cColor::White, GLCD::cColor::Black, true, skip);
+    }
+} // DrawText()
+
+static void DrawImage(GLCD::cBitmap * screen, int frame, const GLCD::cBitmap & image)
+{
+    int w = screen->Width();
+    int h = screen->Height();
+
+    for (int i = 0; i < 4; i++)
+        screen->DrawBitmap((frame * 2 + i * w / 4) % w - image.Width() / 2, (frame + i * 9) % h - image.Height() / 2, image);
+} // DrawImage()
+
+static void DrawAlpha(GLCD::cBitmap * screen, int frame, const GLCD::cBitmap & image)
+{
+    int w = screen->Width();
+    int h = screen->Height();
+
+    for (int i = 0; i < 8; i++)
+    {
+        int x = (frame * 3 + i * w / 8) % w;
+        screen->DrawRectangle(x, 0, x + w / 3, h - 1, 0x80FF8000 | (i * 0x101010), true);
+    }
+    screen->DrawBitmap((frame % w) - image.Width() / 2, h / 4, image, GLCD::cColor::White, GLCD::cColor::Black, 128);
+} // DrawAlpha()
+
+// image with an alpha gradient and a transparent border
+static GLCD::cBitmap * CreateImage(void)
+{
+    const int w = 48;
+    const int h = 32;
+    GLCD::cBitmap * image = new GLCD::cBitmap(w, h, (uint32_t) GLCD::cColor::Transparent);
+
+    image->SetProcessAlpha(false);
+    for (int y = 2; y < h - 2; y++)
+        for (int x = 2; x < w - 2; x++)
+            image->DrawPixel(x, y, ((x * 255 / w) << 24) | ((y * 255 / h) << 8) | 0x0000FF);
+    return image;
+} // CreateImage()
+
+//-----------------------------------------------------------------------------
+static void PrintHeader(bool machine)
+{
+    if (machine)
+        fprintf(stdout, "workload,part,frames,ns_per_frame,allocs_per_frame,bytes_per_frame\n");
+    else
+        fprintf(stdout, "%-10s %-14s %8s %12s %12s %12s\n", "workload", "part", "frames", "ns/frame", "allocs/frame", "bytes/frame");
+} // PrintHeader()
+
+static void PrintResult(bool machine, const std::string & workload, const std::string & part, int frames, const tResult & result)
+{
+    if (machine)
+        fprintf(stdout, "%s,%s,%d,%.0f,%.2f,%.0f\n", workload.c_str(), part.c_str(), frames,
+                (double) result.ns / frames, (double) result.allocs / frames, (double) result.bytes / frames);
+    else
+        fprintf(stdout, "%-10s %-14s %8d %12.0f %12.2f %12.0f\n", workload.c_str(), part.c_str(), frames,
+                (double) result.ns / frames, (double) result.allocs / frames, (double) result.bytes / frames);
+} // PrintResult()
+
+// simulated bus time of a loopback driver so far
+static uint64_t BusTime(const GLCD::cDriver * lcd)
+{
+    GLCD::tDriverStats stats;
+    if (!lcd->GetStats(stats))
+        return 0;
+    return stats.setScreenTime + stats.refreshTime;
+} // BusTime()
+
+// transfers the screen to the driver, the way an application does
+static void Transfer(GLCD::cDriver * lcd, GLCD::cBitmap * screen)
+{
+    if (screen->Format() == GLCD::pfMono)
+        lcd->SetScreen1BPP(screen->Pixels(), screen->Width(), screen->Height(), screen->LineSize());
+    else if (screen->Data())
+        lcd->SetScreenRects(screen->Data(), screen->Width(), screen->Height(), screen->Damage());
+    else
+    {
+        // no transfer of the other native formats to the drivers
+    }
+    screen->ResetDamage();
+    lcd->Refresh(false);
+} // Transfer()
+
+//-----------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+    static struct option long_options[] =
+    {
+        {"skin",       required_argument, NULL, 's'},
+        {"display",    required_argument, NULL, 'D'},
+        {"workload",   required_argument, NULL, 'w'},
+        {"font",       required_argument, NULL, 'f'},
+        {"size",       required_argument, NULL, 'z'},
+        {"width",      required_argument, NULL, 'x'},
+        {"height",     required_argument, NULL, 'y'},
+        {"frames",     required_argument, NULL, 'n'},
+        {"format",     required_argument, NULL, 'p'},
+        {"emulate",    required_argument, NULL, 'e'},
+        {"machine",          no_argument, NULL, 'm'},
+        {NULL}
+    };
+
+    std::string skinFileName = "";
+    std::string displayName = "normal";
+    std::string workloads = "";
+    std::string fontFileName = "";
+    int fontSize = kDefaultFontSize;
+    int width = kDefaultWidth;
+    int height = kDefaultHeight;
+    int frames = kDefaultFrames;
+    int format = 0;
+    std::string emulate = "";
+    bool machine = false;
+
+    int c, option_index = 0;
+    while ((c = getopt_long(argc, argv, "s:D:w:f:z:x:y:n:p:e:m", long_options, &option_index)) != -1)
+    {
+        switch (c)
+        {
+            case 's':
+                skinFileName = optarg;
+                break;
+
+            case 'D':
+                displayName = optarg;
+                break;
+
+            case 'w':
+                workloads = optarg;
+                break;
+
+            case 'f':
+                fontFileName = optarg;
+                break;
+
+            case 'z':
+                fontSize = atoi(optarg);
+                break;
+
+            case 'x':
+                width = atoi(optarg);
+                break;
+
+            case 'y':
+                height = atoi(optarg);
+                break;
+
+            case 'n':
+                frames = atoi(optarg);
+                break;
+
+            case 'p':
+                for (format = 0; format < 4; format++)
+                    if (strcmp(optarg, kFormatNames[format]) == 0)
+                        break;
+                if (format == 4)
+                {
+                    fprintf(stderr, "ERROR: Unknown pixel format %s!\n", optarg);
+                    return 1;
+                }
+                break;
+
+            case 'e':
+                emulate = optarg;
+                break;
+
+            case 'm':
+                machine = true;
+                break;
+
+            default:
+                usage();
+                return 1;
+        } // switch
+    } // while
+
+    if (width <= 0 || height <= 0 || frames <= 0 || fontSize <= 0)
+    {
+        usage();
+        return 1;
+    } // if
+
+    if (workloads.length() == 0 && skinFileName.length() == 0)
+    {
+        for (int i = 0; i < kNumWorkloads; i++)
+            workloads += std::string(i ? "," : "") + kWorkloads[i];
+    } // if
+
+    GLCD::cDriverConfig driverConfig;
+    driverConfig.name = "bench";
+    driverConfig.driver = "loopback";
+    driverConfig.width = width;
+    driverConfig.height = height;
+    if (emulate.length() > 0)
+    {
+        GLCD::tOption option;
+        option.name = "Emulate";
+        option.value = emulate;
+        driverConfig.options.push_back(option);
+    }
+    GLCD::cDriverLoopback lcd(&driverConfig);
+    if (lcd.Init() != 0)
+    {
+        fprintf(stderr, "ERROR: Failed initializing driver %s!\n", emulate.length() ? emulate.c_str() : "loopback");
+        return 2;
+    }
+    // an emulated driver may not support the requested size
+    width = lcd.Width();
+    height = lcd.Height();
+
+    GLCD::cBitmap * screen;
+    if (kFormats[format] == GLCD::pfARGB32)
+        screen = new GLCD::cBitmap(width, height);
+    else
+        screen = new GLCD::cBitmap(width, height, kFormats[format]);
+
+    GLCD::cFont font;
+    bool haveFont = false;
+    if (fontFileName.length() > 0)
+    {
+        if (fontFileName.length() > 4 && fontFileName.compare(fontFileName.length() - 4, 4, ".fnt") == 0)
+            haveFont = font.LoadFNT(fontFileName);
+        else
+            haveFont = font.LoadFT2(fontFileName, "UTF-8", fontSize);
+        if (!haveFont)
+        {
+            fprintf(stderr, "ERROR: Failed loading font %s!\n", fontFileName.c_str());
+            return 2;
+        }
+    } // if
+
+    GLCD::cBitmap * image = CreateImage();
+
+    if (!machine)
+        fprintf(stdout, "%dx%d %s, %d frames\n\n", width, height, kFormatNames[format], frames);
+    PrintHeader(machine);
+
+    // synthetic workloads
+    size_t pos = 0;
+    while (pos < workloads.length())
+    {
+        size_t end = workloads.find(',', pos);
+        if (end == std::string::npos)
+            end = workloads.length();
+        std::string name = workloads.substr(pos, end - pos);
+        pos = end + 1;
+
+        int id;
+        for (id = 0; id < kNumWorkloads; id++)
+            if (name == kWorkloads[id])
+                break;
+        if (id == kNumWorkloads)
+        {
+            fprintf(stderr, "ERROR: Unknown workload %s!\n", name.c_str());
+            return 1;
+        }
+        if (name == "text" && !haveFont)
+        {
+            fprintf(stderr, "WARNING: Workload text needs a font (-f), skipped.\n");
+            continue;
+        }
+
+        tResult render;
+        tResult transfer;
+        tResult bus;
+        tResult warmup;
+        for (int n = -1; n < frames; n++)
+        {
+            // the first frame warms up caches and is not counted
+            tResult & total = (n < 0) ? warmup : render;
+            int frame = std::max(n, 0);
+            cMeasure measure;
+
+            screen->Clear(GLCD::cColor::Black);
+            switch (id)
+            {
+                case 0: DrawFill(screen, frame); break;
+                case 1: DrawLines(screen, frame); break;
+                case 2: DrawText(screen, frame, &font); break;
+                case 3: DrawImage(screen, frame, *image); break;
+                case 4: DrawAlpha(screen, frame, *image); break;
+            } // switch
+            measure.AddTo(total);
+
+            uint64_t busStart = BusTime(&lcd);
+            cMeasure measureTransfer;
+            Transfer(&lcd, screen);
+            measureTransfer.AddTo((n < 0) ? warmup : transfer);
+            if (n >= 0)
+                bus.ns += BusTime(&lcd) - busStart;
+        } // for
+        PrintResult(machine, name, "render", frames, render);
+        PrintResult(machine, name, "transfer", frames, transfer);
+        if (emulate.length() > 0)
+            PrintResult(machine, name, "bus", frames, bus);
+    } // while
+
+    // skin, timed per type of the objects of the display
+    if (skinFileName.length() > 0)
+    {
+        std::string skinPath = ".";
+        size_t slash = skinFileName.rfind('/');
+        if (slash != std::string::npos)
+            skinPath = skinFileName.substr(0, slash);
+
+        cBenchSkinConfig skinConfig(&lcd, skinPath);
+        GLCD::cSkin * skin = GLCD::XmlParse(skinConfig, "bench", skinFileName);
+        if (!skin)
+        {
+            fprintf(stderr, "ERROR: Failed loading skin %s!\n", skinFileName.c_str());
+            return 2;
+        }
+        skin->SetBaseSize(width, height);
+        GLCD::cSkinDisplay * display = skin->GetDisplay(displayName);
+        if (!display)
+        {
+            fprintf(stderr, "ERROR: Display %s not found in skin %s!\n", displayName.c_str(), skinFileName.c_str());
+            delete skin;
+            return 2;
+        }
+
+        // the results of each object type and the slot of each object are set up before
+        // measuring, so that the map does not allocate inside the measured render
+        std::map<std::string, tResult> objects;
+        std::vector<tResult *> objectSlots;
+        for (uint32_t i = 0; i < display->NumObjects(); i++)
+            objectSlots.push_back(&objects[display->GetObject(i)->TypeName()]);
+        std::vector<tResult> frameObjects(objectSlots.size());
+        tResult render;
+        tResult transfer;
+        tResult bus;
+        for (int n = -1; n < frames; n++)
+        {
+            tResult frameRender;
+            for (size_t i = 0; i < frameObjects.size(); i++)
+                frameObjects[i] = tResult();
+            cMeasure measure;
+
+            screen->Clear();
+            for (uint32_t i = 0; i < display->NumObjects(); i++)
+            {
+                GLCD::cSkinObject * object = display->GetObject(i);
+                cMeasure measureObject;
+                object->Render(screen);
+                measureObject.AddTo(frameObjects[i]);
+            }
+            measure.AddTo(frameRender);
+
+            uint64_t busStart = BusTime(&lcd);
+            cMeasure measureTransfer;
+            Transfer(&lcd, screen);
+            if (n < 0)
+                continue;
+            measureTransfer.AddTo(transfer);
+            bus.ns += BusTime(&lcd) - busStart;
+
+            render.ns += frameRender.ns;
+            render.allocs += frameRender.allocs;
+            render.bytes += frameRender.bytes;
+            for (size_t i = 0; i < frameObjects.size(); i++)
+            {
+                objectSlots[i]->ns += frameObjects[i].ns;
+                objectSlots[i]->allocs += frameObjects[i].allocs;
+                objectSlots[i]->bytes += frameObjects[i].bytes;
+            }
+        } // for
+        PrintResult(machine, "skin", "render", frames, render);
+        for (std::map<std::string, tResult>::iterator it = objects.begin(); it != objects.end(); it++)
+            PrintResult(machine, "skin", it->first, frames, it->second);
+        PrintResult(machine, "skin", "transfer", frames, transfer);
+        if (emulate.length() > 0)
+            PrintResult(machine, "skin", "bus", frames, bus);
+
+        delete skin;
+    } // if
+
+    lcd.DeInit();
+    delete image;
+    delete screen;
+    return 0;
+} // main()